@@ -26,6 +26,7 @@
 #include "ct_image.h"
 #include "ct_table.h"
 #include "ct_main_win.h"
+#include "ct_code_runner.h"
 #include "ct_types.h"
 #include <optional>
 
@@ -51,9 +52,19 @@ private:
     CtDialogs::CtLinkEntry _link_entry;
 
 private:
-    size_t                          _next_opened_emb_file_id{1};
-    std::map<Glib::ustring, time_t> _embfiles_opened;
-    sigc::connection                _embfiles_timeout_connection;
+    struct CtEmbFileOpened
+    {
+        gint64                         nodeId;
+        size_t                         embfileId;
+        Glib::RefPtr<Gio::FileMonitor> rFileMonitor;
+        sigc::connection               debounceConnection; // the changes are applied once the writes settle
+    };
+    size_t                                   _next_opened_emb_file_id{1};
+    std::map<std::string, CtEmbFileOpened>   _embfiles_opened;
+
+private:
+    int                                      _codeRunsCounter{0};
+    std::list<std::unique_ptr<CtCodeRun>>    _codeRuns;
 
 private:
     CtMainWin*   _pCtMainWin;
@@ -72,6 +83,7 @@ public: // todo: fix naming
     bool          _is_there_selected_node_or_error();
     bool          _is_tree_not_empty_or_error();
     bool          _is_curr_node_not_read_only_or_error();
+    bool          _is_no_paste_in_progress_or_error();
     bool          _is_curr_node_not_syntax_highlighting_or_error(bool plain_text_ok = false);
     bool          _is_there_text_selection_or_error();
 
@@ -149,10 +161,12 @@ private:
     bool                _parse_node_content_iter(const CtTreeIter& tree_iter, Glib::RefPtr<Gtk::TextBuffer> text_buffer, const std::string& pattern,
                                                 bool forward, bool first_fromsel, bool all_matches, bool first_node);
     Gtk::TextIter       _get_inner_start_iter(Glib::RefPtr<Gtk::TextBuffer> text_buffer, bool forward, const gint64& node_id);
+    void                _search_time_prefilter();
+    void                _search_index_prefilter(const Glib::ustring& pattern);
+    bool                _is_node_search_candidate(const CtTreeIter& node_iter);
     bool                _is_node_within_time_filter(const CtTreeIter& node_iter);
     bool                _find_pattern(CtTreeIter tree_iter, Glib::RefPtr<Gtk::TextBuffer> text_buffer, std::string pattern,
                                       Gtk::TextIter start_iter, bool forward, bool all_matches);
-    std::string         _get_line_content(Glib::RefPtr<Gtk::TextBuffer> text_buffer, Gtk::TextIter text_iter);
     std::string         _get_first_line_content(Glib::RefPtr<Gtk::TextBuffer> text_buffer);
     Glib::ustring       _check_pattern_in_object(Glib::RefPtr<Glib::Regex> pattern, CtAnchoredWidget* obj);
     std::pair<int, int> _check_pattern_in_object_between(Glib::RefPtr<Gtk::TextBuffer> text_buffer, Glib::RefPtr<Glib::Regex> pattern,
@@ -167,6 +181,7 @@ public:
     void find_in_all_nodes()             { _find_in_all_nodes(false); }
     void find_in_sel_node_and_subnodes() { _find_in_all_nodes(true); }
     void find_a_node();
+    void find_a_node_filter();
     void find_again();
     void find_back();
     void replace_in_selected_node();
@@ -283,7 +298,8 @@ public:
 private:
     // helper for others actions
     void _anchor_edit_dialog(CtImageAnchor* anchor, Gtk::TextIter insert_iter, Gtk::TextIter* iter_bound);
-    bool _on_embfiles_sentinel_timeout();
+    void _on_embfile_monitor_changed(const std::string& filepath, Gio::FileMonitorEvent event_type);
+    void _embfile_update_from_disk(const std::string& filepath);
 
 public:
     // others actions
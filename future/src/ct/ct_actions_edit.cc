@@ -41,9 +41,7 @@ void CtActions::requested_step_back()
     if (!_pCtMainWin->curr_tree_iter()) return;
     if (not _is_curr_node_not_read_only_or_error()) return;
 
-    auto step_back = _pCtMainWin->get_state_machine().requested_state_previous(_pCtMainWin->curr_tree_iter().get_node_id());
-    if (step_back)
-        _pCtMainWin->load_buffer_from_state(step_back, _pCtMainWin->curr_tree_iter());
+    _pCtMainWin->get_state_machine().requested_step_back(_pCtMainWin->curr_tree_iter());
 }
 
 // Step Ahead for the Current Node, if Possible
@@ -52,9 +50,7 @@ void CtActions::requested_step_ahead()
     if (!_pCtMainWin->curr_tree_iter()) return;
     if (not _is_curr_node_not_read_only_or_error()) return;
 
-    auto step_ahead = _pCtMainWin->get_state_machine().requested_state_subsequent(_pCtMainWin->curr_tree_iter().get_node_id());
-    if (step_ahead)
-        _pCtMainWin->load_buffer_from_state(step_ahead, _pCtMainWin->curr_tree_iter());
+    _pCtMainWin->get_state_machine().requested_step_ahead(_pCtMainWin->curr_tree_iter());
 }
 
 // Insert/Edit Image
@@ -84,12 +80,12 @@ void CtActions::table_handle()
 
     int col_min = _pCtMainWin->get_ct_config()->tableColMin;
     int col_max = _pCtMainWin->get_ct_config()->tableColMin;
-    std::list<std::vector<std::string>> rows;
+    CtTableMatrix tableMatrix;
     if (res == 1) {
-        rows.push_back(std::vector<std::string>(_pCtMainWin->get_ct_config()->tableColumns, "click me"));
-        std::vector<std::string> empty_row(_pCtMainWin->get_ct_config()->tableColumns, "");
-        while (rows.size() < _pCtMainWin->get_ct_config()->tableRows)
-            rows.push_back(empty_row);
+        tableMatrix.push_back(CtTableRow(_pCtMainWin->get_ct_config()->tableColumns, "click me"));
+        CtTableRow empty_row(_pCtMainWin->get_ct_config()->tableColumns, "");
+        while (tableMatrix.size() < _pCtMainWin->get_ct_config()->tableRows)
+            tableMatrix.push_back(empty_row);
     }
     if (res == 2) {
         CtDialogs::file_select_args args = {.pParentWin=_pCtMainWin, .curr_folder=_pCtMainWin->get_ct_config()->pickDirCsv,
@@ -97,37 +93,23 @@ void CtActions::table_handle()
         Glib::ustring filename = CtDialogs::file_select_dialog(args);
         if (filename.empty()) return;
         _pCtMainWin->get_ct_config()->pickDirCsv = Glib::path_get_dirname(filename);
-        // todo: find good csv lib
-        std::ifstream file(filename);
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line == "\r\n" || line == "\n\r" || line == "\n")
-                continue;
-            std::vector<std::string> splited_line = str::split(line, ",");
-            for (std::string& word: splited_line)
-                if (str::startswith(word, "\"") && str::endswith(word, "\""))
-                    word = word.substr(1, word.size() - 2);
-            rows.push_back(splited_line);
-        }
+        std::ifstream file(filename, std::ios::binary);
         size_t col_num = 0;
-        for (auto& row: rows)
+        CtCSV::read_rows(file, [&](std::vector<Glib::ustring>& row) {
             col_num = std::max(col_num, row.size());
-        for (auto& row: rows)
-            while (row.size() < col_num)
-                row.push_back("");
+            tableMatrix.push_back(std::move(row));
+        });
+        if (tableMatrix.empty()) {
+            CtDialogs::error_dialog(str::format(_("Error Parsing the CSV File %s"), std::string(filename)), *_pCtMainWin);
+            return;
+        }
+        for (auto& row: tableMatrix)
+            row.resize(col_num);
         col_min = 40;
         col_max = 60;
     }
 
-    CtTableMatrix tableMatrix;
-    for(auto& row: rows)
-    {
-        tableMatrix.push_back(CtTableRow{});
-        for (auto& cell: row)
-            tableMatrix.back().push_back(new CtTableCell(_pCtMainWin, cell, CtConst::TABLE_CELL_TEXT_ID));
-    }
-
-    CtTable* pCtTable = new CtTable(_pCtMainWin, tableMatrix, col_min, col_max, true, _curr_buffer()->get_insert()->get_iter().get_offset(), "");
+    CtTable* pCtTable = new CtTable(_pCtMainWin, std::move(tableMatrix), col_min, col_max, true, _curr_buffer()->get_insert()->get_iter().get_offset(), "");
     Glib::RefPtr<Gsv::Buffer> gsv_buffer = Glib::RefPtr<Gsv::Buffer>::cast_dynamic(_curr_buffer());
     pCtTable->insertInTextBuffer(gsv_buffer);
 
@@ -197,7 +179,7 @@ void CtActions::embfile_insert()
     std::vector<char> buffer(std::istreambuf_iterator<char>(file), {});
     file.close();
 
-    auto blob = std::string(buffer.data(), buffer.size());
+    auto blob = std::make_shared<CtEmbFileBlob>(std::string(buffer.data(), buffer.size()));
     std::string name = Glib::path_get_basename(filepath);
     CtAnchoredWidget* pAnchoredWidget = new CtImageEmbFile(_pCtMainWin, name, blob, std::time(nullptr), iter_insert.get_offset(), "");
     Glib::RefPtr<Gsv::Buffer> gsv_buffer = Glib::RefPtr<Gsv::Buffer>::cast_dynamic(_curr_buffer());
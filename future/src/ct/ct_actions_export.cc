@@ -64,6 +64,7 @@ void CtActions::export_to_ctd()
 void CtActions::_export_print(bool save_to_pdf, Glib::ustring auto_path, bool auto_overwrite)
 {
     if (!_is_there_selected_node_or_error()) return;
+    if (!_is_no_paste_in_progress_or_error()) return;
     auto export_type = auto_path != "" ? CtDialogs::CtProcessNode::ALL_TREE
                                        : CtDialogs::selnode_selnodeandsub_alltree_dialog(*_pCtMainWin, true, &_export_options.include_node_name,
                                                                                          &_export_options.new_node_page, nullptr);
@@ -124,6 +125,7 @@ void CtActions::_export_print(bool save_to_pdf, Glib::ustring auto_path, bool au
 void CtActions::_export_to_html(Glib::ustring auto_path, bool auto_overwrite)
 {
     if (!_is_there_selected_node_or_error()) return;
+    if (!_is_no_paste_in_progress_or_error()) return;
     auto export_type = auto_path != "" ? CtDialogs::CtProcessNode::ALL_TREE
                                        : CtDialogs::selnode_selnodeandsub_alltree_dialog(*_pCtMainWin, true, &_export_options.include_node_name,
                                                                                          nullptr, &_export_options.index_in_page);
@@ -135,7 +137,7 @@ void CtActions::_export_to_html(Glib::ustring auto_path, bool auto_overwrite)
     {
         Glib::ustring folder_name = CtMiscUtil::get_node_hierarchical_name(_pCtMainWin->curr_tree_iter());
         if (export2html.prepare_html_folder("", folder_name, false, ret_html_path))
-            export2html.node_export_to_html(_pCtMainWin->curr_tree_iter(), _export_options, "", -1, -1);
+            export2html.node_export_to_html(_pCtMainWin->curr_tree_iter(), _export_options, false/*with_index*/, -1, -1);
     }
     else if (export_type == CtDialogs::CtProcessNode::CURRENT_NODE_AND_SUBNODES)
     {
@@ -157,7 +159,7 @@ void CtActions::_export_to_html(Glib::ustring auto_path, bool auto_overwrite)
 
         Glib::ustring folder_name = CtMiscUtil::get_node_hierarchical_name(_pCtMainWin->curr_tree_iter());
         if (export2html.prepare_html_folder("", folder_name, false, ret_html_path))
-            export2html.node_export_to_html(_pCtMainWin->curr_tree_iter(), _export_options, "", iter_start.get_offset(), iter_end.get_offset());
+            export2html.node_export_to_html(_pCtMainWin->curr_tree_iter(), _export_options, false/*with_index*/, iter_start.get_offset(), iter_end.get_offset());
     }
     if (!ret_html_path.empty())
        CtFileSystem::external_folderpath_open(ret_html_path);
@@ -167,6 +169,7 @@ void CtActions::_export_to_html(Glib::ustring auto_path, bool auto_overwrite)
 void CtActions::_export_to_txt(bool is_single, Glib::ustring auto_path, bool auto_overwrite)
 {
     if (!_is_there_selected_node_or_error()) return;
+    if (!_is_no_paste_in_progress_or_error()) return;
     CtDialogs::CtProcessNode export_type;
     if (auto_path != "")
     {
@@ -39,6 +39,8 @@ void CtActions::_file_save(const bool run_vacuum)
             if ( _is_tree_not_empty_or_error() and
                  _file_write(doc_filepath, _pCtMainWin->get_curr_doc_password(), false/*firstWrite*/, nullptr/*ppReturnCtSQLite*/, run_vacuum) )
             {
+                _pCtMainWin->curr_tree_store().search_index_after_save(doc_filepath,
+                                                                       CtDocEncrypt::False == CtMiscUtil::get_doc_encrypt(doc_filepath));
                 _pCtMainWin->update_window_save_not_needed();
                 _pCtMainWin->get_state_machine().update_state();
             }
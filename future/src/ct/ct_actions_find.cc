@@ -75,8 +75,66 @@ struct SearchState {
     Glib::RefPtr<CtMatchDialogStore> match_store;
     std::string   match_dialog_title;
 
+    bool                       index_filter_on = false;
+    std::unordered_set<gint64> index_candidates;
+    bool                       time_filter_on = false;
+    std::unordered_set<gint64> time_candidates;  // nodes within the time filter
+
+    std::unordered_map<gint64, std::string> hier_names;  // node id to hierarchical name, leaf to root
+    gint64              lines_node_id = -1;              // node of the line starts below
+    std::vector<int>    lines_starts;                    // symbol offsets of the lines starts in the searched text
+    std::vector<size_t> lines_starts_bytes;              // byte offsets of the same
+
 } s_state;
 
+static void _all_matches_reset()
+{
+    // a new store for each search, a dialog still open keeps the previous one and is not updated row by row
+    Glib::RefPtr<CtMatchDialogStore> prev_store = s_state.match_store;
+    s_state.match_store = CtMatchDialogStore::create();
+    s_state.match_store->dlg_size = prev_store->dlg_size;
+    s_state.match_store->dlg_pos = prev_store->dlg_pos;
+    s_state.hier_names.clear();
+    s_state.lines_node_id = -1;
+}
+
+// Same as CtMiscUtil::get_node_hierarchical_name(tree_iter, " << ", false, false) but reusing the fathers names
+static const std::string& _get_node_hier_name_cached(const CtTreeIter& tree_iter)
+{
+    const gint64 node_id = tree_iter.get_node_id();
+    auto it = s_state.hier_names.find(node_id);
+    if (it != s_state.hier_names.end()) return it->second;
+    std::string hier_name = str::trim(tree_iter.get_node_name());
+    CtTreeIter father_iter = tree_iter.parent();
+    if (father_iter) hier_name += " << " + _get_node_hier_name_cached(father_iter);
+    return s_state.hier_names[node_id] = hier_name;
+}
+
+// Fill the table of the lines starts of the given text, to get line number and content of many matches
+static void _set_lines_starts(const gint64 node_id, const Glib::ustring& text)
+{
+    s_state.lines_node_id = node_id;
+    s_state.lines_starts.assign(1, 0);
+    s_state.lines_starts_bytes.assign(1, 0);
+    const std::string& raw = text.raw();
+    int symb_pos = 0;
+    for (size_t byte_pos = 0; byte_pos < raw.size(); ++byte_pos) {
+        const unsigned char ch = static_cast<unsigned char>(raw[byte_pos]);
+        if ((ch & 0xC0) == 0x80) continue; // utf-8 continuation byte
+        ++symb_pos;
+        if (ch == CtConst::CHAR_NEWLINE[0]) {
+            s_state.lines_starts.push_back(symb_pos);
+            s_state.lines_starts_bytes.push_back(byte_pos + 1);
+        }
+    }
+}
+
+// Index of the line containing the given symbol offset
+static size_t _get_line_idx(const int symb_offset)
+{
+    return std::upper_bound(s_state.lines_starts.begin(), s_state.lines_starts.end(), symb_offset) - s_state.lines_starts.begin() - 1;
+}
+
 void CtActions::_find_init()
 {
     s_state.match_store = CtMatchDialogStore::create();
@@ -129,7 +187,7 @@ void CtActions::find_in_selected_node()
     _pCtMainWin->user_active() = false;
 
     if (all_matches) {
-        s_state.match_store->clear();
+        _all_matches_reset();
         s_state.all_matches_first_in_node = true;
         while (_parse_node_content_iter(_pCtMainWin->curr_tree_iter(), curr_buffer, pattern, forward, first_fromsel, all_matches, true))
             s_state.matches_num += 1;
@@ -198,6 +256,7 @@ void CtActions::_find_in_all_nodes(bool for_current_node)
     }
     bool first_fromsel = s_options.search_replace_dict_a_ff_fa == 1;
     bool all_matches = s_options.search_replace_dict_a_ff_fa == 0;
+    if (all_matches && !_is_no_paste_in_progress_or_error()) return; // the progress and stop button are the paste ones
     if (first_fromsel || for_current_node) {
         s_state.first_useful_node = false; // no one node content was parsed yet
         node_iter = _pCtMainWin->curr_tree_iter();
@@ -207,7 +266,7 @@ void CtActions::_find_in_all_nodes(bool for_current_node)
         node_iter = forward ? _pCtMainWin->curr_tree_store().get_iter_first() : _pCtMainWin->curr_tree_store().get_tree_iter_last_sibling(_pCtMainWin->curr_tree_store().get_store()->children());
     }
     s_state.matches_num = 0;
-    if (all_matches) s_state.match_store->clear();
+    if (all_matches) _all_matches_reset();
 
     std::string tree_expanded_collapsed_string = _pCtMainWin->curr_tree_store().get_tree_expanded_collapsed_string(_pCtMainWin->curr_tree_view());
     // searching start
@@ -223,6 +282,8 @@ void CtActions::_find_in_all_nodes(bool for_current_node)
         ctStatusBar.set_progress_stop(false);
         while (gtk_events_pending()) gtk_main_iteration();
     }
+    _search_time_prefilter();
+    _search_index_prefilter(pattern);
     std::time_t search_start_time = std::time(nullptr);
     while (node_iter) {
         s_state.all_matches_first_in_node = true;
@@ -255,6 +316,10 @@ void CtActions::_find_in_all_nodes(bool for_current_node)
     }
     std::time_t search_end_time = std::time(nullptr);
     std::cout << search_end_time - search_start_time << " sec" << std::endl;
+    s_state.index_filter_on = false;
+    s_state.index_candidates.clear();
+    s_state.time_filter_on = false;
+    s_state.time_candidates.clear();
 
     _pCtMainWin->user_active() = user_active_restore;
     _pCtMainWin->curr_tree_store().set_tree_expanded_collapsed_string(tree_expanded_collapsed_string, _pCtMainWin->curr_tree_view(), _pCtMainWin->get_ct_config()->nodesBookmExp);
@@ -333,7 +398,7 @@ void CtActions::find_a_node()
 
     s_state.matches_num = 0;
     if (all_matches)
-        s_state.match_store->clear();
+        _all_matches_reset();
     // searching start
     while (node_iter) {
         if (_parse_node_name(_pCtMainWin->curr_tree_store().to_ct_tree_iter(node_iter), re_pattern, forward, all_matches)) {
@@ -366,6 +431,13 @@ void CtActions::find_a_node()
         _pCtMainWin->update_window_save_needed();
 }
 
+// Focus the as-you-type filter over the nodes names and tags
+void CtActions::find_a_node_filter()
+{
+    if (!_is_tree_not_empty_or_error()) return;
+    _pCtMainWin->tree_filter_grab_focus();
+}
+
 // Continue the previous search (a_node/in_selected_node/in_all_nodes)
 void CtActions::find_again()
 {
@@ -660,9 +732,9 @@ bool CtActions::_parse_node_name(CtTreeIter node_iter, Glib::RefPtr<Glib::Regex>
         if (all_matches) {
             gint64 node_id = node_iter.get_node_id();
             Glib::ustring node_name = node_iter.get_node_name();
-            Glib::ustring node_hier_name = CtMiscUtil::get_node_hierarchical_name(node_iter, " << ", false, false);
+            const std::string& node_hier_name = _get_node_hier_name_cached(node_iter);
             Glib::ustring line_content = _get_first_line_content(node_iter.get_node_text_buffer());
-            s_state.match_store->add_row(node_id, node_name, str::xml_escape(node_hier_name), 0, 0, 1, line_content);
+            s_state.match_store->add_pending_row(node_id, node_name, str::xml_escape(node_hier_name), 0, 0, 1, line_content);
         }
         if (s_state.replace_active && !node_iter.get_node_read_only()) {
             std::string replacer_text = s_options.search_replace_dict_replace;
@@ -671,6 +743,8 @@ bool CtActions::_parse_node_name(CtTreeIter node_iter, Glib::RefPtr<Glib::Regex>
             text_name = re_pattern->replace(text_name, 0, replacer_text, static_cast<Glib::RegexMatchFlags>(0));
             node_iter.set_node_name(text_name);
             node_iter.pending_edit_db_node_prop();
+            s_state.hier_names.clear(); // the descendants cached the old name too
+            _pCtMainWin->curr_tree_store().name_index_update_node(node_iter);
         }
         if (!all_matches) {
             _pCtMainWin->curr_tree_view().set_cursor_safe(node_iter);
@@ -697,18 +771,20 @@ bool CtActions::_parse_node_name(CtTreeIter node_iter, Glib::RefPtr<Glib::Regex>
 // Returns True if pattern was found, False otherwise
 bool CtActions::_parse_given_node_content(CtTreeIter node_iter, Glib::ustring pattern, bool forward, bool first_fromsel, bool all_matches)
 {
-    auto text_buffer = node_iter.get_node_text_buffer();
-    if (!s_state.first_useful_node) {
-        // first_fromsel plus first_node not already parsed
-        if (!_pCtMainWin->curr_tree_iter() || node_iter.get_node_id() == _pCtMainWin->curr_tree_iter().get_node_id()) {
-            s_state.first_useful_node = true; // a first_node was parsed
-            if (_parse_node_content_iter(node_iter, text_buffer, pattern, forward, first_fromsel, all_matches, true))
-                return true; // first_node node, first_fromsel
+    if (_is_node_search_candidate(node_iter)) {
+        auto text_buffer = node_iter.get_node_text_buffer();
+        if (!s_state.first_useful_node) {
+            // first_fromsel plus first_node not already parsed
+            if (!_pCtMainWin->curr_tree_iter() || node_iter.get_node_id() == _pCtMainWin->curr_tree_iter().get_node_id()) {
+                s_state.first_useful_node = true; // a first_node was parsed
+                if (_parse_node_content_iter(node_iter, text_buffer, pattern, forward, first_fromsel, all_matches, true))
+                    return true; // first_node node, first_fromsel
+            }
+        } else {
+            // not first_fromsel or first_fromsel with first_node already parsed
+            if (_parse_node_content_iter(node_iter, text_buffer, pattern, forward, first_fromsel, all_matches, false))
+                return true; // not first_node node
         }
-    } else {
-        // not first_fromsel or first_fromsel with first_node already parsed
-        if (_parse_node_content_iter(node_iter, text_buffer, pattern, forward, first_fromsel, all_matches, false))
-            return true; // not first_node node
     }
     // check for children
     if (!node_iter->children().empty()) {
@@ -801,6 +877,56 @@ Gtk::TextIter CtActions::_get_inner_start_iter(Glib::RefPtr<Gtk::TextBuffer> tex
     return start_iter;
 }
 
+// Compute the nodes that may contain the pattern, according to the search index
+void CtActions::_search_index_prefilter(const Glib::ustring& pattern)
+{
+    s_state.index_filter_on = false;
+    s_state.index_candidates.clear();
+    const std::vector<CtTrigramIndex::Trigram> trigrams = CtTrigramIndex::get_required_trigrams(
+        pattern, s_options.search_replace_dict_reg_exp, s_options.search_replace_dict_match_case);
+    if (trigrams.empty()) return; // pattern too short or not decomposable
+    CtTreeStore& ctTreeStore = _pCtMainWin->curr_tree_store();
+    if (ctTreeStore.search_index_update_missing() && !_pCtMainWin->get_file_save_needed()) {
+        // the index matches the document on disk, worth keeping
+        const std::string doc_filepath = _pCtMainWin->get_curr_doc_file_path();
+        if (!doc_filepath.empty() && CtDocEncrypt::False == CtMiscUtil::get_doc_encrypt(doc_filepath))
+            ctTreeStore.get_search_index().write_cache(doc_filepath);
+    }
+    s_state.index_candidates = ctTreeStore.get_search_index().get_candidates(trigrams);
+    s_state.index_filter_on = true;
+}
+
+// Collect the nodes within the time filter from the nodes metadata, loaded with the tree
+// for both the xml and sqlite documents and up to date with the unsaved changes,
+// so that the other nodes are skipped without loading their text
+void CtActions::_search_time_prefilter()
+{
+    s_state.time_filter_on = false;
+    s_state.time_candidates.clear();
+    if (!s_options.ts_cre_after.on && !s_options.ts_cre_before.on && !s_options.ts_mod_after.on && !s_options.ts_mod_before.on)
+        return;
+    CtTreeStore& ctTreeStore = _pCtMainWin->curr_tree_store();
+    ctTreeStore.get_store()->foreach_iter([this, &ctTreeStore](const Gtk::TreeIter& iter) {
+        CtTreeIter node_iter = ctTreeStore.to_ct_tree_iter(iter);
+        if (_is_node_within_time_filter(node_iter))
+            s_state.time_candidates.insert(node_iter.get_node_id());
+        return false; /* continue */
+    });
+    s_state.time_filter_on = true;
+}
+
+// Returns False only if the node surely does not contain the pattern
+bool CtActions::_is_node_search_candidate(const CtTreeIter& node_iter)
+{
+    const gint64 node_id = node_iter.get_node_id();
+    if (s_state.time_filter_on && !s_state.time_candidates.count(node_id))
+        return false; // never a match, do not load the text
+    if (!s_state.index_filter_on) return true;
+    if (_pCtMainWin->curr_tree_iter() && node_id == _pCtMainWin->curr_tree_iter().get_node_id())
+        return true; // may be under editing
+    return s_state.index_candidates.count(node_id) || !_pCtMainWin->curr_tree_store().get_search_index().is_node_indexed(node_id);
+}
+
 //"""Returns True if the given node_iter is within the Time Filter"""
 bool CtActions::_is_node_within_time_filter(const CtTreeIter& node_iter)
 {
@@ -883,18 +1009,33 @@ bool CtActions::_find_pattern(CtTreeIter tree_iter, Glib::RefPtr<Gtk::TextBuffer
     _pCtMainWin->get_text_view().set_selection_at_offset_n_delta(final_start_offset, final_delta_offset);
     // #print "OUT"
     auto mark_insert = text_buffer->get_insert();
-    Gtk::TextIter iter_insert = text_buffer->get_iter_at_mark(mark_insert);
     if (all_matches) {
         int newline_trick_offset = s_state.newline_trick ? 1 : 0;
         gint64 node_id = tree_iter.get_node_id();
         int start_offset = match_offsets.first + num_objs - newline_trick_offset;
         int end_offset = match_offsets.second + num_objs - newline_trick_offset;
         std::string node_name = tree_iter.get_node_name();
-        std::string node_hier_name = CtMiscUtil::get_node_hierarchical_name(tree_iter, " << ", false, false);
-        std::string line_content = obj_match_offsets.first != -1 ? obj_content : _get_line_content(text_buffer, iter_insert);
-        int line_num = text_buffer->get_iter_at_offset(start_offset).get_line();
+        const std::string& node_hier_name = _get_node_hier_name_cached(tree_iter);
+        std::string line_content;
+        int line_num;
+        if (obj_match_offsets.first != -1) {
+            // offsets of the buffer, not of the text
+            line_content = obj_content;
+            line_num = text_buffer->get_iter_at_offset(start_offset).get_line();
+        } else {
+            // the text is unchanged between the matches in the same node unless replacing
+            if (s_state.replace_active || s_state.lines_node_id != node_id)
+                _set_lines_starts(node_id, text);
+            line_num = (int)_get_line_idx(match_offsets.first - newline_trick_offset);
+            if (final_start_offset > 0) {
+                const size_t line_idx = _get_line_idx(match_offsets.first);
+                const size_t line_start = s_state.lines_starts_bytes[line_idx];
+                const size_t line_end = line_idx + 1 < s_state.lines_starts_bytes.size() ? s_state.lines_starts_bytes[line_idx + 1] - 1 : text.bytes();
+                line_content = text.raw().substr(line_start, line_end - line_start);
+            }
+        }
         if (!s_state.newline_trick) line_num += 1;
-        s_state.match_store->add_row(node_id, node_name, str::xml_escape(node_hier_name), start_offset, end_offset, line_num, line_content);
+        s_state.match_store->add_pending_row(node_id, node_name, str::xml_escape(node_hier_name), start_offset, end_offset, line_num, line_content);
         // #print line_num, self.matches_num
     } else {
         _pCtMainWin->get_text_view().scroll_to(mark_insert, CtTextView::TEXT_SCROLL_MARGIN);
@@ -927,9 +1068,9 @@ Glib::ustring CtActions::_check_pattern_in_object(Glib::RefPtr<Glib::Regex> patt
     }
     else if (CtTable* table = dynamic_cast<CtTable*>(obj))
     {
-        for (auto& row: table->get_table_matrix())
-            for (auto& col: row)
-                if (pattern->match(col->get_text_content()))
+        for (int row = 0; row < table->get_num_rows(); ++row)
+            for (int col = 0; col < table->get_num_columns(); ++col)
+                if (pattern->match(table->get_cell_text(row, col)))
                     return "<table>";
     }
     else if (CtCodebox* codebox = dynamic_cast<CtCodebox*>(obj))
@@ -990,23 +1131,6 @@ int CtActions::_get_num_objs_before_offset(Glib::RefPtr<Gtk::TextBuffer> text_bu
     return num_objs;
 }
 
-// Returns the Line Content Given the Text Iter
-std::string CtActions::_get_line_content(Glib::RefPtr<Gtk::TextBuffer> text_buffer, Gtk::TextIter text_iter)
-{
-    auto line_start = text_iter;
-    auto line_end = text_iter;
-    if (!line_start.backward_char()) return "";
-    while (line_start.get_char() != CtConst::CHAR_NEWLINE[0])
-        if (!line_start.backward_char())
-            break;
-    if (line_start.get_char() == CtConst::CHAR_NEWLINE[0])
-        line_start.forward_char();
-    while (line_end.get_char() != CtConst::CHAR_NEWLINE[0])
-        if (!line_end.forward_char())
-            break;
-    return text_buffer->get_text(line_start, line_end);
-}
-
 // Returns the First Not Empty Line Content Given the Text Buffer
 std::string CtActions::_get_first_line_content(Glib::RefPtr<Gtk::TextBuffer> text_buffer)
 {
@@ -126,7 +126,7 @@ void CtActions::embfile_save()
     if (filepath.empty()) return;
 
     _pCtMainWin->get_ct_config()->pickDirFile = Glib::path_get_dirname(filepath);
-    g_file_set_contents(filepath.c_str(), curr_file_anchor->get_raw_blob().c_str(), (gssize)curr_file_anchor->get_raw_blob().size(), nullptr);
+    curr_file_anchor->get_raw_blob()->write_to_file(filepath);
 }
 
 // Embedded File Open
@@ -145,18 +145,30 @@ void CtActions::embfile_open()
             CtConst::CHAR_MINUS + std::to_string(getpid())+
             CtConst::CHAR_MINUS + curr_file_anchor->get_file_name();
     Glib::ustring filepath = _pCtMainWin->get_ct_tmp()->getHiddenFilePath(filename);
-    std::fstream file(filepath, std::ios::out | std::ios::binary);
-    long size = (long)curr_file_anchor->get_raw_blob().size();
-    file.write(curr_file_anchor->get_raw_blob().c_str(), size);
-    file.close();
+    curr_file_anchor->get_raw_blob()->write_to_file(filepath);
 
     std::cout << "embfile_open " << filepath << std::endl;
 
     CtFileSystem::external_filepath_open(filepath, false);
-    _embfiles_opened[filepath] = CtFileSystem::getmtime(filepath);
 
-    if (not _embfiles_timeout_connection)
-        _embfiles_timeout_connection = Glib::signal_timeout().connect(sigc::mem_fun(*this, &CtActions::_on_embfiles_sentinel_timeout), 500);
+    CtEmbFileOpened& embFileOpened = _embfiles_opened[filepath];
+    embFileOpened.debounceConnection.disconnect();
+    embFileOpened.nodeId = _pCtMainWin->curr_tree_iter().get_node_id();
+    embFileOpened.embfileId = open_id;
+    try
+    {
+        embFileOpened.rFileMonitor = Gio::File::create_for_path(filepath)->monitor_file();
+        embFileOpened.rFileMonitor->signal_changed().connect([this, filepath](const Glib::RefPtr<Gio::File>&,
+                                                                              const Glib::RefPtr<Gio::File>&,
+                                                                              Gio::FileMonitorEvent event_type) {
+            _on_embfile_monitor_changed(filepath, event_type);
+        });
+    }
+    catch (Glib::Error& error)
+    {
+        std::cerr << "!! embfile monitor " << filepath << ": " << error.what() << std::endl;
+        _embfiles_opened.erase(filepath);
+    }
 }
 
 // Save to Disk the selected Image
@@ -424,8 +436,10 @@ void CtActions::exec_code()
     }();
     Glib::ustring code_exec_term = CtPrefDlg::get_code_exec_term_run(_pCtMainWin);
 
-    Glib::ustring filepath_src_tmp = _pCtMainWin->get_ct_tmp()->getHiddenFilePath("exec_code." + code_type_ext);
-    Glib::ustring filepath_bin_tmp = _pCtMainWin->get_ct_tmp()->getHiddenFilePath("exec_code.exe");
+    // every run has its own files, several runs can go on at the same time
+    const std::string run_id = std::to_string(++_codeRunsCounter);
+    Glib::ustring filepath_src_tmp = _pCtMainWin->get_ct_tmp()->getHiddenFilePath("exec_code_" + run_id + "." + code_type_ext);
+    Glib::ustring filepath_bin_tmp = _pCtMainWin->get_ct_tmp()->getHiddenFilePath("exec_code_" + run_id + ".exe");
     binary_cmd = str::replace(binary_cmd, CtConst::CODE_EXEC_TMP_SRC, filepath_src_tmp);
     binary_cmd = str::replace(binary_cmd, CtConst::CODE_EXEC_TMP_BIN, filepath_bin_tmp);
     Glib::ustring terminal_cmd = str::replace(code_exec_term, CtConst::CODE_EXEC_COMMAND, binary_cmd);
@@ -435,21 +449,22 @@ void CtActions::exec_code()
 
     g_file_set_contents(filepath_src_tmp.c_str(), code_val.c_str(), (gssize)code_val.bytes(), nullptr);
 
-    // if std::system is not enougth, then try g_spawn_async_with_pipes
-    int status = std::system(terminal_cmd.c_str());
-
-#ifdef _WIN32
-#define WEXITSTATUS(x) x
-#endif
-
-    // check exit code (0 - is good)
-    if (WEXITSTATUS(status) != 0) {
-        if (str::startswith(terminal_cmd, "xterm ")) {
-            status = std::system("xterm -version");
-            if (WEXITSTATUS(status) != 0)
-                CtDialogs::error_dialog(_("Install the package 'xterm' or configure a different terminal in the Preferences Dialog"), *_pCtMainWin);
-        }
+    const bool in_terminal = _pCtMainWin->get_ct_config()->codexecInTerminal;
+    if (in_terminal and str::startswith(terminal_cmd, "xterm ") and Glib::find_program_in_path("xterm").empty()) {
+        CtDialogs::error_dialog(_("Install the package 'xterm' or configure a different terminal in the Preferences Dialog"), *_pCtMainWin);
+        return;
     }
+    const Glib::ustring title = str::format(_("Execute Code %s"), run_id) + " - " + _pCtMainWin->curr_tree_iter().get_node_name();
+    _codeRuns.push_back(std::make_unique<CtCodeRun>(_pCtMainWin, title, in_terminal ? terminal_cmd : binary_cmd,
+                                                    _pCtMainWin->get_ct_config()->codexecTimeoutSecs,
+                                                    [this](CtCodeRun* pCodeRun){
+        // not from within the handlers of the run
+        Glib::signal_idle().connect([this, pCodeRun](){
+            _codeRuns.remove_if([pCodeRun](const std::unique_ptr<CtCodeRun>& pRun){ return pRun.get() == pCodeRun; });
+            return false; /* one shot */
+        });
+    }));
+    _codeRuns.back()->start();
 }
 
 // Load the CodeBox Content From a Text Fil
@@ -650,16 +665,18 @@ void CtActions::table_edit_properties()
 }
 
 void CtActions::table_export()
-{    
-    // todo: find good csv lib
-    return;
-
+{
     CtDialogs::file_select_args args = {.pParentWin=_pCtMainWin, .curr_folder=_pCtMainWin->get_ct_config()->pickDirCsv,
                                        .filter_name=_("CSV File"), .filter_pattern={"*.csv"}};
     Glib::ustring filename = CtDialogs::file_save_as_dialog(args);
     if (filename.empty()) return;
-    if (str::endswith(filename, ".csv")) filename += ".csv";
+    if (not str::endswith(filename, ".csv")) filename += ".csv";
     _pCtMainWin->get_ct_config()->pickDirCsv = Glib::path_get_dirname(filename);
+    std::ofstream outStream(filename, std::ios::binary);
+    curr_table_anchor->to_csv(outStream);
+    outStream.close();
+    if (not outStream)
+        CtDialogs::error_dialog(str::format(_("Write to %s Failed"), std::string(filename)), *_pCtMainWin);
 }
 
 // Anchor Edit Dialog
@@ -681,51 +698,70 @@ void CtActions::_anchor_edit_dialog(CtImageAnchor* anchor, Gtk::TextIter insert_
     image_insert_anchor(insert_iter, ret_anchor_name, image_justification);
 }
 
-// Iteration of the Modification Time Sentinel
-bool CtActions::_on_embfiles_sentinel_timeout()
+// Change of an Opened Embedded File, the update is delayed until the writes settle
+void CtActions::_on_embfile_monitor_changed(const std::string& filepath, Gio::FileMonitorEvent event_type)
 {
-    for(auto& item : _embfiles_opened)
+    switch (event_type)
     {
-        const Glib::ustring& filepath = item.first;
-        if (not Glib::file_test(filepath, Glib::FILE_TEST_IS_REGULAR))
-        {
-            std::cout << "embdrop" << filepath;
-            _embfiles_opened.erase(filepath);
+        case Gio::FILE_MONITOR_EVENT_CHANGED:
+        case Gio::FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+        case Gio::FILE_MONITOR_EVENT_CREATED: // editors saving through a rename
+        case Gio::FILE_MONITOR_EVENT_DELETED:
             break;
-        }
-        if (item.second != CtFileSystem::getmtime(filepath))
-        {
-           _embfiles_opened[filepath] = CtFileSystem::getmtime(filepath);
-           auto data_vec = str::split(Glib::path_get_basename(filepath), CtConst::CHAR_MINUS.c_str());
-           gint64 node_id = std::stoll(data_vec[0]);
-           size_t embfile_id = std::stol(data_vec[1]);
-
-            CtTreeIter tree_iter = _pCtMainWin->curr_tree_store().get_node_from_node_id(node_id);
-            if (not tree_iter) continue;
-            if (tree_iter.get_node_read_only())
+        default:
+            return;
+    }
+    auto it = _embfiles_opened.find(filepath);
+    if (it == _embfiles_opened.end()) return;
+    it->second.debounceConnection.disconnect();
+    it->second.debounceConnection = Glib::signal_timeout().connect([this, filepath]() {
+        _embfile_update_from_disk(filepath);
+        return false; /* one shot */
+    }, 300);
+}
+
+// Update the Embedded File from the Opened File, without changing the selected node
+void CtActions::_embfile_update_from_disk(const std::string& filepath)
+{
+    auto it = _embfiles_opened.find(filepath);
+    if (it == _embfiles_opened.end()) return;
+    if (not Glib::file_test(filepath, Glib::FILE_TEST_IS_REGULAR))
+    {
+        std::cout << "embdrop " << filepath << std::endl;
+        _embfiles_opened.erase(it);
+        return;
+    }
+    const gint64 node_id = it->second.nodeId;
+    const size_t embfile_id = it->second.embfileId;
+
+    CtTreeIter tree_iter = _pCtMainWin->curr_tree_store().get_node_from_node_id(node_id);
+    if (not tree_iter) return;
+    if (tree_iter.get_node_read_only())
+    {
+        CtDialogs::warning_dialog(_("Cannot Edit Embedded File in Read Only Node"), *_pCtMainWin);
+        return;
+    }
+    for (auto& widget: tree_iter.get_all_embedded_widgets())
+    {
+        if (CtImageEmbFile* embFile = dynamic_cast<CtImageEmbFile*>(widget))
+            if (((size_t)embFile->get_data("open_id")) == embfile_id)
             {
-                CtDialogs::warning_dialog(_("Cannot Edit Embedded File in Read Only Node"), *_pCtMainWin);
-                continue;
+                GError* pError{nullptr};
+                GMappedFile* pMappedFile = g_mapped_file_new(filepath.c_str(), FALSE/*writable*/, &pError);
+                if (not pMappedFile)
+                {
+                    std::cerr << "!! embfile read " << filepath << ": " << (pError ? pError->message : "") << std::endl;
+                    g_clear_error(&pError);
+                    return;
+                }
+                embFile->set_raw_blob(g_mapped_file_get_contents(pMappedFile), g_mapped_file_get_length(pMappedFile));
+                g_mapped_file_unref(pMappedFile);
+                embFile->set_time(std::time(nullptr));
+                embFile->update_tooltip();
+
+                _pCtMainWin->update_window_save_needed(CtSaveNeededUpdType::nbuf, false/*new_machine_state*/, &tree_iter);
+                _pCtMainWin->get_status_bar().update_status(_("Embedded File Automatically Updated:") + CtConst::CHAR_SPACE + embFile->get_file_name());
+                break;
             }
-            _pCtMainWin->curr_tree_view().set_cursor_safe(tree_iter);
-            for (auto& widget: tree_iter.get_all_embedded_widgets())
-            {
-                if (CtImageEmbFile* embFile = dynamic_cast<CtImageEmbFile*>(widget))
-                    if (((size_t)embFile->get_data("open_id")) == embfile_id)
-                    {
-                        auto file = std::fstream(filepath, std::ios::in | std::ios::binary);
-                        std::vector<char> buffer(std::istreambuf_iterator<char>(file), {});
-                        file.close();
-                        embFile->set_raw_blob(buffer.data(), buffer.size());
-                        embFile->set_time(std::time(nullptr));
-                        embFile->update_tooltip();
-
-                        _pCtMainWin->update_window_save_needed(CtSaveNeededUpdType::nbuf);
-                        _pCtMainWin->get_status_bar().update_status(_("Embedded File Automatically Updated:") + CtConst::CHAR_SPACE + embFile->get_file_name());
-                        break;
-                    }
-           }
-        }
     }
-    return true; // this way we keep the timer alive
 }
@@ -49,6 +49,16 @@ bool CtActions::_is_curr_node_not_read_only_or_error()
         CtDialogs::error_dialog(_("The Selected Node is Read Only"), *_pCtMainWin);
         return false;
     }
+    return _is_no_paste_in_progress_or_error();
+}
+
+bool CtActions::_is_no_paste_in_progress_or_error()
+{
+    if (_pCtMainWin->is_paste_in_progress()) {
+        // a large paste is still going on by chunks, it can be stopped from the status bar
+        _pCtMainWin->get_status_bar().update_status(_("Wait for the Paste to Complete or Stop it"));
+        return false;
+    }
     return true;
 }
 
@@ -109,7 +119,7 @@ void CtActions::_node_add(bool duplicate, bool add_child)
             nodeData.rTextBuffer = _pCtMainWin->get_new_text_buffer(nodeData.syntax, nodeData.rTextBuffer->get_text());
             nodeData.anchoredWidgets.clear();
         } else {
-            node_state = _pCtMainWin->get_state_machine().requested_state_previous(_pCtMainWin->curr_tree_iter().get_node_id());
+            node_state = _pCtMainWin->get_state_machine().get_node_snapshot(_pCtMainWin->curr_tree_iter());
             nodeData.anchoredWidgets.clear();
             nodeData.rTextBuffer = _pCtMainWin->get_new_text_buffer(nodeData.syntax, "");
         }
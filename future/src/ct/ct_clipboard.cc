@@ -127,7 +127,7 @@ void CtClipboard::_paste_clipboard(Gtk::TextView* pTextView, CtCodebox* /*pCodeb
     auto on_scope_exit = scope_guard([&](void*) { CtClipboard::_static_force_plain_text = false; });
 
     g_signal_stop_emission_by_name(G_OBJECT(pTextView->gobj()), "paste-clipboard");
-    if (_pCtMainWin->curr_tree_iter().get_node_read_only())
+    if (_pCtMainWin->curr_tree_iter().get_node_read_only() or _pCtMainWin->is_paste_in_progress())
         return;
     std::vector<Glib::ustring> targets = Gtk::Clipboard::get()->wait_for_targets();
     if (targets.empty())
@@ -318,13 +318,16 @@ void CtClipboard::_selection_to_clipboard(Glib::RefPtr<Gtk::TextBuffer> text_buf
         }
     }
 
+    // the targets are generated when an application asks for them, not on every copy
     CtClipboardData* clip_data = new CtClipboardData();
-    clip_data->html_text = CtExport2Html(_pCtMainWin).selection_export_to_html(text_buffer, iter_sel_start, iter_sel_end, !pCodebox ? node_syntax_high : CtConst::PLAIN_TEXT_ID);
+    clip_data->selection.text_buffer = text_buffer;
+    clip_data->selection.start_offset = iter_sel_start.get_offset();
+    clip_data->selection.end_offset = iter_sel_end.get_offset();
+    clip_data->selection.node_id = _pCtMainWin->curr_tree_iter().get_node_id();
+    clip_data->selection.syntax_highlighting = !pCodebox ? node_syntax_high : CtConst::PLAIN_TEXT_ID;
     if (not pCodebox and node_syntax_high == CtConst::RICH_TEXT_ID)
     {
         std::vector<std::string> targets_vector;
-        clip_data->plain_text = CtExport2Txt(_pCtMainWin).selection_export_to_txt(text_buffer, iter_sel_start.get_offset(), iter_sel_end.get_offset(), true);
-        clip_data->rich_text = rich_text_get_from_text_buffer_selection(_pCtMainWin->curr_tree_iter(), text_buffer, iter_sel_start, iter_sel_end);
         if (not CtClipboard::_static_force_plain_text)
         {
             targets_vector = {TARGET_CTD_PLAIN_TEXT, TARGET_CTD_RICH_TEXT, TARGETS_HTML[0], TARGETS_HTML[1]};
@@ -337,11 +340,13 @@ void CtClipboard::_selection_to_clipboard(Glib::RefPtr<Gtk::TextBuffer> text_buf
         else
             targets_vector = {TARGET_CTD_PLAIN_TEXT};
 
+        // the edits inside the anchored widgets do not go through the buffer signals
+        if (not _pCtMainWin->curr_tree_iter().get_embedded_pixbufs_tables_codeboxes(std::make_pair(clip_data->selection.start_offset, clip_data->selection.end_offset)).empty())
+            _clip_data_generate(clip_data, true/*html*/, true/*plain*/, true/*rich*/);
         _set_clipboard_data(targets_vector, clip_data);
     }
     else
     {
-        clip_data->plain_text = text_buffer->get_text(iter_sel_start, iter_sel_end);
         std::vector<std::string> targets_vector;
         if (not CtClipboard::_static_force_plain_text)
             targets_vector = {TARGET_CTD_PLAIN_TEXT, TARGETS_HTML[0], TARGETS_HTML[1]};
@@ -365,7 +370,68 @@ void CtClipboard::_set_clipboard_data(const std::vector<std::string>& targets_li
     auto clip_data_clear = [clip_data]() {
        delete clip_data;
     };
-    Gtk::Clipboard::get()->set(target_entries, clip_data_get, clip_data_clear);
+    if (Gtk::Clipboard::get()->set(target_entries, clip_data_get, clip_data_clear) and clip_data->selection.text_buffer)
+    {
+        // before the copied selection is changed, the targets not requested yet are generated
+        auto on_buffer_change = [win, clip_data]() { CtClipboard(win)._clip_data_generate(clip_data, true, true, true); };
+        auto text_buffer = clip_data->selection.text_buffer;
+        auto& changes = clip_data->selection.buffer_changes;
+        changes.push_back(text_buffer->signal_insert().connect([on_buffer_change](const Gtk::TextIter&, const Glib::ustring&, int){ on_buffer_change(); }, false));
+        changes.push_back(text_buffer->signal_erase().connect([on_buffer_change](const Gtk::TextIter&, const Gtk::TextIter&){ on_buffer_change(); }, false));
+        changes.push_back(text_buffer->signal_insert_child_anchor().connect([on_buffer_change](const Gtk::TextIter&, const Glib::RefPtr<Gtk::TextChildAnchor>&){ on_buffer_change(); }, false));
+        // syntax highlighting, bracket matching and spell check tags are not copied
+        auto on_tag_change = [on_buffer_change](const Glib::RefPtr<Gtk::TextTag>& rTextTag, const Gtk::TextIter&, const Gtk::TextIter&){
+            if (CtStateMachine::is_rich_text_tag(rTextTag->property_name())) on_buffer_change();
+        };
+        changes.push_back(text_buffer->signal_apply_tag().connect(on_tag_change, false));
+        changes.push_back(text_buffer->signal_remove_tag().connect(on_tag_change, false));
+    }
+}
+
+// Generate the Requested Targets of the Copied Selection that were not Generated yet
+void CtClipboard::_clip_data_generate(CtClipboardData* clip_data, const bool html, const bool plain, const bool rich)
+{
+    CtClipboardSelection& selection = clip_data->selection;
+    const bool need_html = html and not clip_data->html_text;
+    const bool need_plain = plain and not clip_data->plain_text;
+    const bool need_rich = rich and not clip_data->rich_text;
+    if (need_html or need_plain or need_rich)
+    {
+        CtTreeIter node_iter = _pCtMainWin->curr_tree_store().get_node_from_node_id(selection.node_id);
+        const bool is_rich_text = selection.syntax_highlighting == CtConst::RICH_TEXT_ID;
+        auto is_source_node = [&]() {
+            Glib::RefPtr<Gsv::Buffer> node_buffer = node_iter ? node_iter.get_node_text_buffer() : Glib::RefPtr<Gsv::Buffer>{};
+            return node_buffer and GTK_TEXT_BUFFER(node_buffer->gobj()) == selection.text_buffer->gobj();
+        };
+        if (not selection.text_buffer or (is_rich_text and not is_source_node()))
+        {
+            // the node of the copied rich text is gone, its widgets with it
+            std::cerr << "!! clipboard selection source missing" << std::endl;
+            if (need_html) clip_data->html_text = "";
+            if (need_plain) clip_data->plain_text = "";
+            if (need_rich) clip_data->rich_text = "";
+        }
+        else
+        {
+            Gtk::TextIter iter_sel_start = selection.text_buffer->get_iter_at_offset(selection.start_offset);
+            Gtk::TextIter iter_sel_end = selection.text_buffer->get_iter_at_offset(selection.end_offset);
+            if (need_html)
+                clip_data->html_text = CtExport2Html(_pCtMainWin).selection_export_to_html(node_iter, selection.text_buffer, iter_sel_start, iter_sel_end, selection.syntax_highlighting);
+            if (need_plain)
+                clip_data->plain_text = is_rich_text ? CtExport2Txt(_pCtMainWin).selection_export_to_txt(node_iter, selection.text_buffer, selection.start_offset, selection.end_offset, true)
+                                                     : selection.text_buffer->get_text(iter_sel_start, iter_sel_end);
+            if (need_rich)
+                clip_data->rich_text = is_rich_text ? rich_text_get_from_text_buffer_selection(node_iter, selection.text_buffer, iter_sel_start, iter_sel_end) : "";
+        }
+    }
+    if (clip_data->html_text and clip_data->plain_text and clip_data->rich_text)
+    {
+        // nothing left to generate from the buffer
+        for (auto& connection: selection.buffer_changes)
+            connection.disconnect();
+        selection.buffer_changes.clear();
+        selection.text_buffer.reset();
+    }
 }
 
 // based on def get_func(self, clipboard, selectiondata, info, data)
@@ -373,24 +439,34 @@ void  CtClipboard::_on_clip_data_get(Gtk::SelectionData& selection_data, CtClipb
 {
     Glib::ustring target = selection_data.get_target();
     if (target == TARGET_CTD_PLAIN_TEXT)
-        selection_data.set(target, 8, (const guint8*)clip_data->plain_text.c_str(), (int)clip_data->plain_text.bytes());
+    {
+        _clip_data_generate(clip_data, false/*html*/, true/*plain*/, false/*rich*/);
+        const Glib::ustring& plain_text = *clip_data->plain_text;
+        selection_data.set(target, 8, (const guint8*)plain_text.c_str(), (int)plain_text.bytes());
+    }
     else if (target == TARGET_CTD_RICH_TEXT)
-        selection_data.set("UTF8_STRING", 8, (const guint8*)clip_data->rich_text.c_str(), (int)clip_data->rich_text.bytes());
+    {
+        _clip_data_generate(clip_data, false/*html*/, false/*plain*/, true/*rich*/);
+        const Glib::ustring& rich_text = *clip_data->rich_text;
+        selection_data.set("UTF8_STRING", 8, (const guint8*)rich_text.c_str(), (int)rich_text.bytes());
+    }
     else if (vec::exists(TARGETS_HTML, target))
     {
+        _clip_data_generate(clip_data, true/*html*/, false/*plain*/, false/*rich*/);
+        const Glib::ustring& html_text = *clip_data->html_text;
         if (not CtConst::IS_WIN_OS)
-            selection_data.set(target, 8, (const guint8*)clip_data->html_text.c_str(), (int)clip_data->html_text.bytes());
+            selection_data.set(target, 8, (const guint8*)html_text.c_str(), (int)html_text.bytes());
         else
             if (target == TARGETS_HTML[0])
             {
                 glong utf16text_len = 0;
-                g_autofree gunichar2* utf16text = g_utf8_to_utf16(clip_data->html_text.c_str(), (glong)clip_data->html_text.bytes(), nullptr, &utf16text_len, nullptr);
+                g_autofree gunichar2* utf16text = g_utf8_to_utf16(html_text.c_str(), (glong)html_text.bytes(), nullptr, &utf16text_len, nullptr);
                 if (utf16text and utf16text_len > 0)
                     selection_data.set(target, 8, (guint8*)utf16text, (int)utf16text_len);
             }
             else
             {
-                Glib::ustring html = Win32HtmlFormat().encode(clip_data->html_text);
+                Glib::ustring html = Win32HtmlFormat().encode(html_text);
                 selection_data.set(target, 8, (const guint8*)html.c_str(), (int)html.bytes());
             }
     }
@@ -417,28 +493,19 @@ void CtClipboard::_on_received_to_plain_text(const Gtk::SelectionData& selection
         std::cout << "? no clipboard plain text" << std::endl;
         return;
     }
+    const bool with_web_links = _pCtMainWin->curr_tree_iter().get_node_syntax_highlighting() == CtConst::RICH_TEXT_ID and !force_plain_text;
+    if (plain_text.bytes() > PASTE_CHUNK_BYTES and pTextView == &_pCtMainWin->get_text_view())
+    {
+        _paste_plain_text_by_chunks(plain_text, pTextView, with_web_links);
+        return;
+    }
     auto curr_buffer = pTextView->get_buffer();
     Gtk::TextIter iter_insert = curr_buffer->get_insert()->get_iter();
     int start_offset = iter_insert.get_offset();
     curr_buffer->insert(iter_insert, plain_text);
-    if (_pCtMainWin->curr_tree_iter().get_node_syntax_highlighting() == CtConst::RICH_TEXT_ID and !force_plain_text)
+    if (with_web_links)
     {
-        auto web_links_offsets = CtImports::get_web_links_offsets_from_plain_text(plain_text);
-        if (web_links_offsets.size())
-        {
-            for (auto& offset: web_links_offsets)
-            {
-                Gtk::TextIter iter_sel_start = curr_buffer->get_iter_at_offset(start_offset + offset.first);
-                Gtk::TextIter iter_sel_end = curr_buffer->get_iter_at_offset(start_offset + offset.second);
-                Glib::ustring link_url = plain_text.substr((size_t)offset.first, (size_t)(offset.second - offset.first));
-                if (not str::startswith(link_url, "htt") and not str::startswith(link_url, "ftp"))
-                    link_url = "http://" + link_url;
-                Glib::ustring property_value = "webs " + link_url;
-                curr_buffer->apply_tag_by_name(_pCtMainWin->get_text_tag_name_exist_or_create(CtConst::TAG_LINK, property_value),
-                                               iter_sel_start, iter_sel_end);
-            }
-        }
-        else
+        if (not _tag_web_links(curr_buffer, plain_text, start_offset))
         {
             // check for file or folder path
             if (plain_text.find(CtConst::CHAR_NEWLINE) == Glib::ustring::npos)
@@ -462,6 +529,152 @@ void CtClipboard::_on_received_to_plain_text(const Gtk::SelectionData& selection
     pTextView->scroll_to(curr_buffer->get_insert());
 }
 
+// Tag the Web Links of the Text Inserted at start_offset, Returns False if there are None
+bool CtClipboard::_tag_web_links(Glib::RefPtr<Gtk::TextBuffer> text_buffer, const Glib::ustring& text, const int start_offset)
+{
+    auto web_links_offsets = CtImports::get_web_links_offsets_from_plain_text(text);
+    for (auto& offset: web_links_offsets)
+    {
+        Gtk::TextIter iter_sel_start = text_buffer->get_iter_at_offset(start_offset + offset.first);
+        Gtk::TextIter iter_sel_end = text_buffer->get_iter_at_offset(start_offset + offset.second);
+        Glib::ustring link_url = iter_sel_start.get_text(iter_sel_end);
+        if (not str::startswith(link_url, "htt") and not str::startswith(link_url, "ftp"))
+            link_url = "http://" + link_url;
+        Glib::ustring property_value = "webs " + link_url;
+        text_buffer->apply_tag_by_name(_pCtMainWin->get_text_tag_name_exist_or_create(CtConst::TAG_LINK, property_value),
+                                       iter_sel_start, iter_sel_end);
+    }
+    return not web_links_offsets.empty();
+}
+
+// A large plain text being pasted into the node by chunks
+struct CtClipboard::CtPasteChunks
+{
+    std::string                   text;
+    size_t                        byteIdx{0};
+    Glib::RefPtr<Gtk::TextBuffer> textBuffer;
+    Glib::RefPtr<Gtk::TextMark>   insertMark;  // where the next chunk goes
+    gint64                        nodeId{-1};
+    bool                          withWebLinks{false};
+    bool                          wasEditable{true};
+    size_t                        runByteIdx{std::string::npos}; // a run without separators going on over chunks
+    int                           runOffset{0};                  // and where it starts in the buffer
+};
+
+// Paste a Large Plain Text by Chunks in the Idle Time, with Progress and Stop in the Status Bar, as a Single Undo Step
+void CtClipboard::_paste_plain_text_by_chunks(const Glib::ustring& plain_text, Gtk::TextView* pTextView, const bool with_web_links)
+{
+    auto pPaste = std::make_shared<CtPasteChunks>();
+    pPaste->text = plain_text.raw();
+    pPaste->textBuffer = pTextView->get_buffer();
+    pPaste->insertMark = pPaste->textBuffer->create_mark(pPaste->textBuffer->get_insert()->get_iter(), false/*left_gravity*/);
+    pPaste->nodeId = _pCtMainWin->curr_tree_iter().get_node_id();
+    pPaste->withWebLinks = with_web_links;
+    pPaste->wasEditable = pTextView->get_editable();
+
+    // the changes so far get their own step, the paste will be the next one
+    CtStateMachine& stateMachine = _pCtMainWin->get_state_machine();
+    stateMachine.update_state();
+    stateMachine.not_undoable_timeslot_set(true);
+    _pCtMainWin->set_paste_in_progress(true);
+    // no typing into the text being pasted
+    pTextView->set_editable(false);
+
+    CtStatusBar& ctStatusBar = _pCtMainWin->get_status_bar();
+    ctStatusBar.progressBar.set_fraction(0);
+    ctStatusBar.progressBar.set_text("0%");
+    ctStatusBar.progressBar.show();
+    ctStatusBar.stopButton.show();
+    ctStatusBar.set_progress_stop(false);
+
+    CtMainWin* win = _pCtMainWin;
+    Glib::signal_idle().connect([win, pTextView, pPaste](){
+        return CtClipboard(win)._paste_next_chunk(pTextView, *pPaste);
+    });
+}
+
+// Insert the Next Chunk of the Paste, Returns False Once the Paste is Over
+bool CtClipboard::_paste_next_chunk(Gtk::TextView* pTextView, CtPasteChunks& paste)
+{
+    CtStatusBar& ctStatusBar = _pCtMainWin->get_status_bar();
+    CtTreeIter curr_tree_iter = _pCtMainWin->curr_tree_iter();
+    const bool is_curr_node = curr_tree_iter and curr_tree_iter.get_node_id() == paste.nodeId;
+    if (is_curr_node and not ctStatusBar.is_progress_stop() and paste.byteIdx < paste.text.size())
+    {
+        size_t end_byte = std::min(paste.byteIdx + PASTE_CHUNK_BYTES, paste.text.size());
+        bool run_goes_on{false};
+        if (end_byte < paste.text.size())
+        {
+            // the chunk ends after its last separator, so no web link is split between chunks
+            // searched within the chunk only, a long run must not rescan the text already pasted
+            size_t after_separator = end_byte;
+            while (after_separator > paste.byteIdx and paste.text[after_separator - 1] != ' ' and paste.text[after_separator - 1] != '\n')
+                --after_separator;
+            if (after_separator > paste.byteIdx)
+            {
+                end_byte = after_separator;
+            }
+            else
+            {
+                // no separator in the whole chunk, it ends on a utf-8 char boundary and the run goes on in the next chunk
+                while (end_byte > paste.byteIdx and (static_cast<unsigned char>(paste.text[end_byte]) & 0xC0) == 0x80)
+                    --end_byte;
+                run_goes_on = true;
+            }
+        }
+        Glib::ustring chunk{paste.text.substr(paste.byteIdx, end_byte - paste.byteIdx)};
+        Gtk::TextIter iter_insert = paste.textBuffer->get_iter_at_mark(paste.insertMark);
+        const int start_offset = iter_insert.get_offset();
+        paste.textBuffer->insert(iter_insert, chunk);
+        if (paste.withWebLinks)
+        {
+            if (std::string::npos == paste.runByteIdx and run_goes_on)
+            {
+                // the web links of the run are tagged once it is over
+                paste.runByteIdx = paste.byteIdx;
+                paste.runOffset = start_offset;
+            }
+            else if (std::string::npos == paste.runByteIdx)
+            {
+                _tag_web_links(paste.textBuffer, chunk, start_offset);
+            }
+            else if (not run_goes_on)
+            {
+                _tag_web_links(paste.textBuffer, paste.text.substr(paste.runByteIdx, end_byte - paste.runByteIdx), paste.runOffset);
+                paste.runByteIdx = std::string::npos;
+            }
+        }
+        paste.byteIdx = end_byte;
+
+        const double fraction = double(paste.byteIdx)/double(paste.text.size());
+        ctStatusBar.progressBar.set_fraction(fraction);
+        ctStatusBar.progressBar.set_text(std::to_string(int(fraction * 100)) + "%");
+        if (paste.byteIdx < paste.text.size())
+            return true; // call again for the next chunk
+    }
+
+    // the paste is over, stopped or the node was left
+    if (std::string::npos != paste.runByteIdx)
+        _tag_web_links(paste.textBuffer, paste.text.substr(paste.runByteIdx, paste.byteIdx - paste.runByteIdx), paste.runOffset);
+    ctStatusBar.progressBar.hide();
+    ctStatusBar.stopButton.hide();
+    ctStatusBar.set_progress_stop(false);
+    CtStateMachine& stateMachine = _pCtMainWin->get_state_machine();
+    stateMachine.not_undoable_timeslot_set(false);
+    _pCtMainWin->set_paste_in_progress(false);
+    CtTreeIter node_iter = _pCtMainWin->curr_tree_store().get_node_from_node_id(paste.nodeId);
+    if (node_iter)
+        stateMachine.update_state(node_iter);
+    if (is_curr_node)
+    {
+        pTextView->set_editable(paste.wasEditable);
+        paste.textBuffer->place_cursor(paste.textBuffer->get_iter_at_mark(paste.insertMark));
+        pTextView->scroll_to(paste.textBuffer->get_insert());
+    }
+    paste.textBuffer->delete_mark(paste.insertMark);
+    return false;
+}
+
 // From Clipboard to Rich Text
 void CtClipboard::_on_received_to_rich_text(const Gtk::SelectionData& selection_data, Gtk::TextView* pTextView, bool)
 {
@@ -531,27 +744,21 @@ void CtClipboard::_on_received_to_table(const Gtk::SelectionData& selection_data
     {
         CtTableMatrix tableMatrix;
         const bool isHeadFront = CtXmlRead(_pCtMainWin).populate_table_matrix_get_is_head_front(tableMatrix, static_cast<xmlpp::Element*>(doc->get_root_node()->get_first_child("table")));
-        if (!isHeadFront)
+        if (!isHeadFront and not tableMatrix.empty())
         {
-            CtTableRow headerRow = tableMatrix.back();
-            tableMatrix.pop_back();
-            tableMatrix.insert(tableMatrix.begin(), headerRow);
+            std::rotate(tableMatrix.begin(), tableMatrix.end()-1, tableMatrix.end());
         }
 
-        int col_num = (int)parentTable->get_table_matrix()[0].size();
+        int col_num = parentTable->get_num_columns();
         int insert_after = parentTable->current_row() - 1;
         if (insert_after < 0) insert_after = 0;
         for (int row = 1 /*skip header*/; row < tableMatrix.size(); ++row)
         {
-            std::vector<Glib::ustring> new_row;
-            std::transform(tableMatrix[row].begin(), tableMatrix[row].end(), std::back_inserter(new_row), [](CtTableCell* cell) { return cell->get_text_content(); });
+            std::vector<Glib::ustring>& new_row = tableMatrix[row];
             while (new_row.size() > col_num) new_row.pop_back();
             while (new_row.size() < col_num) new_row.push_back("");
             parentTable->row_add(insert_after + (row-1), &new_row);
         }
-        for (auto row: tableMatrix)
-            for (auto cell: row)
-                delete cell;
         _pCtMainWin->update_window_save_needed(CtSaveNeededUpdType::nbuf, true /*new_machine_state*/);
     }
     else
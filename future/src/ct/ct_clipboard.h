@@ -24,21 +24,38 @@
 #include <gtkmm/textiter.h>
 #include <ct_treestore.h>
 #include <libxml++/libxml++.h>
+#include <optional>
 #include "ct_codebox.h"
 #include "ct_table.h"
 
+// The copied text selection, the targets are generated from it only when first requested
+struct CtClipboardSelection
+{
+    Glib::RefPtr<Gtk::TextBuffer> text_buffer;
+    int                           start_offset{0};
+    int                           end_offset{0};
+    gint64                        node_id{-1};
+    Glib::ustring                 syntax_highlighting;
+    std::vector<sigc::connection> buffer_changes; // the buffer is about to change, the pending targets are generated
+};
+
 struct CtClipboardData
 {
+    ~CtClipboardData() { for (auto& connection: selection.buffer_changes) connection.disconnect(); }
+
     xmlpp::Document xml_doc;
-    Glib::ustring html_text;
-    Glib::ustring plain_text;
-    Glib::ustring rich_text;
+    std::optional<Glib::ustring> html_text;
+    std::optional<Glib::ustring> plain_text;
+    std::optional<Glib::ustring> rich_text;
     Glib::RefPtr<Gdk::Pixbuf> pix_buf;
+    CtClipboardSelection selection;
 };
 
 class CtClipboard
 {
 public:
+    static const size_t PASTE_CHUNK_BYTES{256*1024}; // larger plain text pastes are inserted by chunks in the idle time
+
     CtClipboard(CtMainWin* pCtMainWin);
 
 public:
@@ -68,10 +85,17 @@ private:
 private:
     void _selection_to_clipboard(Glib::RefPtr<Gtk::TextBuffer> text_buffer, Gtk::TextView* sourceview, Gtk::TextIter iter_sel_start, Gtk::TextIter iter_sel_end, int num_chars, CtCodebox* pCodebox);
     void _set_clipboard_data(const std::vector<std::string>& targets_list, CtClipboardData* clip_data);
+    void _clip_data_generate(CtClipboardData* clip_data, const bool html, const bool plain, const bool rich);
 
 private:
     void _on_clip_data_get(Gtk::SelectionData& selection_data, CtClipboardData* clip_data);
 
+private:
+    struct CtPasteChunks;
+    bool _tag_web_links(Glib::RefPtr<Gtk::TextBuffer> text_buffer, const Glib::ustring& text, const int start_offset);
+    void _paste_plain_text_by_chunks(const Glib::ustring& plain_text, Gtk::TextView* pTextView, const bool with_web_links);
+    bool _paste_next_chunk(Gtk::TextView* pTextView, CtPasteChunks& paste);
+
 private:
     void _on_received_to_plain_text(const Gtk::SelectionData& selection_data, Gtk::TextView* pTextView, bool force_plain_text);
     void _on_received_to_rich_text(const Gtk::SelectionData& selection_data, Gtk::TextView* pTextView, bool);
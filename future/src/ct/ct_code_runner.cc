@@ -0,0 +1,292 @@
+/*
+ * ct_code_runner.cc
+ *
+ * Copyright 2017-2020 Giuseppe Penone <giuspen@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_code_runner.h"
+#include "ct_main_win.h"
+#include "ct_const.h"
+#include "ct_misc_utils.h"
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+CtCodeRun::CtCodeRun(CtMainWin* pCtMainWin,
+                     const Glib::ustring& title,
+                     const std::string& command,
+                     const int timeoutSecs,
+                     const std::function<void(CtCodeRun*)>& on_disposable)
+ : _command(command),
+   _timeoutSecs(timeoutSecs),
+   _on_disposable(on_disposable),
+   _buttonCancel(_("Cancel")),
+   _buttonClose(_("Close"))
+{
+    set_title(title);
+    set_transient_for(*pCtMainWin);
+    set_default_size(600, 400);
+
+    _textView.set_editable(false);
+    _textView.set_monospace(true);
+    _textView.set_wrap_mode(Gtk::WRAP_CHAR);
+    _rStderrTag = _textView.get_buffer()->create_tag();
+    _rStderrTag->property_foreground() = "red";
+    _scrolledWindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+    _scrolledWindow.add(_textView);
+
+    _labelStatus.set_halign(Gtk::ALIGN_START);
+    _hboxStatus.set_spacing(6);
+    _hboxStatus.set_border_width(3);
+    _hboxStatus.pack_start(_labelStatus, true, true);
+    _hboxStatus.pack_start(_buttonCancel, false, false);
+    _hboxStatus.pack_start(_buttonClose, false, false);
+    _vbox.pack_start(_scrolledWindow, true, true);
+    _vbox.pack_start(_hboxStatus, false, false);
+    add(_vbox);
+
+    _buttonCancel.signal_clicked().connect(sigc::mem_fun(*this, &CtCodeRun::cancel));
+    _buttonClose.signal_clicked().connect([this](){ hide(); });
+    signal_hide().connect([this](){
+        // closing the window stops the run, the run is disposed of once the process is reaped
+        cancel();
+        if (is_disposable()) _on_disposable(this);
+    });
+    show_all();
+}
+
+CtCodeRun::~CtCodeRun()
+{
+    _timeoutConnection.disconnect();
+    _alive.reset(); // pending callbacks are ignored
+    if (_pCancellable)
+    {
+        g_cancellable_cancel(_pCancellable);
+        g_object_unref(_pCancellable);
+    }
+    if (_pSubprocess)
+    {
+        if (not _exited) _kill_processes(true/*atOnce*/);
+        g_object_unref(_pSubprocess);
+    }
+}
+
+void CtCodeRun::start()
+{
+#ifdef _WIN32
+    const gchar* argv[] = {"cmd", "/c", _command.c_str(), nullptr};
+#else
+    const gchar* argv[] = {"sh", "-c", _command.c_str(), nullptr};
+#endif
+    _insert_text(Glib::ustring{_command} + CtConst::CHAR_NEWLINE, false/*isStderr*/);
+    GError* pError{nullptr};
+    GSubprocessLauncher* pLauncher = g_subprocess_launcher_new(static_cast<GSubprocessFlags>(G_SUBPROCESS_FLAGS_STDOUT_PIPE | G_SUBPROCESS_FLAGS_STDERR_PIPE));
+#ifndef _WIN32
+    // the shell leads a new process group, which then holds every process started by the command
+    g_subprocess_launcher_set_child_setup(pLauncher, [](gpointer){ setsid(); }, nullptr, nullptr);
+#endif
+    _pSubprocess = g_subprocess_launcher_spawnv(pLauncher, argv, &pError);
+    g_object_unref(pLauncher);
+    if (not _pSubprocess)
+    {
+        _insert_text(Glib::ustring{pError->message} + CtConst::CHAR_NEWLINE, true/*isStderr*/);
+        _labelStatus.set_text(_("Failed to Start"));
+        _buttonCancel.set_sensitive(false);
+        g_error_free(pError);
+        return;
+    }
+#ifndef _WIN32
+    if (const gchar* pIdentifier = g_subprocess_get_identifier(_pSubprocess))
+    {
+        _processGroup = static_cast<pid_t>(std::stol(pIdentifier));
+    }
+#endif
+    _pCancellable = g_cancellable_new();
+    _startTime = g_get_monotonic_time();
+    _labelStatus.set_text(_("Running..."));
+
+    _read_next(false/*isStderr*/);
+    _read_next(true/*isStderr*/);
+    ++_pendingOps;
+    g_subprocess_wait_async(_pSubprocess, nullptr, &CtCodeRun::_on_wait_done, new CtAsyncData{this, _alive, false});
+
+    if (_timeoutSecs > 0)
+    {
+        _timeoutConnection = Glib::signal_timeout().connect_seconds([this](){
+            if (is_running())
+            {
+                _timedOut = true;
+                cancel();
+            }
+            return false; /* one shot */
+        }, static_cast<unsigned int>(_timeoutSecs));
+    }
+}
+
+void CtCodeRun::cancel()
+{
+    if (is_running())
+    {
+        _kill_processes(false/*atOnce*/);
+    }
+    if (_pCancellable)
+    {
+        g_cancellable_cancel(_pCancellable);
+    }
+}
+
+void CtCodeRun::_kill_processes(const bool atOnce)
+{
+#ifdef _WIN32
+    (void)atOnce;
+    g_subprocess_force_exit(_pSubprocess);
+#else
+    if (_processGroup <= 0)
+    {
+        g_subprocess_force_exit(_pSubprocess);
+        return;
+    }
+    // the group is signalled only while its leader is not reaped, its id can't be reused by then
+    if (atOnce)
+    {
+        (void)kill(-_processGroup, SIGKILL);
+        return;
+    }
+    // the group is given some time to terminate, the processes left behind are then killed
+    (void)kill(-_processGroup, SIGTERM);
+    Glib::signal_timeout().connect_seconds([this, alive = std::weak_ptr<bool>{_alive}](){
+        if (not alive.expired() and not _exited)
+        {
+            _kill_processes(true/*atOnce*/);
+        }
+        return false; /* one shot */
+    }, KILL_GRACE_SECS);
+#endif
+}
+
+void CtCodeRun::_read_next(const bool isStderr)
+{
+    GInputStream* pStream = isStderr ? g_subprocess_get_stderr_pipe(_pSubprocess) : g_subprocess_get_stdout_pipe(_pSubprocess);
+    ++_pendingOps;
+    g_input_stream_read_bytes_async(pStream, 64*1024, G_PRIORITY_DEFAULT, _pCancellable, &CtCodeRun::_on_read_done, new CtAsyncData{this, _alive, isStderr});
+}
+
+void CtCodeRun::_on_read_done(GObject* pSource, GAsyncResult* pResult, gpointer pData)
+{
+    std::unique_ptr<CtAsyncData> pAsyncData{static_cast<CtAsyncData*>(pData)};
+    GBytes* pBytes = g_input_stream_read_bytes_finish(G_INPUT_STREAM(pSource), pResult, nullptr);
+    if (pAsyncData->alive.expired())
+    {
+        if (pBytes) g_bytes_unref(pBytes);
+        return;
+    }
+    CtCodeRun* pCodeRun = pAsyncData->pCodeRun;
+    gsize numBytes{0};
+    const char* pChunk = pBytes ? static_cast<const char*>(g_bytes_get_data(pBytes, &numBytes)) : nullptr;
+    if (numBytes > 0)
+    {
+        // more to read until the end of the stream or an error
+        pCodeRun->_append_output(pChunk, numBytes, pAsyncData->isStderr, false/*atEnd*/);
+        pCodeRun->_read_next(pAsyncData->isStderr);
+    }
+    else
+    {
+        pCodeRun->_append_output(nullptr, 0, pAsyncData->isStderr, true/*atEnd*/);
+    }
+    if (pBytes) g_bytes_unref(pBytes);
+    pCodeRun->_op_done();
+}
+
+void CtCodeRun::_on_wait_done(GObject* pSource, GAsyncResult* pResult, gpointer pData)
+{
+    std::unique_ptr<CtAsyncData> pAsyncData{static_cast<CtAsyncData*>(pData)};
+    g_subprocess_wait_finish(G_SUBPROCESS(pSource), pResult, nullptr);
+    if (pAsyncData->alive.expired()) return;
+    pAsyncData->pCodeRun->_on_exited();
+    pAsyncData->pCodeRun->_op_done();
+}
+
+void CtCodeRun::_append_output(const char* pData, const size_t numBytes, const bool isStderr, const bool atEnd)
+{
+    if (_outputBytes >= OUTPUT_MAX_BYTES) return;
+    _outputBytes += numBytes;
+    std::string& pending = isStderr ? _pendingStderr : _pendingStdout;
+    if (numBytes > 0) pending.append(pData, numBytes);
+    // a multibyte character may be split between chunks, the tail waits for the next chunk
+    const gchar* pValidEnd{nullptr};
+    g_utf8_validate(pending.c_str(), static_cast<gssize>(pending.size()), &pValidEnd);
+    const size_t validBytes = static_cast<size_t>(pValidEnd - pending.c_str());
+    const size_t tailBytes = pending.size() - validBytes;
+    if (0 == tailBytes)
+    {
+        _insert_text(pending, isStderr);
+        pending.clear();
+    }
+    else if (not atEnd and tailBytes < 4 and
+             g_utf8_get_char_validated(pValidEnd, static_cast<gssize>(tailBytes)) == static_cast<gunichar>(-2))
+    {
+        _insert_text(pending.substr(0, validBytes), isStderr);
+        pending.erase(0, validBytes);
+    }
+    else
+    {
+        gchar* pValid = g_utf8_make_valid(pending.c_str(), static_cast<gssize>(pending.size()));
+        _insert_text(pValid, isStderr);
+        g_free(pValid);
+        pending.clear();
+    }
+    if (_outputBytes >= OUTPUT_MAX_BYTES)
+    {
+        _insert_text(Glib::ustring{CtConst::CHAR_NEWLINE} + _("(output truncated)") + CtConst::CHAR_NEWLINE, true/*isStderr*/);
+    }
+}
+
+void CtCodeRun::_insert_text(const Glib::ustring& text, const bool isStderr)
+{
+    if (text.empty()) return;
+    Glib::RefPtr<Gtk::TextBuffer> rTextBuffer = _textView.get_buffer();
+    if (isStderr)
+        rTextBuffer->insert_with_tag(rTextBuffer->end(), text, _rStderrTag);
+    else
+        rTextBuffer->insert(rTextBuffer->end(), text);
+    _textView.scroll_to(rTextBuffer->get_insert());
+    rTextBuffer->place_cursor(rTextBuffer->end());
+}
+
+void CtCodeRun::_on_exited()
+{
+    _exited = true;
+    _timeoutConnection.disconnect();
+    _buttonCancel.set_sensitive(false);
+    const double wallSecs = static_cast<double>(g_get_monotonic_time() - _startTime) / G_USEC_PER_SEC;
+    std::string status;
+    if (_timedOut)
+        status = str::format(_("Timed Out after %s s"), _timeoutSecs);
+    else if (g_subprocess_get_if_exited(_pSubprocess))
+        status = str::format(_("Exit Status %s"), g_subprocess_get_exit_status(_pSubprocess));
+    else if (g_subprocess_get_if_signaled(_pSubprocess))
+        status = str::format(_("Terminated by Signal %s"), g_subprocess_get_term_sig(_pSubprocess));
+    _labelStatus.set_text(status + fmt::format(", {:.2f} s", wallSecs));
+}
+
+void CtCodeRun::_op_done()
+{
+    --_pendingOps;
+    if (is_disposable()) _on_disposable(this);
+}
@@ -0,0 +1,102 @@
+/*
+ * ct_code_runner.h
+ *
+ * Copyright 2017-2020 Giuseppe Penone <giuspen@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <gtkmm.h>
+#include <gio/gio.h>
+#include <glibmm/i18n.h>
+#include <functional>
+#include <memory>
+#include <string>
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+class CtMainWin;
+
+// A run of the code of a codebox or node in its own output window: the command is spawned through the shell
+// and its stdout/stderr are appended to the window as they come, without blocking the main loop
+class CtCodeRun : public Gtk::Window
+{
+public:
+    static const size_t OUTPUT_MAX_BYTES{4*1024*1024};
+    static const unsigned int KILL_GRACE_SECS{2};
+
+    CtCodeRun(CtMainWin* pCtMainWin,
+              const Glib::ustring& title,
+              const std::string& command,
+              const int timeoutSecs,
+              const std::function<void(CtCodeRun*)>& on_disposable);
+    virtual ~CtCodeRun();
+
+    void start();
+    void cancel();
+    bool is_running() const { return _pSubprocess and not _exited; }
+    // the window was closed and no asynchronous operation refers to the run anymore
+    bool is_disposable() const { return not get_visible() and 0 == _pendingOps; }
+
+private:
+    struct CtAsyncData
+    {
+        CtCodeRun*          pCodeRun;
+        std::weak_ptr<bool> alive;
+        bool                isStderr;
+    };
+    static void _on_read_done(GObject* pSource, GAsyncResult* pResult, gpointer pData);
+    static void _on_wait_done(GObject* pSource, GAsyncResult* pResult, gpointer pData);
+
+    void _read_next(const bool isStderr);
+    void _append_output(const char* pData, const size_t numBytes, const bool isStderr, const bool atEnd);
+    void _insert_text(const Glib::ustring& text, const bool isStderr);
+    void _on_exited();
+    void _kill_processes(const bool atOnce);
+    void _op_done();
+
+private:
+    std::string                     _command;
+    int                             _timeoutSecs;
+    std::function<void(CtCodeRun*)> _on_disposable;
+    std::shared_ptr<bool>           _alive{std::make_shared<bool>(true)};
+
+    GSubprocess*                    _pSubprocess{nullptr};
+    GCancellable*                   _pCancellable{nullptr};
+#ifndef _WIN32
+    pid_t                           _processGroup{0};
+#endif
+    int                             _pendingOps{0};
+    bool                            _exited{false};
+    bool                            _timedOut{false};
+    gint64                          _startTime{0};
+    sigc::connection                _timeoutConnection;
+    std::string                     _pendingStdout; // incomplete utf-8 sequence at the end of the latest chunk
+    std::string                     _pendingStderr;
+    size_t                          _outputBytes{0};
+
+    Gtk::VBox                       _vbox;
+    Gtk::ScrolledWindow             _scrolledWindow;
+    Gtk::TextView                   _textView;
+    Glib::RefPtr<Gtk::TextTag>      _rStderrTag;
+    Gtk::HBox                       _hboxStatus;
+    Gtk::Label                      _labelStatus;
+    Gtk::Button                     _buttonCancel;
+    Gtk::Button                     _buttonClose;
+};
@@ -85,18 +85,63 @@ CtCodebox::CtCodebox(CtMainWin* pCtMainWin,
 {
     _ctTextview.get_style_context()->add_class("ct-codebox");
     _ctTextview.set_border_width(1);
+    _ctTextview.set_monospace(true); // todo: remove than styles are implemented
 
     _scrolledwindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
     _scrolledwindow.add(_ctTextview);
-    _frame.add(_scrolledwindow);
+    _scrolledwindow.show_all();
+    _placeholder.signal_draw().connect(sigc::mem_fun(*this, &CtCodebox::_on_placeholder_draw));
+    _frame.add(_placeholder);
     show_all();
 
-    _ctTextview.set_monospace(true); // todo: remove than styles are implemented
-
     set_width_in_pixels(widthInPixels);
     set_highlight_brackets(highlightBrackets);
     set_show_line_numbers(showLineNumbers);
 
+    // before the default handlers, so that the codebox is recorded as it was before the change
+    _rTextBuffer->signal_insert().connect([this](const Gtk::TextBuffer::iterator& pos, const Glib::ustring& text, int bytes) {
+        if (_pCtMainWin->user_active())
+            _pCtMainWin->get_state_machine().widget_text_variation(_pCtMainWin->curr_tree_iter().get_node_id(), text);
+    }, false);
+    _rTextBuffer->signal_erase().connect([this](const Gtk::TextBuffer::iterator& range_start, const Gtk::TextBuffer::iterator& range_end) {
+        if (_pCtMainWin->user_active())
+          _pCtMainWin->get_state_machine().widget_text_variation(_pCtMainWin->curr_tree_iter().get_node_id(), range_start.get_text(range_end));
+    }, false);
+}
+
+CtCodebox::~CtCodebox()
+{
+    _materializeIdleConnection.disconnect();
+}
+
+CtTextView& CtCodebox::get_text_view()
+{
+    _materialize();
+    return _ctTextview;
+}
+
+bool CtCodebox::_on_placeholder_draw(const Cairo::RefPtr<Cairo::Context>& cairoContext)
+{
+    // drawn only when in view, the view replaces the placeholder out of the drawing
+    _placeholder.get_style_context()->render_background(cairoContext, 0, 0, _placeholder.get_allocated_width(), _placeholder.get_allocated_height());
+    if (not _materializeIdleConnection)
+    {
+        _materializeIdleConnection = Glib::signal_idle().connect([this](){
+            _materialize();
+            return false; /* one shot */
+        });
+    }
+    return true;
+}
+
+void CtCodebox::_materialize()
+{
+    if (_materialized) return;
+    _materialized = true;
+    _materializeIdleConnection.disconnect();
+    _frame.remove();
+    _frame.add(_scrolledwindow);
+
     // signals
     _ctTextview.signal_populate_popup().connect([this](Gtk::Menu* menu){
         if (not _pCtMainWin->get_ct_actions()->getCtMainWin()->user_active()) return;
@@ -139,14 +184,6 @@ CtCodebox::CtCodebox(CtMainWin* pCtMainWin,
             _ctTextview.zoom_text(event->delta_y > 0);
         return true;
     });
-    _ctTextview.get_buffer()->signal_insert().connect([this](const Gtk::TextBuffer::iterator& pos, const Glib::ustring& text, int bytes) {
-        if (_pCtMainWin->user_active())
-            _pCtMainWin->get_state_machine().text_variation(_pCtMainWin->curr_tree_iter().get_node_id(), text);
-    });
-    _ctTextview.get_buffer()->signal_erase().connect([this](const Gtk::TextBuffer::iterator& range_start, const Gtk::TextBuffer::iterator& range_end) {
-        if (_pCtMainWin->user_active())
-          _pCtMainWin->get_state_machine().text_variation(_pCtMainWin->curr_tree_iter().get_node_id(), range_start.get_text(range_end));
-    });
     _uCtPairCodeboxMainWin.reset(new CtPairCodeboxMainWin{this, _pCtMainWin});
     g_signal_connect(G_OBJECT(_ctTextview.gobj()), "cut-clipboard", G_CALLBACK(CtClipboard::on_cut_clipboard), _uCtPairCodeboxMainWin.get());
     g_signal_connect(G_OBJECT(_ctTextview.gobj()), "copy-clipboard", G_CALLBACK(CtClipboard::on_copy_clipboard), _uCtPairCodeboxMainWin.get());
@@ -156,14 +193,11 @@ CtCodebox::CtCodebox(CtMainWin* pCtMainWin,
     //_scrolledwindow.get_hscrollbar()->signal_event_after().connect(sigc::mem_fun(*this, &CtCodebox::_onHScrollEventAfter));
 }
 
-CtCodebox::~CtCodebox()
-{
-}
-
 void CtCodebox::apply_width_height(const int parentTextWidth)
 {
     int frameWidth = _widthInPixels ? _frameWidth : (parentTextWidth*_frameWidth)/100;
     _scrolledwindow.set_size_request(frameWidth, _frameHeight);
+    _placeholder.set_size_request(frameWidth, _frameHeight);
 }
 
 void CtCodebox::to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment)
@@ -84,6 +84,7 @@ public:
     void set_highlight_brackets(const bool highlightBrackets);
     void set_show_line_numbers(const bool showLineNumbers);
     void apply_cursor_pos(const int cursorPos);
+    CtTextView& get_text_view(); // materializes the view if still a placeholder
 
     bool get_width_in_pixels() { return _widthInPixels; }
     int  get_frame_width() { return _frameWidth; }
@@ -92,6 +93,8 @@ public:
     bool get_show_line_numbers() { return _showLineNumbers; }
 
 private:
+    void _materialize();
+    bool _on_placeholder_draw(const Cairo::RefPtr<Cairo::Context>& cairoContext);
     bool _on_key_press_event(GdkEventKey* event);
 
 private:
@@ -101,5 +104,9 @@ private:
     bool _highlightBrackets{true};
     bool _showLineNumbers{false};
     Gtk::ScrolledWindow _scrolledwindow;
+    // in the frame instead of the view until the codebox is drawn for the first time
+    Gtk::DrawingArea    _placeholder;
+    bool                _materialized{false};
+    sigc::connection    _materializeIdleConnection;
     bool _key_down;
 };
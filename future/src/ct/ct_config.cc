@@ -302,6 +302,7 @@ void CtConfig::_populate_keyfile_from_data()
     _uKeyFile->set_integer(_currentGroup, "backup_num", backupNum);
     _uKeyFile->set_boolean(_currentGroup, "autosave_on_quit", autosaveOnQuit);
     _uKeyFile->set_integer(_currentGroup, "limit_undoable_steps", limitUndoableSteps);
+    _uKeyFile->set_integer(_currentGroup, "limit_undo_memory_mb", limitUndoMemoryMb);
 
     // [keyboard]
     _currentGroup = "keyboard";
@@ -310,6 +311,8 @@ void CtConfig::_populate_keyfile_from_data()
     // [codexec_term]
     _currentGroup = "codexec_term";
     _uKeyFile->set_string(_currentGroup, "custom_codexec_term", customCodexecTerm);
+    _uKeyFile->set_boolean(_currentGroup, "codexec_in_terminal", codexecInTerminal);
+    _uKeyFile->set_integer(_currentGroup, "codexec_timeout_secs", codexecTimeoutSecs);
 
     // [codexec_type]
     _currentGroup = "codexec_type";
@@ -548,6 +551,7 @@ void CtConfig::_populate_data_from_keyfile()
     _populate_int_from_keyfile("backup_num", &backupNum);
     _populate_bool_from_keyfile("autosave_on_quit", &autosaveOnQuit);
     _populate_int_from_keyfile("limit_undoable_steps", &limitUndoableSteps);
+    _populate_int_from_keyfile("limit_undo_memory_mb", &limitUndoMemoryMb);
 
     // [keyboard]
     _currentGroup = "keyboard";
@@ -556,6 +560,8 @@ void CtConfig::_populate_data_from_keyfile()
     // [codexec_term]
     _currentGroup = "codexec_term";
     _populate_string_from_keyfile("custom_codexec_term", &customCodexecTerm);
+    _populate_bool_from_keyfile("codexec_in_terminal", &codexecInTerminal);
+    _populate_int_from_keyfile("codexec_timeout_secs", &codexecTimeoutSecs);
 
     // [codexec_type]
     _currentGroup = "codexec_type";
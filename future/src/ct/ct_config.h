@@ -171,12 +171,15 @@ public:
     int                                         backupNum{3};
     bool                                        autosaveOnQuit{false};
     int                                         limitUndoableSteps{20};
+    int                                         limitUndoMemoryMb{200};
 
     // [keyboard]
     std::map<std::string, std::string>          customKbShortcuts;
 
     // [codexec_term]
     std::string                                 customCodexecTerm;
+    bool                                        codexecInTerminal{false};
+    int                                         codexecTimeoutSecs{0};
 
     // [codexec_type]
     std::map<std::string, std::string>          customCodexecType;
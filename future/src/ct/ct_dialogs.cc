@@ -634,6 +634,7 @@ void CtDialogs::match_dialog(const Glib::ustring& title,
     CtAction* pAction = ctMainWin.get_ct_menu().find_action("toggle_show_allmatches_dlg");
     Gtk::Button* pButtonHide = pAllMatchesDialog->add_button(str::format(_("Hide (Restore with '%s')"), pAction->get_shortcut(ctMainWin.get_ct_config())), Gtk::RESPONSE_CLOSE);
     pButtonHide->set_image_from_icon_name(Gtk::Stock::CLOSE.id, Gtk::ICON_SIZE_BUTTON);
+    rModel->flush_pending_rows(); // before the view is attached, no redraw per row
     Gtk::TreeView* pTreeview = Gtk::manage(new Gtk::TreeView(rModel));
     pTreeview->append_column(_("Node Name"), rModel->columns.node_name);
     pTreeview->append_column(_("Line"), rModel->columns.line_num);
@@ -641,6 +642,21 @@ void CtDialogs::match_dialog(const Glib::ustring& title,
     pTreeview->append_column("", rModel->columns.node_hier_name);
     pTreeview->get_column(3)->property_visible() = false;
     pTreeview->set_tooltip_column(3);
+    // rows of one line each: with fixed sizes only the visible rows get measured
+    const std::array<int, 4> columnsWidths{150, 60, 400, 10};
+    for (int i = 0; i < 4; ++i)
+    {
+        Gtk::TreeViewColumn* pColumn = pTreeview->get_column(i);
+        pColumn->set_sizing(Gtk::TREE_VIEW_COLUMN_FIXED);
+        pColumn->set_fixed_width(columnsWidths[i]);
+        pColumn->set_resizable(true);
+        if (auto pCellRendererText = dynamic_cast<Gtk::CellRendererText*>(pColumn->get_first_cell()))
+        {
+            pCellRendererText->property_ellipsize() = Pango::ELLIPSIZE_END;
+        }
+    }
+    pTreeview->get_column(2)->set_expand(true);
+    pTreeview->set_fixed_height_mode(true);
     Gtk::ScrolledWindow* pScrolledwindowAllmatches = Gtk::manage(new Gtk::ScrolledWindow());
     pScrolledwindowAllmatches->set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
     pScrolledwindowAllmatches->add(*pTreeview);
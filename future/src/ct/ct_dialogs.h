@@ -150,6 +150,48 @@ public:
         row[columns.line_num] = line_num;
         row[columns.line_content] = line_content;
     }
+    // rows collected while searching, appended by flush_pending_rows() before the model is shown
+    void add_pending_row(gint64 node_id,
+                         const Glib::ustring& node_name,
+                         const Glib::ustring& node_hier_name,
+                         int start_offset,
+                         int end_offset,
+                         int line_num,
+                         const Glib::ustring& line_content)
+    {
+        _pendingRows.push_back(CtMatchRow{node_id, node_name, node_hier_name, start_offset, end_offset, line_num, line_content});
+    }
+    void flush_pending_rows()
+    {
+        for (const CtMatchRow& pendingRow : _pendingRows)
+        {
+            // one insertion with all the values instead of an append followed by a change per column
+            GtkTreeIter iter;
+            gtk_tree_store_insert_with_values(gobj(), &iter, nullptr/*parent*/, -1/*position*/,
+                                              columns.node_id.index(), pendingRow.node_id,
+                                              columns.node_name.index(), pendingRow.node_name.c_str(),
+                                              columns.node_hier_name.index(), pendingRow.node_hier_name.c_str(),
+                                              columns.start_offset.index(), pendingRow.start_offset,
+                                              columns.end_offset.index(), pendingRow.end_offset,
+                                              columns.line_num.index(), pendingRow.line_num,
+                                              columns.line_content.index(), pendingRow.line_content.c_str(),
+                                              -1);
+        }
+        _pendingRows.clear();
+    }
+
+private:
+    struct CtMatchRow
+    {
+        gint64        node_id;
+        Glib::ustring node_name;
+        Glib::ustring node_hier_name;
+        int           start_offset;
+        int           end_offset;
+        int           line_num;
+        Glib::ustring line_content;
+    };
+    std::vector<CtMatchRow> _pendingRows;
 };
 
 namespace CtDialogs {
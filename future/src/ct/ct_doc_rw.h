@@ -23,6 +23,7 @@
 
 #include <libxml++/libxml++.h>
 #include <sqlite3.h>
+#include <memory>
 #include <gtkmm.h>
 #include "ct_treestore.h"
 #include "ct_table.h"
@@ -113,6 +114,9 @@ public:
     Glib::RefPtr<Gsv::Buffer> get_text_buffer(const std::string& syntax,
                                               std::list<CtAnchoredWidget*>& anchoredWidgets,
                                               const gint64& nodeId) const;
+    // searchable text of the nodes (text, codeboxes, table cells, image names) without building the text buffers
+    bool read_nodes_search_text(const std::set<gint64>& nodeIds,
+                                const std::function<void(const gint64, const std::string&)>& callback) const;
     void pending_edit_db_bookmarks();
     void pending_edit_db_node_prop(const gint64 node_id);
     void pending_edit_db_node_buff(const gint64 node_id);
@@ -174,6 +178,9 @@ protected:
     bool _exec_no_callback(const char* sqlCmd);
     bool _exec_bind_int64(const char* sqlCmd, const gint64 bind_int64);
     bool _remove_db_node_n_children(const gint64 node_id);
+    gint64 _get_max_image_rowid();
+    bool _remove_db_images(const gint64 node_id, const gint64 max_rowid);
+    bool _vacuum();
     bool _create_all_tables();
     bool _write_db_node(CtTreeIter ct_tree_iter,
                         const gint64 sequence,
@@ -184,6 +191,7 @@ protected:
     bool _write_db_bookmarks(const std::list<gint64>& bookmarks);
 
     sqlite3* _pDb{nullptr};
+    std::shared_ptr<sqlite3> _spDb; // also held by the embedded files read on demand
     bool     _dbOpenOk{false};
     CtSyncPending _syncPending;
 };
@@ -24,6 +24,9 @@
 #include "ct_main_win.h"
 #include "ct_dialogs.h"
 #include <fstream>
+#include <deque>
+#include <thread>
+#include <glib/gstdio.h>
 
 CtExport2Html::CtExport2Html(CtMainWin* pCtMainWin)
  : _pCtMainWin(pCtMainWin)
@@ -40,7 +43,9 @@ bool CtExport2Html::prepare_html_folder(Glib::ustring dir_place, Glib::ustring n
             return false;
     }
     new_folder = CtMiscUtil::clean_from_chars_not_for_filename(new_folder) + "_HTML";
-    new_folder = CtFileSystem::prepare_export_folder(dir_place, new_folder, export_overwrite);
+    // an existing folder is updated in place, only the changed nodes are written again (see the export manifest)
+    if (!export_overwrite || !Glib::file_test(Glib::build_filename(dir_place, new_folder), Glib::FILE_TEST_IS_DIR))
+        new_folder = CtFileSystem::prepare_export_folder(dir_place, new_folder, export_overwrite);
     _export_dir = Glib::build_filename(dir_place, new_folder);
     _images_dir = Glib::build_filename(_export_dir, "images");
     _embed_dir = Glib::build_filename(_export_dir, "EmbeddedFiles");
@@ -63,6 +68,10 @@ bool CtExport2Html::prepare_html_folder(Glib::ustring dir_place, Glib::ustring n
     {
         throw "put script file into .config folder (or export by pygtk version)"; // todo: CtFileSystem::copy_file(Glib::build_filename(CtConst::GLADE_PATH, "styles3.css"), styles_css_filepath);
     }
+    if (Glib::file_get_contents(styles_js_filepath).find("buildTreeIndex") == std::string::npos)
+    {
+        std::cerr << "!! " << styles_js_filepath << " predates the tree index, copy it again from glade/script3.js" << std::endl;
+    }
     CtFileSystem::copy_file(styles_js_filepath, Glib::build_filename(_res_dir, "script3.js"));
 
     export_path = _export_dir;
@@ -71,10 +80,24 @@ bool CtExport2Html::prepare_html_folder(Glib::ustring dir_place, Glib::ustring n
 }
 
 // Export a Node To HTML
-void CtExport2Html::node_export_to_html(CtTreeIter tree_iter, const CtExportOptions& options, const Glib::ustring& index, int sel_start, int sel_end)
+void CtExport2Html::node_export_to_html(CtTreeIter tree_iter, const CtExportOptions& options, const bool with_index, int sel_start, int sel_end)
+{
+    CtHtmlPage page = _get_node_page(tree_iter, options, with_index, sel_start, sel_end);
+    Glib::ustring html_text = _render_page(page);
+    g_file_set_contents(page.filepath.c_str(), html_text.c_str(), (gssize)html_text.bytes(), nullptr);
+    _wait_images_written();
+}
+
+// Takes from the node all that is needed to write its page, must run on the main thread
+CtHtmlPage CtExport2Html::_get_node_page(CtTreeIter tree_iter, const CtExportOptions& options, const bool with_index, int sel_start, int sel_end)
 {
-    Glib::ustring html_text = str::format(HTML_HEADER, tree_iter.get_node_name());
-    if (index != "" && options.index_in_page)
+    CtHtmlPage page;
+    _nodeFiles.clear();
+    _nodeLinks.clear();
+    _nodeFiles.push_back(_get_html_filename(tree_iter));
+    page.filepath = Glib::filename_from_utf8(Glib::build_filename(_export_dir, _nodeFiles.front()));
+    page.head = str::format(HTML_HEADER, tree_iter.get_node_name());
+    if (with_index && options.index_in_page)
     {
         auto script = R"HTML(
             <script type='text/javascript'>
@@ -84,46 +107,93 @@ void CtExport2Html::node_export_to_html(CtTreeIter tree_iter, const CtExportOpti
                     window.location = 'index.html#' + page;
                 }
             </script>)HTML";
-        html_text = str::replace(html_text, "<script></script>", script);
+        page.head = str::replace(page.head, "<script></script>", script);
     }
-    html_text += "<div class='page'>";
+    page.head += "<div class='page'>";
     if (options.include_node_name)
-        html_text += "<h1 class='title'>" + tree_iter.get_node_name() + "</h1><br/>";
+        page.head += "<h1 class='title'>" + tree_iter.get_node_name() + "</h1><br/>";
 
-    std::vector<Glib::ustring> html_slots;
-    std::vector<CtAnchoredWidget*> widgets;
     if (tree_iter.get_node_is_rich_text())
     {
-        _html_get_from_treestore_node(tree_iter, sel_start, sel_end, html_slots, widgets);
+        std::vector<CtAnchoredWidget*> widgets;
+        _html_get_from_treestore_node(tree_iter, sel_start, sel_end, page.slots, widgets);
         int images_count = 0;
-        for (size_t i = 0; i < html_slots.size(); ++i)
+        for (CtAnchoredWidget* widget : widgets)
         {
-            html_text += html_slots[i];
-            if (i < widgets.size())
+            if (CtImageEmbFile* embfile = dynamic_cast<CtImageEmbFile*>(widget))
             {
-                if (CtImageEmbFile* embfile = dynamic_cast<CtImageEmbFile*>(widgets[i]))
-                    html_text += _get_embfile_html(embfile, tree_iter, _embed_dir);
-                else if (CtImage* image = dynamic_cast<CtImage*>(widgets[i]))
-                    html_text += _get_image_html(image, _images_dir, images_count, &tree_iter);
-                else if (CtTable* table = dynamic_cast<CtTable*>(widgets[i]))
-                    html_text += _get_table_html(table);
-                else if (CtCodebox* codebox = dynamic_cast<CtCodebox*>(widgets[i]))
-                    html_text += _get_codebox_html(codebox);
+                page.widgetsHtml.push_back("");
+                page.widgetsEmbFiles[page.widgetsHtml.size() - 1] = _get_embfile(embfile, _embed_dir);
             }
+            else if (CtImage* image = dynamic_cast<CtImage*>(widget))
+            {
+                CtHtmlImage pageImage;
+                page.widgetsHtml.push_back(_get_image_html(image, _images_dir, images_count, &pageImage));
+                if (pageImage.checksum.valid())
+                    page.widgetsImages[page.widgetsHtml.size() - 1] = pageImage;
+            }
+            else if (CtTable* table = dynamic_cast<CtTable*>(widget))
+                page.widgetsHtml.push_back(_get_table_html(table));
+            else if (CtCodebox* codebox = dynamic_cast<CtCodebox*>(widget))
+                page.widgetsHtml.push_back(_get_codebox_html(codebox));
+            else
+                page.widgetsHtml.push_back("");
         }
     }
     else
-        html_text += _html_get_from_code_buffer(tree_iter.get_node_text_buffer(), sel_start, sel_end);
+        page.head += _html_get_from_code_buffer(tree_iter.get_node_text_buffer(), sel_start, sel_end);
 
-    if (index != "" && !options.index_in_page)
-        html_text += Glib::ustring("<p align=\"center\">") + Glib::build_filename("images", "home.png") +
+    if (with_index && !options.index_in_page)
+        page.tail += Glib::ustring("<p align=\"center\">") + Glib::build_filename("images", "home.png") +
                 "<img src=\"" "\" height=\"22\" width=\"22\">" +
                 CtConst::CHAR_SPACE + CtConst::CHAR_SPACE + "<a href=\"index.html\">\"" + _("Index") + "</a></p>";
-    html_text += "</div>"; // div class='page'
-    html_text += HTML_FOOTER;
+    page.tail += "</div>"; // div class='page'
+    page.tail += HTML_FOOTER;
+    page.files = std::move(_nodeFiles);
+    page.links = std::move(_nodeLinks);
+    return page;
+}
 
-    Glib::ustring node_html_filepath = Glib::build_filename(_export_dir, _get_html_filename(tree_iter));
-    g_file_set_contents(node_html_filepath.c_str(), html_text.c_str(), (gssize)html_text.bytes(), nullptr);
+// Renders the rich text of the page, does not touch gtk so can run on any thread
+Glib::ustring CtExport2Html::_render_page(CtHtmlPage& page)
+{
+    Glib::ustring html_text = page.head;
+    for (size_t i = 0; i < page.slots.size(); ++i)
+    {
+        html_text += _html_render_slot(page.slots[i]);
+        auto itImage = page.widgetsImages.find(i);
+        auto itEmbFile = page.widgetsEmbFiles.find(i);
+        if (itImage != page.widgetsImages.end())
+        {
+            // waits for the png to be hashed, queued with all the other images of the export
+            const Glib::ustring image_rel_path = Glib::build_filename("images", _get_image_name(itImage->second.checksum.get()));
+            page.files.push_back(image_rel_path);
+            html_text += _get_image_tag(image_rel_path, itImage->second.linked, itImage->second.href);
+        }
+        else if (itEmbFile != page.widgetsEmbFiles.end())
+        {
+            // waits for the file to be hashed, like the images
+            const Glib::ustring embfile_rel_path = Glib::build_filename("EmbeddedFiles", _get_embfile_name(itEmbFile->second.checksum.get(), itEmbFile->second.fileName));
+            page.files.push_back(embfile_rel_path);
+            html_text += _get_embfile_tag(embfile_rel_path, itEmbFile->second);
+        }
+        else if (i < page.widgetsHtml.size())
+            html_text += page.widgetsHtml[i];
+    }
+    html_text += page.tail;
+    return html_text;
+}
+
+// Writes the file unless it exists already with the same content, does not touch gtk so can run on any thread
+bool CtExport2Html::_write_if_changed(const std::string& filepath, const Glib::ustring& html_text, const std::string& prev_hash, std::string& hash)
+{
+    const std::string new_hash = Glib::Checksum::compute_checksum(Glib::Checksum::CHECKSUM_SHA256, html_text.raw());
+    const bool unchanged = new_hash == prev_hash and Glib::file_test(filepath, Glib::FILE_TEST_IS_REGULAR);
+    hash = new_hash; // may be the same string as prev_hash
+    if (unchanged)
+        return false;
+    g_file_set_contents(filepath.c_str(), html_text.c_str(), (gssize)html_text.bytes(), nullptr);
+    return true;
 }
 
 // Export All Nodes To HTML
@@ -131,22 +201,28 @@ void CtExport2Html::nodes_all_export_to_html(bool all_tree, const CtExportOption
 {
     // todo: shutil.copy(os.path.join(cons.GLADE_PATH, "home.png"), self.images_dir)
 
-    // create tree links text
+    // the tree of links is written once in res/tree_index.js, res/script3.js turns it into the index;
+    // without scripts the index page lists the top level nodes only
+    Glib::ustring tree_index_json;
+    Glib::ustring tree_index_noscript;
+    CtTreeIter tree_iter = all_tree ? _pCtMainWin->curr_tree_store().get_ct_iter_first() : _pCtMainWin->curr_tree_iter();
+    for (;tree_iter; ++tree_iter)
+    {
+        if (!tree_index_json.empty()) tree_index_json += ",\n";
+        _tree_index_json_iter(tree_iter, tree_index_json);
+        tree_index_noscript += "<li><a href='" + str::xml_escape(_get_html_filename(tree_iter)) + "'>" + str::xml_escape(tree_iter.get_node_name()) + "</a></li>\n";
+        if (!all_tree) break;
+    }
+    const Glib::ustring tree_index_js = "var treeIndex = [\n" + tree_index_json + "\n];\n";
     Glib::ustring tree_links_text = // dont' use R"HTML, it gives unnecessary " "
           "<div class='tree'>\n"
           "<p>\n"
           "<strong>Index</strong></br>\n"
           "<button onclick='expandAllSubtrees()'>Expand All</button> <button onclick='collapseAllSubtrees()'>Collapse All</button>\n"
           "</p>\n"
-          "<ul class='outermost'>\n";
-    CtTreeIter tree_iter = all_tree ? _pCtMainWin->curr_tree_store().get_ct_iter_first() : _pCtMainWin->curr_tree_iter();
-    for (;tree_iter; ++tree_iter)
-    {
-        _tree_links_text_iter(tree_iter, tree_links_text, 1, options.index_in_page);
-        if (!all_tree) break;
-    }
-    tree_links_text += "</ul>\n";
-    tree_links_text += "</div>\n";
+          "<ul class='outermost' id='tree_index'></ul>\n"
+          "<noscript><ul class='outermost'>\n" + tree_index_noscript + "</ul></noscript>\n"
+          "</div>\n";
 
     // create index html page
     Glib::ustring html_text = str::format(HTML_HEADER, _pCtMainWin->get_curr_doc_file_name());
@@ -160,55 +236,263 @@ void CtExport2Html::nodes_all_export_to_html(bool all_tree, const CtExportOption
     }
     else
         html_text += "<div class='page'>" + tree_links_text + "</div>";
+    html_text += "<script src='res/tree_index.js'></script>\n";
     html_text += "<script src='res/script3.js'></script>\n";
     html_text += HTML_FOOTER;
-    Glib::ustring node_html_filepath = Glib::build_filename(_export_dir, "index.html");
-    g_file_set_contents(node_html_filepath.c_str(), html_text.c_str(), (gssize)html_text.bytes(), nullptr);
 
-    // create html pages
-    // function to iterate nodes
+    // a previous export to the same folder tells which nodes have not changed since
+    const std::string options_id = _get_options_id(options);
+    std::string index_hash, tree_index_hash;
+    CtHtmlManifest prev_manifest;
+    const bool incremental = _load_manifest(options_id, index_hash, tree_index_hash, prev_manifest);
+    _write_if_changed(Glib::filename_from_utf8(Glib::build_filename(_export_dir, "index.html")), html_text, index_hash, index_hash);
+    _write_if_changed(Glib::filename_from_utf8(Glib::build_filename(_res_dir, "tree_index.js")), tree_index_js, tree_index_hash, tree_index_hash);
+
+    // the nodes to export, in the order of the tree
+    std::vector<CtTreeIter> node_iters;
     std::function<void(CtTreeIter)> traverseFunc;
-    traverseFunc = [this, &traverseFunc, &options, &tree_links_text](CtTreeIter tree_iter) {
-        node_export_to_html(tree_iter, options, tree_links_text, -1, -1);
+    traverseFunc = [this, &traverseFunc, &node_iters](CtTreeIter tree_iter) {
+        node_iters.push_back(tree_iter);
         for (auto& child: tree_iter->children())
             traverseFunc(_pCtMainWin->curr_tree_store().to_ct_tree_iter(child));
     };
-    // start to iterarte nodes
     tree_iter = all_tree ? _pCtMainWin->curr_tree_store().get_ct_iter_first() : _pCtMainWin->curr_tree_iter();
     for (;tree_iter; ++tree_iter)
     {
         traverseFunc(tree_iter);
         if (!all_tree) break;
     }
+    std::unordered_map<gint64, Glib::ustring> filenames;
+    for (CtTreeIter& node_iter : node_iters)
+        filenames[node_iter.get_node_id()] = _get_html_filename(node_iter);
+
+    // the page of a node is rendered again if the node was saved since, if it was renamed or moved,
+    // or if a node it links to was renamed, moved or removed
+    g_autoptr(GDateTime) pGDateTime = g_date_time_new_now_local();
+    const gint64 export_ts = g_date_time_to_unix(pGDateTime);
+    auto is_node_unchanged = [&](CtTreeIter& node_iter, const CtHtmlManifestNode& prev_node) {
+        if (prev_node.tsLastSave != node_iter.get_node_modification_time() or
+            prev_node.tsLastSave >= prev_node.tsExport or // possibly changed again within the same second
+            prev_node.name != node_iter.get_node_name() or
+            prev_node.filename != filenames.at(node_iter.get_node_id()) or
+            prev_node.syntax != node_iter.get_node_syntax_highlighting() or
+            not Glib::file_test(Glib::build_filename(_export_dir, prev_node.filename), Glib::FILE_TEST_IS_REGULAR))
+        {
+            return false;
+        }
+        for (const gint64 link_node_id : prev_node.links)
+        {
+            auto itLinked = prev_manifest.find(link_node_id);
+            auto itFilename = filenames.find(link_node_id);
+            if (itLinked == prev_manifest.end() or itFilename == filenames.end() or itLinked->second->filename != itFilename->second)
+                return false;
+        }
+        return true;
+    };
+
+    // create html pages: the nodes content is taken on the main thread while
+    // the worker threads render and write the pages taken so far
+    CtStatusBar& ctStatusBar = _pCtMainWin->get_status_bar();
+    ctStatusBar.progressBar.set_fraction(0);
+    ctStatusBar.progressBar.set_text("0");
+    ctStatusBar.progressBar.show();
+    ctStatusBar.stopButton.show();
+    ctStatusBar.set_progress_stop(false);
+    // the nodes are not to be edited, moved or removed while the iters are held
+    _pCtMainWin->set_busy(true);
+    while (gtk_events_pending()) gtk_main_iteration();
+
+    const size_t maxPagesPending = 4 * std::max(1u, std::thread::hardware_concurrency());
+    std::deque<std::future<void>> pagesWritten;
+    CtHtmlManifest manifest;
+    gint64 latestProgressTime = g_get_monotonic_time();
+    for (size_t i = 0; i < node_iters.size(); ++i)
+    {
+        CtTreeIter& node_iter = node_iters[i];
+        const gint64 node_id = node_iter.get_node_id();
+        auto itPrev = prev_manifest.find(node_id);
+        if (incremental and itPrev != prev_manifest.end() and is_node_unchanged(node_iter, *itPrev->second))
+        {
+            manifest[node_id] = itPrev->second;
+        }
+        else
+        {
+            auto pPage = std::make_shared<CtHtmlPage>(_get_node_page(node_iter, options, true/*with_index*/, -1, -1));
+            auto pNode = std::make_shared<CtHtmlManifestNode>();
+            pNode->tsLastSave = node_iter.get_node_modification_time();
+            pNode->tsExport = export_ts;
+            pNode->name = node_iter.get_node_name();
+            pNode->filename = pPage->files.front();
+            pNode->syntax = node_iter.get_node_syntax_highlighting();
+            pNode->links.assign(pPage->links.begin(), pPage->links.end());
+            if (itPrev != prev_manifest.end())
+                pNode->hash = itPrev->second->hash;
+            manifest[node_id] = pNode;
+            // the hash and the files of the node are only read again once all the pages are written
+            pagesWritten.push_back(_pCtMainWin->get_image_cache().run_async([pPage, pNode](){
+                _write_if_changed(pPage->filepath, _render_page(*pPage), pNode->hash, pNode->hash);
+                pNode->files = pPage->files;
+            }));
+        }
+        // bounds the memory held by the pages not written yet
+        while (pagesWritten.size() >= maxPagesPending)
+        {
+            pagesWritten.front().wait();
+            pagesWritten.pop_front();
+        }
+        if (g_get_monotonic_time() - latestProgressTime > 100000)
+        {
+            latestProgressTime = g_get_monotonic_time();
+            ctStatusBar.progressBar.set_fraction(double(i + 1)/double(node_iters.size()));
+            ctStatusBar.progressBar.set_text(std::to_string(i + 1) + "/" + std::to_string(node_iters.size()));
+            while (gtk_events_pending()) gtk_main_iteration();
+        }
+        if (ctStatusBar.is_progress_stop()) break;
+    }
+    for (std::future<void>& pageWritten : pagesWritten)
+        pageWritten.wait();
+    _wait_images_written();
+
+    // the nodes not reached if stopped keep what was written for them
+    for (auto& prev_node : prev_manifest)
+        if (not manifest.count(prev_node.first) and filenames.count(prev_node.first))
+            manifest[prev_node.first] = prev_node.second;
+    _remove_stale_files(prev_manifest, manifest);
+    _save_manifest(options_id, export_ts, index_hash, tree_index_hash, manifest);
+
+    _pCtMainWin->set_busy(false);
+    ctStatusBar.progressBar.hide();
+    ctStatusBar.stopButton.hide();
+    ctStatusBar.set_progress_stop(false);
 }
 
-// Creating the Tree Links Text - iter
-void CtExport2Html::_tree_links_text_iter(CtTreeIter tree_iter, Glib::ustring& tree_links_text, int tree_count_level, bool index_in_page)
+// Identifies what changes all the pages, the manifest of an export with a different id is not used
+std::string CtExport2Html::_get_options_id(const CtExportOptions& options)
 {
-    Glib::ustring href = _get_html_filename(tree_iter);
-    Glib::ustring node_name = tree_iter.get_node_name();
-    if (tree_iter->children().empty())
+    return std::to_string(MANIFEST_VERSION) + "-" + std::to_string(options.include_node_name) + "-" + std::to_string(options.index_in_page);
+}
+
+// Loads the manifest of a previous export to the same folder, false if none or not usable
+bool CtExport2Html::_load_manifest(const std::string& options_id, std::string& index_hash, std::string& tree_index_hash, CtHtmlManifest& manifest)
+{
+    const std::string manifest_filepath = Glib::build_filename(_export_dir, MANIFEST_FILENAME);
+    if (not Glib::file_test(manifest_filepath, Glib::FILE_TEST_IS_REGULAR))
+        return false;
+    Glib::KeyFile keyFile;
+    try
     {
-        if (index_in_page)
-            tree_links_text += "<li class='leaf'><a href='#' onclick=\"changeFrame('" + href + "')\">" + node_name + "</a></li>\n";
-        else
-            tree_links_text += "<li class='leaf'><a href='" + href + "'>" + node_name + "</a></li>\n";
+        keyFile.load_from_file(manifest_filepath);
+        index_hash = keyFile.get_string("export", "index_hash");
+        tree_index_hash = keyFile.get_string("export", "tree_index_hash");
+        for (const Glib::ustring& group : keyFile.get_groups())
+        {
+            if (not str::startswith(group, "node_")) continue;
+            auto pNode = std::make_shared<CtHtmlManifestNode>();
+            pNode->tsLastSave = keyFile.get_int64(group, "ts_lastsave");
+            pNode->tsExport = keyFile.get_int64(group, "ts_export");
+            pNode->name = keyFile.get_string(group, "name");
+            pNode->filename = keyFile.get_string(group, "filename");
+            pNode->syntax = keyFile.get_string(group, "syntax");
+            pNode->hash = keyFile.get_string(group, "hash");
+            for (const Glib::ustring& file : keyFile.get_string_list(group, "files"))
+                pNode->files.push_back(file);
+            for (const Glib::ustring& link : keyFile.get_string_list(group, "links"))
+                pNode->links.push_back(CtStrUtil::gint64_from_gstring(link.c_str()));
+            manifest[CtStrUtil::gint64_from_gstring(group.c_str() + 5)] = pNode;
+        }
+        if (keyFile.get_string("export", "options") != options_id)
+        {
+            // all the pages are rendered again but the files of the removed nodes are still known
+            index_hash.clear();
+            tree_index_hash.clear();
+            return false;
+        }
     }
-    else
+    catch (Glib::Error& error)
     {
-        if (index_in_page)
-            tree_links_text += "<li><button onclick='toggleSubTree(this)'>-</button> <a href='#' onclick=\"changeFrame('" + href + "')\">" + node_name + "</a></li>";
-        else
-            tree_links_text += "<li><button onclick='toggleSubTree(this)'>-</button> <a href='" + href + "'>" + node_name +"</a></li>";
-        tree_links_text += "<ul class='subtree'>\n";
+        std::cerr << "!! " << manifest_filepath << ": " << error.what() << std::endl;
+        manifest.clear();
+        return false;
+    }
+    return true;
+}
+
+void CtExport2Html::_save_manifest(const std::string& options_id, const gint64 export_ts, const std::string& index_hash, const std::string& tree_index_hash,
+                                   const CtHtmlManifest& manifest)
+{
+    Glib::KeyFile keyFile;
+    keyFile.set_string("export", "options", options_id);
+    keyFile.set_int64("export", "ts", export_ts);
+    keyFile.set_string("export", "index_hash", index_hash);
+    keyFile.set_string("export", "tree_index_hash", tree_index_hash);
+    for (const auto& node : manifest)
+    {
+        const Glib::ustring group = "node_" + std::to_string(node.first);
+        keyFile.set_int64(group, "ts_lastsave", node.second->tsLastSave);
+        keyFile.set_int64(group, "ts_export", node.second->tsExport);
+        keyFile.set_string(group, "name", node.second->name);
+        keyFile.set_string(group, "filename", node.second->filename);
+        keyFile.set_string(group, "syntax", node.second->syntax);
+        keyFile.set_string(group, "hash", node.second->hash);
+        keyFile.set_string_list(group, "files", std::vector<Glib::ustring>(node.second->files.begin(), node.second->files.end()));
+        std::vector<Glib::ustring> links;
+        for (const gint64 link : node.second->links)
+            links.push_back(std::to_string(link));
+        keyFile.set_string_list(group, "links", links);
+    }
+    const std::string manifest_filepath = Glib::build_filename(_export_dir, MANIFEST_FILENAME);
+    try
+    {
+        keyFile.save_to_file(manifest_filepath);
+    }
+    catch (Glib::Error& error)
+    {
+        std::cerr << "!! " << manifest_filepath << ": " << error.what() << std::endl;
+    }
+}
+
+// Deletes the files written by a previous export that are not written anymore,
+// only once all the pages are written since a file may have passed to another node
+void CtExport2Html::_remove_stale_files(const CtHtmlManifest& prev_manifest, const CtHtmlManifest& manifest)
+{
+    std::unordered_set<std::string> kept_files;
+    for (const auto& node : manifest)
+        kept_files.insert(node.second->files.begin(), node.second->files.end());
+    for (const auto& prev_node : prev_manifest)
+        for (const std::string& file : prev_node.second->files)
+            if (not kept_files.count(file))
+                g_remove(Glib::filename_from_utf8(Glib::build_filename(_export_dir, file)).c_str());
+}
+
+// The image files of all the exported nodes are written in parallel, wait for them to be complete
+void CtExport2Html::_wait_images_written()
+{
+    for (std::future<void>& imageWritten : _imagesWritten)
+        imageWritten.wait();
+    _imagesWritten.clear();
+}
+
+// Creating the Tree Index - iter: {"n":node name,"h":page filename,"c":[children]}
+void CtExport2Html::_tree_index_json_iter(CtTreeIter tree_iter, Glib::ustring& tree_index_json)
+{
+    tree_index_json += "{\"n\":\"" + str::json_escape(tree_iter.get_node_name()) + "\",\"h\":\"" + str::json_escape(_get_html_filename(tree_iter)) + "\"";
+    if (!tree_iter->children().empty())
+    {
+        tree_index_json += ",\"c\":[\n";
+        bool first = true;
         for (auto& child: tree_iter->children())
-            _tree_links_text_iter(_pCtMainWin->curr_tree_store().to_ct_tree_iter(child), tree_links_text, tree_count_level + 1, index_in_page);
-        tree_links_text += "</ul>\n";
+        {
+            if (!first) tree_index_json += ",\n";
+            first = false;
+            _tree_index_json_iter(_pCtMainWin->curr_tree_store().to_ct_tree_iter(child), tree_index_json);
+        }
+        tree_index_json += "]";
     }
+    tree_index_json += "}";
 }
 
-// Returns the HTML given the text buffer and iter bounds
-Glib::ustring CtExport2Html::selection_export_to_html(Glib::RefPtr<Gtk::TextBuffer> text_buffer, Gtk::TextIter start_iter,
+// Returns the HTML given the node, its text buffer and iter bounds
+Glib::ustring CtExport2Html::selection_export_to_html(CtTreeIter tree_iter, Glib::RefPtr<Gtk::TextBuffer> text_buffer, Gtk::TextIter start_iter,
                                                       Gtk::TextIter end_iter, const Glib::ustring& syntax_highlighting)
 {
     Glib::ustring html_text = str::format(HTML_HEADER, "");
@@ -218,7 +502,7 @@ Glib::ustring CtExport2Html::selection_export_to_html(Glib::RefPtr<Gtk::TextBuff
         Glib::ustring tempFolder = _pCtMainWin->get_ct_tmp()->getHiddenDirPath("IMAGE_TEMP_FOLDER");
 
         int start_offset = start_iter.get_offset();
-        std::list<CtAnchoredWidget*> widgets = _pCtMainWin->curr_tree_iter().get_embedded_pixbufs_tables_codeboxes(std::make_pair(start_iter.get_offset(), end_iter.get_offset()));
+        std::list<CtAnchoredWidget*> widgets = tree_iter.get_embedded_pixbufs_tables_codeboxes(std::make_pair(start_iter.get_offset(), end_iter.get_offset()));
         for (CtAnchoredWidget* widget: widgets)
         {
             int end_offset = widget->getOffset();
@@ -236,6 +520,7 @@ Glib::ustring CtExport2Html::selection_export_to_html(Glib::RefPtr<Gtk::TextBuff
         html_text += _html_get_from_code_buffer(gsv_buffer, start_iter.get_offset(), end_iter.get_offset());
     }
     html_text += HTML_FOOTER;
+    _wait_images_written();
     return html_text;
 }
 
@@ -257,53 +542,137 @@ Glib::ustring CtExport2Html::codebox_export_to_html(CtCodebox* codebox)
     return html_text;
 }
 
-// Returns the HTML embedded file
-Glib::ustring CtExport2Html::_get_embfile_html(CtImageEmbFile* embfile, CtTreeIter tree_iter, Glib::ustring embed_dir)
+// Queues the hashing and the writing of the embedded file on the worker threads, the file is named by its contents
+CtHtmlEmbFile CtExport2Html::_get_embfile(CtImageEmbFile* embfile, const Glib::ustring& embed_dir)
 {
-    Glib::ustring embfile_align_text = _get_object_alignment_string(embfile->getJustification());
-    Glib::ustring embfile_name = std::to_string(tree_iter.get_node_id()) + "-" +  embfile->get_file_name();
-    Glib::ustring embfile_rel_path = Glib::build_filename("EmbeddedFiles", embfile_name);
-    Glib::ustring embfile_html = "<table style=\"" + embfile_align_text + "\"><tr><td><a href=\"" +
-            embfile_rel_path + "\">Linked file: " + embfile->get_file_name() + " </a></td></tr></table>";
+    CtHtmlEmbFile pageEmbFile{{}, embfile->get_file_name(), _get_object_alignment_string(embfile->getJustification())};
+    // the same file embedded in many nodes is hashed and written once
+    std::shared_ptr<CtEmbFileBlob> pBlob = embfile->get_raw_blob();
+    auto itChecksum = _embfileChecksums.find(pBlob.get());
+    if (itChecksum != _embfileChecksums.end())
+    {
+        pageEmbFile.checksum = itChecksum->second.second;
+    }
+    else
+    {
+        pageEmbFile.checksum = _pCtMainWin->get_image_cache().checksum_embfile(pBlob);
+        _embfileChecksums[pBlob.get()] = std::make_pair(pBlob, pageEmbFile.checksum);
+    }
+    std::shared_future<std::string> checksum = pageEmbFile.checksum;
+    const Glib::ustring file_name = pageEmbFile.fileName;
+    _imagesWritten.push_back(_pCtMainWin->get_image_cache().run_async([this, pBlob, checksum, file_name, embed_dir]() {
+        const Glib::ustring embfile_name = _get_embfile_name(checksum.get(), file_name);
+        {
+            std::lock_guard<std::mutex> lock(_assetsMutex);
+            if (not _assetsWritten.insert(Glib::build_filename("EmbeddedFiles", embfile_name)).second)
+                return; // written already
+        }
+        const std::string embfile_filepath = Glib::filename_from_utf8(Glib::build_filename(embed_dir, embfile_name));
+        if (not _is_file_of_size(embfile_filepath, pBlob->size()))
+            pBlob->write_to_file(embfile_filepath);
+    }));
+    return pageEmbFile;
+}
 
-    std::fstream file(Glib::build_filename(embed_dir, embfile_name), std::ios::out | std::ios::binary);
-    long size = (long)embfile->get_raw_blob().size();
-    file.write(embfile->get_raw_blob().c_str(), size);
-    file.close();
+Glib::ustring CtExport2Html::_get_embfile_name(const std::string& checksum, const Glib::ustring& file_name)
+{
+    return _get_asset_name(checksum) + "-" + file_name;
+}
 
-    return embfile_html;
+Glib::ustring CtExport2Html::_get_embfile_tag(const Glib::ustring& embfile_rel_path, const CtHtmlEmbFile& embfile)
+{
+    return "<table style=\"" + embfile.alignment + "\"><tr><td><a href=\"" +
+            embfile_rel_path + "\">Linked file: " + embfile.fileName + " </a></td></tr></table>";
 }
 
 // Returns the HTML Image
-Glib::ustring CtExport2Html::_get_image_html(CtImage* image, const Glib::ustring& images_dir, int& images_count, CtTreeIter* tree_iter)
+Glib::ustring CtExport2Html::_get_image_html(CtImage* image, const Glib::ustring& images_dir, int& images_count, CtHtmlImage* pPageImage)
 {
     if (CtImageAnchor* imageAnchor = dynamic_cast<CtImageAnchor*>(image))
         return "<a name=\"" + imageAnchor->get_anchor_name() + "\"></a>";
 
-    images_count += 1;
-    Glib::ustring image_name, image_rel_path;
-    if (tree_iter)
+    // the png bytes are written as they are, a new image is encoded on the worker threads
+    CtImagePng* png = dynamic_cast<CtImagePng*>(image);
+    const bool linked = png != nullptr;
+    const Glib::ustring href = png ? _get_href_from_link_prop_val(png->get_link()) : "";
+    if (pPageImage)
     {
-        image_name = std::to_string(tree_iter->get_node_id()) + "-" + std::to_string(images_count) + ".png";
-        image_rel_path = Glib::build_filename ("images", image_name);
-    }
-    else
-    {
-        image_name = std::to_string(images_count) + ".png";
-        image_rel_path = "file://" + Glib::build_filename (images_dir, image_name);
+        // named by the contents, hashed on the worker threads and waited for only once the page is rendered,
+        // the same image in many nodes is hashed and written once
+        pPageImage->linked = linked;
+        pPageImage->href = href;
+        std::shared_future<std::string> rawBlob;
+        if (png)
+        {
+            rawBlob = png->get_raw_blob_future();
+            if (rawBlob.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                auto itChecksum = _pngChecksums.find(&rawBlob.get());
+                if (itChecksum != _pngChecksums.end())
+                {
+                    pPageImage->checksum = itChecksum->second.second;
+                    return "";
+                }
+            }
+            pPageImage->checksum = _pCtMainWin->get_image_cache().checksum_png(rawBlob);
+            if (rawBlob.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                _pngChecksums[&rawBlob.get()] = std::make_pair(rawBlob, pPageImage->checksum);
+        }
+        else
+        {
+            rawBlob = _pCtMainWin->get_image_cache().encode_png(image->get_pixbuf(), &pPageImage->checksum);
+        }
+        std::shared_future<std::string> checksum = pPageImage->checksum;
+        _imagesWritten.push_back(_pCtMainWin->get_image_cache().run_async([this, rawBlob, checksum, images_dir]() {
+            const Glib::ustring image_name = _get_image_name(checksum.get());
+            {
+                std::lock_guard<std::mutex> lock(_assetsMutex);
+                if (not _assetsWritten.insert(Glib::build_filename("images", image_name)).second)
+                    return; // written already
+            }
+            const std::string image_filepath = Glib::filename_from_utf8(Glib::build_filename(images_dir, image_name));
+            const std::string& rawData = rawBlob.get();
+            if (not _is_file_of_size(image_filepath, rawData.size()))
+                g_file_set_contents(image_filepath.c_str(), rawData.c_str(), (gssize)rawData.size(), nullptr);
+        }));
+        return "";
     }
 
+    std::shared_future<std::string> rawBlob = png ? png->get_raw_blob_future() : _pCtMainWin->get_image_cache().encode_png(image->get_pixbuf());
+    images_count += 1;
+    const Glib::ustring image_name = std::to_string(images_count) + ".png";
+    const std::string image_filepath = Glib::filename_from_utf8(Glib::build_filename(images_dir, image_name));
+    _imagesWritten.push_back(_pCtMainWin->get_image_cache().run_async([rawBlob, image_filepath]() {
+        const std::string& rawData = rawBlob.get();
+        g_file_set_contents(image_filepath.c_str(), rawData.c_str(), (gssize)rawData.size(), nullptr);
+    }));
+    return _get_image_tag("file://" + Glib::build_filename(images_dir, image_name), linked, href);
+}
+
+Glib::ustring CtExport2Html::_get_image_tag(const Glib::ustring& image_rel_path, const bool linked, const Glib::ustring& href)
+{
     Glib::ustring image_html = "<img src=\"" + image_rel_path + "\" alt=\"" + image_rel_path + "\" />";
-    if (CtImagePng* png = dynamic_cast<CtImagePng*>(image))
-    {
-        Glib::ustring href = _get_href_from_link_prop_val(png->get_link());
+    if (linked)
         image_html = "<a href=\"" + href + "\">" + image_html + "</a>";
-    }
-
-    image->save(Glib::build_filename (images_dir, image_name), "png");
     return image_html;
 }
 
+Glib::ustring CtExport2Html::_get_image_name(const std::string& checksum)
+{
+    return _get_asset_name(checksum) + ".png";
+}
+
+std::string CtExport2Html::_get_asset_name(const std::string& checksum)
+{
+    return checksum.substr(0, 32);
+}
+
+bool CtExport2Html::_is_file_of_size(const std::string& filepath, const size_t size)
+{
+    GStatBuf statBuf;
+    return Glib::file_test(filepath, Glib::FILE_TEST_IS_REGULAR) and 0 == g_stat(filepath.c_str(), &statBuf) and (size_t)statBuf.st_size == size;
+}
+
 // Returns the HTML CodeBox
 Glib::ustring CtExport2Html::_get_codebox_html(CtCodebox* codebox)
 {
@@ -317,16 +686,14 @@ Glib::ustring CtExport2Html::_get_codebox_html(CtCodebox* codebox)
 Glib::ustring CtExport2Html::_get_table_html(CtTable* table)
 {
     Glib::ustring table_html = "<table class=\"table\">";
-    for (auto row: table->get_table_matrix())
+    for (int row = 0; row < table->get_num_rows(); ++row)
     {
         table_html += "<tr>";
-        bool first = true;
-        for (auto cell: row)
-            if (first) {
-                table_html += "<th>" + str::xml_escape(cell->get_text_content()) + "</th>";
-                first = false;
+        for (int col = 0; col < table->get_num_columns(); ++col)
+            if (0 == col) {
+                table_html += "<th>" + str::xml_escape(table->get_cell_text(row, col)) + "</th>";
             } else {
-                table_html += "<td>" + str::xml_escape(cell->get_text_content()) + "</td>";
+                table_html += "<td>" + str::xml_escape(table->get_cell_text(row, col)) + "</td>";
             }
         table_html += "</tr>";
     }
@@ -338,17 +705,35 @@ Glib::ustring CtExport2Html::_get_table_html(CtTable* table)
 Glib::ustring CtExport2Html::_html_get_from_code_buffer(Glib::RefPtr<Gsv::Buffer> code_buffer, int sel_start, int sel_end)
 {
     Gtk::TextIter curr_iter = sel_start >= 0 ? code_buffer->get_iter_at_offset(sel_start) : code_buffer->begin();
-    code_buffer->ensure_highlight(curr_iter, code_buffer->end());
-    Glib::ustring html_text = "";
-    Glib::ustring former_tag_str = CtConst::COLOR_48_BLACK;
+    // the character at sel_end is part of the selection exported
+    Gtk::TextIter end_iter = sel_end >= 0 ? code_buffer->get_iter_at_offset(sel_end + 1) : code_buffer->end();
+    code_buffer->ensure_highlight(curr_iter, end_iter);
+    std::string html_text;
+    html_text.reserve((size_t)(end_iter.get_offset() - curr_iter.get_offset()) * 5 / 4);
+    // the foreground of each highlighting tag and the span it opens
+    std::unordered_map<GtkTextTag*, std::pair<std::string, std::string>> tags_html;
+    std::string former_tag_str = CtConst::COLOR_48_BLACK;
     bool span_opened = false;
-    for (;;)
+    // the text between two tag toggles has the same tags, so the same span
+    while (curr_iter < end_iter)
     {
+        Gtk::TextIter run_end_iter = curr_iter;
+        if (!run_end_iter.forward_to_tag_toggle(Glib::RefPtr<Gtk::TextTag>{}) || run_end_iter > end_iter)
+            run_end_iter = end_iter;
         auto curr_tags = curr_iter.get_tags();
         if (curr_tags.size() > 0)
         {
-            Glib::ustring curr_tag_str = curr_tags[0]->property_foreground_gdk().get_value().to_string();
-            int font_weight = curr_tags[0]->property_weight().get_value();
+            auto it_tag_html = tags_html.find(curr_tags[0]->gobj());
+            if (it_tag_html == tags_html.end())
+            {
+                std::string curr_tag_str = curr_tags[0]->property_foreground_gdk().get_value().to_string();
+                int font_weight = curr_tags[0]->property_weight().get_value();
+                std::string color = CtRgbUtil::rgb_to_no_white(curr_tag_str);
+                color = CtRgbUtil::get_rgb24str_from_str_any(color);
+                std::string span_html = "<span style=\"color:" + color + ";font-weight:" + std::to_string(font_weight) + "\">";
+                it_tag_html = tags_html.emplace(curr_tags[0]->gobj(), std::make_pair(curr_tag_str, span_html)).first;
+            }
+            const std::string& curr_tag_str = it_tag_html->second.first;
             if (curr_tag_str == CtConst::COLOR_48_BLACK)
             {
                 if (former_tag_str != curr_tag_str)
@@ -366,9 +751,7 @@ Glib::ustring CtExport2Html::_html_get_from_code_buffer(Glib::RefPtr<Gsv::Buffer
                     former_tag_str = curr_tag_str;
                     if (span_opened) html_text += "</span>";
                     // start of tag
-                    Glib::ustring color = CtRgbUtil::rgb_to_no_white(curr_tag_str);
-                    color = CtRgbUtil::get_rgb24str_from_str_any(color);
-                    html_text += "<span style=\"color:" + color + ";font-weight:" + std::to_string(font_weight) + "\">";
+                    html_text += it_tag_html->second.second;
                     span_opened = true;
                 }
             }
@@ -379,22 +762,31 @@ Glib::ustring CtExport2Html::_html_get_from_code_buffer(Glib::RefPtr<Gsv::Buffer
             former_tag_str = CtConst::COLOR_48_BLACK;
             html_text += "</span>";
         }
-        Glib::ustring sym = str::xml_escape(Glib::ustring(1, curr_iter.get_char()));
-        html_text += str::replace(sym, " ", "&nbsp;");
-        if (!curr_iter.forward_char() || (sel_end >= 0 && curr_iter.get_offset() > sel_end))
+        const std::string run_text = curr_iter.get_text(run_end_iter);
+        for (const char c : run_text)
         {
-            if (span_opened) html_text += "</span>";
-            break;
+            switch (c)
+            {
+                case '&':  html_text += "&amp;";  break;
+                case '\"': html_text += "&quot;"; break;
+                case '\'': html_text += "&apos;"; break;
+                case '<':  html_text += "&lt;";   break;
+                case '>':  html_text += "&gt;";   break;
+                case ' ':  html_text += "&nbsp;"; break;
+                case '\n': html_text += "<br />"; break;
+                default:   html_text += c;        break;
+            }
         }
+        curr_iter = run_end_iter;
     }
+    if (span_opened) html_text += "</span>";
 
-    html_text = str::replace(html_text, CtConst::CHAR_NEWLINE, "<br />");
     return "<div class=\"codebox\">" + html_text + "</div>";
 }
 
 // Given a treestore iter returns the HTML rich text
 void CtExport2Html::_html_get_from_treestore_node(CtTreeIter node_iter, int sel_start, int sel_end,
-                                                  std::vector<Glib::ustring>& out_slots, std::vector<CtAnchoredWidget*>& out_widgets)
+                                                  std::vector<CtHtmlSlot>& out_slots, std::vector<CtAnchoredWidget*>& out_widgets)
 {
     auto curr_buffer = node_iter.get_node_text_buffer();
     auto widgets = node_iter.get_embedded_pixbufs_tables_codeboxes(std::make_pair(sel_start, sel_end));
@@ -405,24 +797,42 @@ void CtExport2Html::_html_get_from_treestore_node(CtTreeIter node_iter, int sel_
     for (auto widget: out_widgets)
     {
         int end_offset = widget->getOffset();
-        out_slots.push_back(_html_process_slot(start_offset, end_offset, curr_buffer));
+        out_slots.push_back(_html_extract_slot(start_offset, end_offset, curr_buffer));
         start_offset = end_offset;
     }
     if (sel_end == -1)
-        out_slots.push_back(_html_process_slot(start_offset, -1, curr_buffer));
+        out_slots.push_back(_html_extract_slot(start_offset, -1, curr_buffer));
     else
-        out_slots.push_back(_html_process_slot(start_offset, sel_end, curr_buffer));
+        out_slots.push_back(_html_extract_slot(start_offset, sel_end, curr_buffer));
 }
 
 
 // Process a Single HTML Slot
 Glib::ustring CtExport2Html::_html_process_slot(int start_offset, int end_offset, Glib::RefPtr<Gtk::TextBuffer> curr_buffer)
 {
-    Glib::ustring curr_html_text = "";
+    return _html_render_slot(_html_extract_slot(start_offset, end_offset, curr_buffer));
+}
+
+// Copies the text and attributes of the slot out of the buffer
+CtHtmlSlot CtExport2Html::_html_extract_slot(int start_offset, int end_offset, Glib::RefPtr<Gtk::TextBuffer> curr_buffer)
+{
+    CtHtmlSlot slot;
     CtTextIterUtil::generic_process_slot(start_offset, end_offset, curr_buffer,
                                          [&](Gtk::TextIter& start_iter, Gtk::TextIter& curr_iter, std::map<const gchar*, std::string>& curr_attributes) {
-        curr_html_text += _html_text_serialize(start_iter, curr_iter, curr_attributes);
+        CtHtmlSpan span{start_iter.get_text(curr_iter), curr_attributes, ""};
+        if (curr_attributes.at(CtConst::TAG_LINK) != "")
+            span.href = _get_href_from_link_prop_val(curr_attributes.at(CtConst::TAG_LINK));
+        slot.push_back(std::move(span));
     });
+    return slot;
+}
+
+// Renders the spans of the slot, does not touch gtk so can run on any thread
+Glib::ustring CtExport2Html::_html_render_slot(const CtHtmlSlot& slot)
+{
+    Glib::ustring curr_html_text = "";
+    for (const CtHtmlSpan& span : slot)
+        curr_html_text += _html_text_serialize(span);
 
     curr_html_text = str::replace(curr_html_text, "<br/><p ", "<p ");
     curr_html_text = str::replace(curr_html_text, "</p><br/>", "</p>");
@@ -433,9 +843,10 @@ Glib::ustring CtExport2Html::_html_process_slot(int start_offset, int end_offset
 }
 
 // Adds a slice to the HTML Text
-Glib::ustring CtExport2Html::_html_text_serialize(Gtk::TextIter start_iter, Gtk::TextIter end_iter, const std::map<const gchar*, std::string>& curr_attributes)
+Glib::ustring CtExport2Html::_html_text_serialize(const CtHtmlSpan& span)
 {
-    Glib::ustring inner_text = str::xml_escape(start_iter.get_text(end_iter));
+    const std::map<const gchar*, std::string>& curr_attributes = span.attributes;
+    Glib::ustring inner_text = str::xml_escape(span.text);
     if (inner_text == "") return "";
     inner_text = str::replace(inner_text, CtConst::CHAR_NEWLINE, "<br />");
 
@@ -527,10 +938,9 @@ Glib::ustring CtExport2Html::_html_text_serialize(Gtk::TextIter start_iter, Gtk:
         else if (tag_property == CtConst::TAG_LINK)
         {
             // <a href="http://www.example.com/">link-text goes here</a>
-            Glib::ustring href = _get_href_from_link_prop_val(property_value);
-            if (href == "")
+            if (span.href == "")
                 continue;
-            Glib::ustring html_text = "<a href=\"" + href + "\">" + inner_text + "</a>";
+            Glib::ustring html_text = "<a href=\"" + span.href + "\">" + inner_text + "</a>";
             return html_text;
         }
         html_attrs += Glib::ustring(tag_property) + ":" + property_value + ";";
@@ -583,6 +993,7 @@ Glib::ustring CtExport2Html::_get_href_from_link_prop_val(Glib::ustring link_pro
     }
     else if (vec[0] == CtConst::LINK_TYPE_NODE)
     {
+        _nodeLinks.insert(std::stol(vec[1]));
         CtTreeIter node = _pCtMainWin->curr_tree_store().get_node_from_node_id(std::stol(vec[1]));
         if (node)
         {
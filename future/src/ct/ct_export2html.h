@@ -26,6 +26,64 @@
 #include "ct_image.h"
 #include "ct_treestore.h"
 #include "ct_dialogs.h" // CtExportOptions
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+// A run of rich text with the same attributes, copied out of the text buffer
+// so that it can be turned into html away from the main thread
+struct CtHtmlSpan
+{
+    Glib::ustring                       text;
+    std::map<const gchar*, std::string> attributes;
+    Glib::ustring                       href; // the link resolved on the main thread, if any
+};
+using CtHtmlSlot = std::vector<CtHtmlSpan>;
+
+// An image of a page named by its content, the name is known once the png is hashed on a worker thread
+struct CtHtmlImage
+{
+    std::shared_future<std::string> checksum;
+    bool                            linked{false};
+    Glib::ustring                   href;
+};
+
+// An embedded file of a page named by its content, the name is known once the file is hashed on a worker thread
+struct CtHtmlEmbFile
+{
+    std::shared_future<std::string> checksum;
+    Glib::ustring                   fileName;
+    Glib::ustring                   alignment;
+};
+
+// A node page with all the data taken from the tree, ready to be rendered and written on a worker thread
+struct CtHtmlPage
+{
+    std::string                filepath;
+    Glib::ustring              head;        // html before the rich text
+    std::vector<CtHtmlSlot>    slots;
+    std::vector<Glib::ustring> widgetsHtml; // html after each slot but the last
+    std::map<size_t, CtHtmlImage> widgetsImages; // by index, the widgets that are images named by their content
+    std::map<size_t, CtHtmlEmbFile> widgetsEmbFiles; // by index, the embedded files named by their content
+    Glib::ustring              tail;        // html after the rich text
+    std::vector<std::string>   files;       // written for the node, relative to the export folder, the page first, the images once rendered
+    std::set<gint64>           links;       // the nodes linked from the page
+};
+
+// What an export wrote for a node, kept in the manifest of the export folder
+// so that exporting again to the same folder only rewrites the nodes that changed
+struct CtHtmlManifestNode
+{
+    gint64                   tsLastSave{0};
+    gint64                   tsExport{0};
+    Glib::ustring            name;
+    Glib::ustring            filename;
+    std::string              syntax;
+    std::string              hash; // of the page html
+    std::vector<std::string> files;
+    std::vector<gint64>      links;
+};
+using CtHtmlManifest = std::map<gint64, std::shared_ptr<CtHtmlManifestNode>>;
 
 class CtExport2Html
 {
@@ -40,33 +98,52 @@ private:
     <body>
     )HTML";
     const Glib::ustring HTML_FOOTER = R"HTML(</body></html>)HTML";
+    const Glib::ustring MANIFEST_FILENAME{".ct_html_manifest"};
+    static const int    MANIFEST_VERSION{2}; // to increase whenever the html of the pages changes
 
 public:
     CtExport2Html(CtMainWin* pCtMainWin);
 
-    void          node_export_to_html(CtTreeIter tree_iter, const CtExportOptions& options, const Glib::ustring& index, int sel_start, int sel_end);
+    void          node_export_to_html(CtTreeIter tree_iter, const CtExportOptions& options, const bool with_index, int sel_start, int sel_end);
     void          nodes_all_export_to_html(bool all_tree, const CtExportOptions& options);
-    Glib::ustring selection_export_to_html(Glib::RefPtr<Gtk::TextBuffer> text_buffer, Gtk::TextIter start_iter,
+    Glib::ustring selection_export_to_html(CtTreeIter tree_iter, Glib::RefPtr<Gtk::TextBuffer> text_buffer, Gtk::TextIter start_iter,
                                            Gtk::TextIter end_iter, const Glib::ustring& syntax_highlighting);
     Glib::ustring table_export_to_html(CtTable* table);
     Glib::ustring codebox_export_to_html(CtCodebox* codebox);
     bool          prepare_html_folder(Glib::ustring dir_place, Glib::ustring new_folder, bool export_overwrite, Glib::ustring& export_path);
 
 private:
-    Glib::ustring _get_embfile_html(CtImageEmbFile* embfile, CtTreeIter tree_iter, Glib::ustring embed_dir);
-    Glib::ustring _get_image_html(CtImage* image, const Glib::ustring& images_dir, int& images_count, CtTreeIter* tree_iter);
+    CtHtmlPage    _get_node_page(CtTreeIter tree_iter, const CtExportOptions& options, const bool with_index, int sel_start, int sel_end);
+    static Glib::ustring _render_page(CtHtmlPage& page);
+    static bool   _write_if_changed(const std::string& filepath, const Glib::ustring& html_text, const std::string& prev_hash, std::string& hash);
+    std::string   _get_options_id(const CtExportOptions& options);
+    bool          _load_manifest(const std::string& options_id, std::string& index_hash, std::string& tree_index_hash, CtHtmlManifest& manifest);
+    void          _save_manifest(const std::string& options_id, const gint64 export_ts, const std::string& index_hash, const std::string& tree_index_hash,
+                                 const CtHtmlManifest& manifest);
+    void          _remove_stale_files(const CtHtmlManifest& prev_manifest, const CtHtmlManifest& manifest);
+    void          _wait_images_written();
+    static std::string _get_asset_name(const std::string& checksum);
+    static Glib::ustring _get_image_name(const std::string& checksum);
+    static Glib::ustring _get_image_tag(const Glib::ustring& image_rel_path, const bool linked, const Glib::ustring& href);
+    static bool   _is_file_of_size(const std::string& filepath, const size_t size);
+    static Glib::ustring _get_embfile_name(const std::string& checksum, const Glib::ustring& file_name);
+    static Glib::ustring _get_embfile_tag(const Glib::ustring& embfile_rel_path, const CtHtmlEmbFile& embfile);
+    CtHtmlEmbFile _get_embfile(CtImageEmbFile* embfile, const Glib::ustring& embed_dir);
+    Glib::ustring _get_image_html(CtImage* image, const Glib::ustring& images_dir, int& images_count, CtHtmlImage* pPageImage);
     Glib::ustring _get_codebox_html(CtCodebox* codebox);
     Glib::ustring _get_table_html(CtTable* table);
 
     Glib::ustring _html_get_from_code_buffer(Glib::RefPtr<Gsv::Buffer> code_buffer, int sel_start, int sel_end);
     void          _html_get_from_treestore_node(CtTreeIter node_iter, int sel_start, int sel_end,
-                                       std::vector<Glib::ustring>& out_slots, std::vector<CtAnchoredWidget*>& out_widgets);
+                                       std::vector<CtHtmlSlot>& out_slots, std::vector<CtAnchoredWidget*>& out_widgets);
     Glib::ustring _html_process_slot(int start_offset, int end_offset, Glib::RefPtr<Gtk::TextBuffer> curr_buffer);
-    Glib::ustring _html_text_serialize(Gtk::TextIter start_iter, Gtk::TextIter end_iter, const std::map<const gchar*, std::string>& curr_attributes);
+    CtHtmlSlot    _html_extract_slot(int start_offset, int end_offset, Glib::RefPtr<Gtk::TextBuffer> curr_buffer);
+    static Glib::ustring _html_render_slot(const CtHtmlSlot& slot);
+    static Glib::ustring _html_text_serialize(const CtHtmlSpan& span);
     Glib::ustring _get_href_from_link_prop_val(Glib::ustring link_prop_val);
     Glib::ustring _get_object_alignment_string(Glib::ustring alignment);
 
-    void          _tree_links_text_iter(CtTreeIter tree_iter, Glib::ustring& tree_links_text, int tree_count_level, bool index_in_page);
+    void          _tree_index_json_iter(CtTreeIter tree_iter, Glib::ustring& tree_index_json);
 
     Glib::ustring _get_html_filename(CtTreeIter tree_iter);
 
@@ -80,5 +157,14 @@ private:
     Glib::ustring _images_dir;
     Glib::ustring _embed_dir;
     Glib::ustring _res_dir;
+    std::vector<std::future<void>> _imagesWritten; // image and embedded files written on the worker threads
+    std::vector<std::string>       _nodeFiles;     // written for the node being exported
+    std::set<gint64>               _nodeLinks;     // linked from the node being exported
+    std::unordered_set<std::string> _assetsWritten; // images and embedded files, named by their content, written once
+    std::mutex                      _assetsMutex;   // the images and embedded files are written on the worker threads
+    // by png data, kept alive, so that the same image is hashed once
+    std::unordered_map<const std::string*, std::pair<std::shared_future<std::string>, std::shared_future<std::string>>> _pngChecksums;
+    // by embedded file blob, kept alive, so that the same file is hashed once
+    std::unordered_map<const CtEmbFileBlob*, std::pair<std::shared_ptr<CtEmbFileBlob>, std::shared_future<std::string>>> _embfileChecksums;
 };
 
@@ -21,6 +21,9 @@
 
 #include "ct_export2txt.h"
 #include "ct_main_win.h"
+#include <deque>
+#include <fstream>
+#include <thread>
 
 CtExport2Txt::CtExport2Txt(CtMainWin* pCtMainWin)
  : _pCtMainWin(pCtMainWin)
@@ -33,7 +36,7 @@ Glib::ustring CtExport2Txt::node_export_to_txt(CtTreeIter tree_iter, Glib::ustri
     Glib::ustring plain_text;
     if (export_options.include_node_name)
         plain_text = tree_iter.get_node_name().uppercase() + CtConst::CHAR_NEWLINE;
-    plain_text += selection_export_to_txt(tree_iter.get_node_text_buffer(), sel_start, sel_end, false);
+    plain_text += selection_export_to_txt(tree_iter, tree_iter.get_node_text_buffer(), sel_start, sel_end, false);
     plain_text += CtConst::CHAR_NEWLINE + CtConst::CHAR_NEWLINE;
     if (filepath != "")
         g_file_set_contents(filepath.c_str(), plain_text.c_str(), (gssize)plain_text.bytes(), nullptr);
@@ -43,37 +46,76 @@ Glib::ustring CtExport2Txt::node_export_to_txt(CtTreeIter tree_iter, Glib::ustri
 // Export All Nodes To Txt
 void CtExport2Txt::nodes_all_export_to_txt(bool all_tree, Glib::ustring export_dir, Glib::ustring single_txt_filepath, CtExportOptions export_options)
 {
-    // function to iterate nodes
-    Glib::ustring tree_plain_text;
-    std::function<void(CtTreeIter)> traverseFunc;
-    traverseFunc = [this, &traverseFunc, &export_options, &tree_plain_text, &export_dir](CtTreeIter tree_iter) {
+    // the single file is written node by node as the text is taken,
+    // the multiple files are written on the worker threads
+    std::ofstream single_txt_file;
+    if (export_dir == "" && single_txt_filepath != "")
+    {
+        single_txt_file.open(Glib::filename_from_utf8(single_txt_filepath), std::ios::out | std::ios::binary);
+        if (!single_txt_file)
+        {
+            std::cerr << "!! " << single_txt_filepath << std::endl;
+            return;
+        }
+    }
+    const size_t maxFilesPending = 4 * std::max(1u, std::thread::hardware_concurrency());
+    std::deque<std::future<void>> filesWritten;
+
+    // function to iterate nodes, the hierarchical name of the children is the one of the father plus their own
+    // (as CtMiscUtil::get_node_hierarchical_name without climbing the tree for each node)
+    std::function<void(CtTreeIter, const std::string&)> traverseFunc;
+    traverseFunc = [&](CtTreeIter tree_iter, const std::string& hierarchical_name) {
+        auto pPlainText = std::make_shared<Glib::ustring>(node_export_to_txt(tree_iter, "", export_options, -1, -1));
         if (export_dir == "")
-            tree_plain_text += node_export_to_txt(tree_iter, "", export_options, -1, -1);
+        {
+            if (single_txt_file.is_open())
+                single_txt_file.write(pPlainText->data(), (std::streamsize)pPlainText->bytes());
+        }
         else
         {
-            Glib::ustring filepath = Glib::build_filename(export_dir, CtMiscUtil::get_node_hierarchical_name(tree_iter) + ".txt");
-            node_export_to_txt(tree_iter, filepath, export_options, -1, -1);
+            std::string filename = CtMiscUtil::clean_from_chars_not_for_filename(hierarchical_name);
+            if (filename.size() > (size_t)CtConst::MAX_FILE_NAME_LEN)
+                filename = filename.substr(filename.size() - (size_t)CtConst::MAX_FILE_NAME_LEN);
+            const std::string filepath = Glib::build_filename(export_dir, filename + ".txt");
+            filesWritten.push_back(_pCtMainWin->get_image_cache().run_async([pPlainText, filepath]() {
+                g_file_set_contents(filepath.c_str(), pPlainText->c_str(), (gssize)pPlainText->bytes(), nullptr);
+            }));
+            // bounds the memory held by the files not written yet
+            while (filesWritten.size() >= maxFilesPending)
+            {
+                filesWritten.front().wait();
+                filesWritten.pop_front();
+            }
         }
         for (auto& child: tree_iter->children())
-            traverseFunc(_pCtMainWin->curr_tree_store().to_ct_tree_iter(child));
+        {
+            CtTreeIter child_iter = _pCtMainWin->curr_tree_store().to_ct_tree_iter(child);
+            traverseFunc(child_iter, hierarchical_name + "--" + str::trim(child_iter.get_node_name()));
+        }
     };
     // start to iterarte nodes
     CtTreeIter tree_iter = all_tree ? _pCtMainWin->curr_tree_store().get_ct_iter_first() : _pCtMainWin->curr_tree_iter();
     for (;tree_iter; ++tree_iter)
     {
-        traverseFunc(tree_iter);
+        traverseFunc(tree_iter, CtMiscUtil::get_node_hierarchical_name(tree_iter, "--", false/*for_filename*/));
         if (!all_tree) break;
     }
 
-    if (single_txt_filepath != "")
-        g_file_set_contents(single_txt_filepath.c_str(), tree_plain_text.c_str(), (gssize)tree_plain_text.bytes(), nullptr);
+    for (std::future<void>& fileWritten : filesWritten)
+        fileWritten.wait();
+    if (single_txt_file.is_open())
+    {
+        single_txt_file.close();
+        if (!single_txt_file)
+            std::cerr << "!! " << single_txt_filepath << std::endl;
+    }
 }
 
-// Export the Buffer To Txt
-Glib::ustring CtExport2Txt::selection_export_to_txt(Glib::RefPtr<Gtk::TextBuffer> text_buffer, int sel_start, int sel_end, bool check_link_target)
+// Export the Buffer of the Node To Txt
+Glib::ustring CtExport2Txt::selection_export_to_txt(CtTreeIter tree_iter, Glib::RefPtr<Gtk::TextBuffer> text_buffer, int sel_start, int sel_end, bool check_link_target)
 {
     Glib::ustring plain_text;
-    std::list<CtAnchoredWidget*> widgets = _pCtMainWin->curr_tree_iter().get_embedded_pixbufs_tables_codeboxes(std::make_pair(sel_start, sel_end));
+    std::list<CtAnchoredWidget*> widgets = tree_iter.get_embedded_pixbufs_tables_codeboxes(std::make_pair(sel_start, sel_end));
 
     int start_offset = sel_start >= 0 ? sel_start : 0;
     for (CtAnchoredWidget* widget: widgets)
@@ -93,11 +135,11 @@ Glib::ustring CtExport2Txt::selection_export_to_txt(Glib::RefPtr<Gtk::TextBuffer
 Glib::ustring CtExport2Txt::get_table_plain(CtTable* table_orig)
 {
     Glib::ustring table_plain = CtConst::CHAR_NEWLINE;
-    for (const auto& row: table_orig->get_table_matrix())
+    for (int row = 0; row < table_orig->get_num_rows(); ++row)
     {
         table_plain += CtConst::CHAR_PIPE;
-        for (const auto& cell: row)
-            table_plain += CtConst::CHAR_SPACE + cell->get_text_content() + CtConst::CHAR_SPACE + CtConst::CHAR_PIPE;
+        for (int col = 0; col < table_orig->get_num_columns(); ++col)
+            table_plain += CtConst::CHAR_SPACE + table_orig->get_cell_text(row, col) + CtConst::CHAR_SPACE + CtConst::CHAR_PIPE;
         table_plain += CtConst::CHAR_NEWLINE;
     }
     return table_plain;
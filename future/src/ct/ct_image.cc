@@ -23,20 +23,14 @@
 #include "ct_doc_rw.h"
 #include "ct_main_win.h"
 #include "ct_actions.h"
+#include <algorithm>
+#include <fstream>
 
 CtImage::CtImage(CtMainWin* pCtMainWin,
-                 const std::string& rawBlob,
-                 const char* mimeType,
                  const int charOffset,
                  const std::string& justification)
  : CtAnchoredWidget(pCtMainWin, charOffset, justification)
 {
-    Glib::RefPtr<Gdk::PixbufLoader> rPixbufLoader = Gdk::PixbufLoader::create(mimeType, true);
-    rPixbufLoader->write(reinterpret_cast<const guint8*>(rawBlob.c_str()), rawBlob.size());
-    rPixbufLoader->close();
-    _rPixbuf = rPixbufLoader->get_pixbuf();
-
-    _image.set(_rPixbuf);
     _frame.add(_image);
     show_all();
 }
@@ -55,37 +49,61 @@ CtImage::CtImage(CtMainWin* pCtMainWin,
     show_all();
 }
 
-CtImage::CtImage(CtMainWin* pCtMainWin,
-                 Glib::RefPtr<Gdk::Pixbuf> pixBuf,
-                 const int charOffset,
-                 const std::string& justification)
- : CtAnchoredWidget(pCtMainWin, charOffset, justification)
+CtImage::~CtImage()
 {
-    _rPixbuf = pixBuf;
-
-    _image.set(_rPixbuf);
-    _frame.add(_image);
-    show_all();
 }
 
-CtImage::~CtImage()
+void CtImage::save(const Glib::ustring& file_name, const Glib::ustring& type)
 {
+    get_pixbuf()->save(file_name, type);
 }
 
-void CtImage::save(const Glib::ustring& file_name, const Glib::ustring& type)
+
+static std::shared_future<std::string> get_ready_raw_blob(const std::string& rawBlob)
 {
-    _rPixbuf->save(file_name, type);
+    std::promise<std::string> rawBlobPromise;
+    rawBlobPromise.set_value(rawBlob);
+    return rawBlobPromise.get_future().share();
 }
 
+static guint64 new_raw_blob_id()
+{
+    static guint64 lastRawBlobId{0};
+    return ++lastRawBlobId;
+}
 
 CtImagePng::CtImagePng(CtMainWin* pCtMainWin,
                        const std::string& rawBlob,
                        const Glib::ustring& link,
                        const int charOffset,
                        const std::string& justification)
- : CtImage(pCtMainWin, rawBlob, "image/png", charOffset, justification),
-   _link(link)
+ : CtImagePng(pCtMainWin, get_ready_raw_blob(rawBlob), link, charOffset, justification)
 {
+}
+
+CtImagePng::CtImagePng(CtMainWin* pCtMainWin,
+                       std::shared_future<std::string> rawBlob,
+                       const Glib::ustring& link,
+                       const int charOffset,
+                       const std::string& justification,
+                       const guint64 rawBlobId)
+ : CtImage(pCtMainWin, charOffset, justification),
+   _link(link),
+   _rawBlob(rawBlob), // the png bytes are kept as they are, there is no need to encode the pixbuf again on save
+   _rawBlobId(rawBlobId ? rawBlobId : new_raw_blob_id())
+{
+    _cacheId = _pCtMainWin->get_image_cache().add_image(this);
+    // the pixbuf is decoded when the image is first drawn, in the meantime the space is reserved
+    if (not CtImageCache::get_png_size(get_raw_blob(), _fullWidth, _fullHeight))
+    {
+        _rPixbuf = CtImageCache::decode(get_raw_blob(), 0, 0);
+        if (not _rPixbuf)
+            _rPixbuf = _pCtMainWin->get_icon_theme()->load_icon("image-missing", 48);
+        _fullWidth = _rPixbuf->get_width();
+        _fullHeight = _rPixbuf->get_height();
+    }
+    apply_width_height(0);
+    _image.signal_draw().connect(sigc::mem_fun(*this, &CtImagePng::_on_image_draw), false);
     signal_button_press_event().connect(sigc::mem_fun(*this, &CtImagePng::_on_button_press_event), false);
     // todo: DEPRECATED signal_visibility_notify_event().connect([this](){ this->queue_draw(); return false; });    // Problem of image colored frame disappearing
     update_label_widget();
@@ -96,21 +114,120 @@ CtImagePng::CtImagePng(CtMainWin* pCtMainWin,
                        const Glib::ustring& link,
                        const int charOffset,
                        const std::string& justification)
- : CtImage(pCtMainWin, pixBuf, charOffset, justification),
-   _link(link)
+ : CtImage(pCtMainWin, charOffset, justification),
+   _link(link),
+   _rawBlobId(new_raw_blob_id())
 {
+    _cacheId = _pCtMainWin->get_image_cache().add_image(this);
+    // new or edited image, encoded once and off the main thread
+    _rawBlob = _pCtMainWin->get_image_cache().encode_png(pixBuf);
+    _rPixbuf = pixBuf;
+    _fullWidth = _rPixbuf->get_width();
+    _fullHeight = _rPixbuf->get_height();
+    apply_width_height(0);
+    _image.signal_draw().connect(sigc::mem_fun(*this, &CtImagePng::_on_image_draw), false);
     signal_button_press_event().connect(sigc::mem_fun(*this, &CtImagePng::_on_button_press_event), false);
     // todo: DEPRECATED signal_visibility_notify_event().connect([this](){ this->queue_draw(); return false; });    // Problem of image colored frame disappearing
     update_label_widget();
 }
 
-const std::string CtImagePng::get_raw_blob()
+CtImagePng::~CtImagePng()
 {
-    g_autofree gchar* pBuffer{NULL};
-    gsize buffer_size;
-    _rPixbuf->save_to_buffer(pBuffer, buffer_size, "png");
-    const std::string rawBlob = std::string(pBuffer, buffer_size);
-    return rawBlob;
+    _pCtMainWin->get_image_cache().remove_image(_cacheId);
+}
+
+void CtImagePng::apply_width_height(const int parentTextWidth)
+{
+    CtTextView& textView = _pCtMainWin->get_text_view();
+    const int maxWidth = parentTextWidth - textView.get_left_margin() - textView.get_right_margin();
+    const int displayWidth = (maxWidth > 0 and maxWidth < _fullWidth) ? maxWidth : _fullWidth;
+    if (displayWidth == _displayWidth)
+        return;
+    _displayWidth = displayWidth;
+    _displayHeight = std::max(1, (int)((gint64)_fullHeight * _displayWidth / std::max(1, _fullWidth)));
+    _image.set_size_request(_displayWidth, _displayHeight);
+    if (_rPixbuf and _displayWidth == _fullWidth)
+    {
+        set_display_pixbuf(_rPixbuf);
+    }
+    else if (_rDisplayPixbuf)
+    {
+        // decoded again at the new size when drawn
+        _rDisplayPixbuf.reset();
+        _image.clear();
+        _update_cache_bytes();
+    }
+}
+
+Glib::RefPtr<Gdk::Pixbuf> CtImagePng::get_pixbuf()
+{
+    if (not _rPixbuf)
+    {
+        _rPixbuf = CtImageCache::decode(get_raw_blob(), 0, 0);
+        _update_cache_bytes();
+    }
+    return _rPixbuf;
+}
+
+void CtImagePng::set_display_pixbuf(Glib::RefPtr<Gdk::Pixbuf> rPixbuf)
+{
+    _decodeRequestedWidth = 0;
+    if (not rPixbuf or rPixbuf->get_width() != _displayWidth)
+        return; // the display size changed in the meantime
+    _rDisplayPixbuf = rPixbuf;
+    _image.set(_rDisplayPixbuf);
+    _update_cache_bytes();
+}
+
+// Dropped by the cache, to be decoded again if the image is drawn
+void CtImagePng::drop_pixbufs()
+{
+    if (_rPixbuf and std::future_status::ready != _rawBlob.wait_for(std::chrono::seconds(0)))
+        return; // the full pixbuf is still being encoded
+    _rDisplayPixbuf.reset();
+    _rPixbuf.reset();
+    _image.clear();
+    _update_cache_bytes();
+}
+
+bool CtImagePng::_on_image_draw(const Cairo::RefPtr<Cairo::Context>& /*cr*/)
+{
+    CtImageCache& imageCache = _pCtMainWin->get_image_cache();
+    imageCache.image_drawn(_cacheId);
+    if (not _rDisplayPixbuf and _decodeRequestedWidth != _displayWidth)
+    {
+        if (_rPixbuf and _displayWidth == _fullWidth)
+        {
+            set_display_pixbuf(_rPixbuf);
+        }
+        else
+        {
+            _decodeRequestedWidth = _displayWidth;
+            imageCache.request_decode(_cacheId, _rawBlob, _rPixbuf, _displayWidth, _displayHeight);
+        }
+    }
+    return false;
+}
+
+void CtImagePng::_update_cache_bytes()
+{
+    size_t bytes{0};
+    if (_rPixbuf) bytes += _rPixbuf->get_byte_length();
+    if (_rDisplayPixbuf and _rDisplayPixbuf != _rPixbuf) bytes += _rDisplayPixbuf->get_byte_length();
+    _pCtMainWin->get_image_cache().set_image_bytes(_cacheId, bytes);
+}
+
+void CtImagePng::save(const Glib::ustring& file_name, const Glib::ustring& type)
+{
+    const std::string& rawBlob = get_raw_blob();
+    if (type != "png" or rawBlob.empty())
+    {
+        CtImage::save(file_name, type);
+    }
+    else
+    {
+        g_file_set_contents(Glib::filename_from_utf8(file_name).c_str(), rawBlob.c_str(), (gssize)rawBlob.size(), nullptr);
+    }
 }
 
 void CtImagePng::to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment)
@@ -134,7 +251,7 @@ bool CtImagePng::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_
     }
     else
     {
-        const std::string rawBlob = get_raw_blob();
+        const std::string& rawBlob = get_raw_blob();
         const std::string link = Glib::locale_from_utf8(_link);
         sqlite3_bind_int64(p_stmt, 1, node_id);
         sqlite3_bind_int64(p_stmt, 2, _charOffset+offset_adjustment);
@@ -267,7 +384,7 @@ bool CtImageAnchor::_on_button_press_event(GdkEventButton* event)
 
 CtImageEmbFile::CtImageEmbFile(CtMainWin* pCtMainWin,
                                const Glib::ustring& fileName,
-                               const std::string& rawBlob,
+                               std::shared_ptr<CtEmbFileBlob> rawBlob,
                                const double& timeSeconds,
                                const int charOffset,
                                const std::string& justification)
@@ -288,7 +405,7 @@ void CtImageEmbFile::to_xml(xmlpp::Element* p_node_parent, const int offset_adju
     p_image_node->set_attribute(CtConst::TAG_JUSTIFICATION, _justification);
     p_image_node->set_attribute("filename", _fileName);
     p_image_node->set_attribute("time", std::to_string(_timeSeconds));
-    const std::string encodedBlob = Glib::Base64::encode(_rawBlob);
+    const std::string encodedBlob = Glib::Base64::encode(_rawBlob->read_all());
     p_image_node->add_child_text(encodedBlob);
 }
 
@@ -308,7 +425,7 @@ bool CtImageEmbFile::to_sqlite(sqlite3* pDb, const gint64 node_id, const int off
         sqlite3_bind_int64(p_stmt, 2, _charOffset+offset_adjustment);
         sqlite3_bind_text(p_stmt, 3, _justification.c_str(), _justification.size(), SQLITE_STATIC);
         sqlite3_bind_text(p_stmt, 4, "", -1, SQLITE_STATIC); // anchor
-        sqlite3_bind_blob(p_stmt, 5, _rawBlob.c_str(), _rawBlob.size(), SQLITE_STATIC);
+        sqlite3_bind_zeroblob64(p_stmt, 5, _rawBlob->size()); // filled in chunks
         sqlite3_bind_text(p_stmt, 6, file_name.c_str(), file_name.size(), SQLITE_STATIC);
         sqlite3_bind_text(p_stmt, 7, "", -1, SQLITE_STATIC); // link
         sqlite3_bind_int64(p_stmt, 8, _timeSeconds);
@@ -317,6 +434,10 @@ bool CtImageEmbFile::to_sqlite(sqlite3* pDb, const gint64 node_id, const int off
             std::cerr << CtSQLite::ERR_SQLITE_STEP << sqlite3_errmsg(pDb) << std::endl;
             retVal = false;
         }
+        else
+        {
+            retVal = _rawBlob->write_to_db_row(pDb, sqlite3_last_insert_rowid(pDb));
+        }
         sqlite3_finalize(p_stmt);
     }
     return retVal;
@@ -344,7 +465,7 @@ void CtImageEmbFile::update_label_widget()
 void CtImageEmbFile::update_tooltip()
 {
     char humanReadableSize[16];
-    const long unsigned embfileBytes{_rawBlob.size()};
+    const long unsigned embfileBytes{_rawBlob->size()};
     const double embfileKbytes{static_cast<double>(embfileBytes)/1024};
     const double embfileMbytes{embfileKbytes/1024};
     if (embfileMbytes > 1)
@@ -374,3 +495,461 @@ bool CtImageEmbFile::_on_button_press_event(GdkEventButton* event)
 
     return true; // do not propagate the event
 }
+
+
+CtImageCache::CtImageCache()
+{
+    _dispatcher.connect(sigc::mem_fun(*this, &CtImageCache::_on_results));
+}
+
+CtImageCache::~CtImageCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+        _tasks.clear();
+    }
+    _tasksCond.notify_all();
+    for (std::thread& worker : _workers)
+        worker.join();
+    for (Result& result : _results)
+        if (result.pPixbuf) g_object_unref(result.pPixbuf);
+}
+
+guint64 CtImageCache::add_image(CtImagePng* pImage)
+{
+    const guint64 imageId = _nextImageId++;
+    Entry& entry = _entries[imageId];
+    entry.pImage = pImage;
+    entry.itLru = _lru.insert(_lru.end(), imageId);
+    return imageId;
+}
+
+void CtImageCache::remove_image(const guint64 imageId)
+{
+    auto it = _entries.find(imageId);
+    if (it == _entries.end()) return;
+    _bytes -= it->second.bytes;
+    _lru.erase(it->second.itLru);
+    _entries.erase(it);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tasks.erase(std::remove_if(_tasks.begin(), _tasks.end(), [imageId](const Task& task){ return task.imageId == imageId; }), _tasks.end());
+}
+
+void CtImageCache::image_drawn(const guint64 imageId)
+{
+    auto it = _entries.find(imageId);
+    if (it == _entries.end()) return;
+    it->second.lastDrawn = g_get_monotonic_time();
+    _lru.splice(_lru.end(), _lru, it->second.itLru);
+}
+
+void CtImageCache::set_image_bytes(const guint64 imageId, const size_t bytes)
+{
+    auto it = _entries.find(imageId);
+    if (it == _entries.end()) return;
+    const bool grown = bytes > it->second.bytes;
+    _bytes = _bytes - it->second.bytes + bytes;
+    it->second.bytes = bytes;
+    if (grown and _bytes > BUDGET_BYTES)
+        _trim();
+}
+
+void CtImageCache::request_decode(const guint64 imageId, std::shared_future<std::string> rawBlob, Glib::RefPtr<Gdk::Pixbuf> rFullPixbuf,
+                                  const int width, const int height)
+{
+    // plain gdk-pixbuf on the worker threads, the wrapper is created on the main thread
+    std::shared_ptr<GdkPixbuf> pFullPixbuf;
+    if (rFullPixbuf)
+        pFullPixbuf.reset(GDK_PIXBUF(g_object_ref(rFullPixbuf->gobj())), g_object_unref);
+    _post(Task{imageId, [this, imageId, rawBlob, pFullPixbuf, width, height]()
+    {
+        GdkPixbuf* pPixbuf{nullptr};
+        if (pFullPixbuf)
+        {
+            // a new image may still be encoding, do not wait for it
+            pPixbuf = gdk_pixbuf_scale_simple(pFullPixbuf.get(), width, height, GDK_INTERP_BILINEAR);
+        }
+        else if (GdkPixbufLoader* pLoader = gdk_pixbuf_loader_new_with_mime_type("image/png", nullptr))
+        {
+            const std::string& rawData = rawBlob.get();
+            gdk_pixbuf_loader_set_size(pLoader, width, height);
+            if (gdk_pixbuf_loader_write(pLoader, reinterpret_cast<const guint8*>(rawData.c_str()), rawData.size(), nullptr) and
+                gdk_pixbuf_loader_close(pLoader, nullptr))
+            {
+                pPixbuf = gdk_pixbuf_loader_get_pixbuf(pLoader);
+                if (pPixbuf) g_object_ref(pPixbuf);
+            }
+            else
+            {
+                gdk_pixbuf_loader_close(pLoader, nullptr);
+            }
+            g_object_unref(pLoader);
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_quit)
+            {
+                if (pPixbuf) g_object_unref(pPixbuf);
+                return;
+            }
+            _results.push_back(Result{imageId, pPixbuf, width});
+        }
+        _dispatcher.emit();
+    }});
+}
+
+std::shared_future<std::string> CtImageCache::encode_png(Glib::RefPtr<Gdk::Pixbuf> rPixbuf, std::shared_future<std::string>* pChecksum)
+{
+    // plain gdk-pixbuf on the worker threads, the pixbuf is never modified
+    std::shared_ptr<GdkPixbuf> pPixbuf(GDK_PIXBUF(g_object_ref(rPixbuf->gobj())), g_object_unref);
+    std::shared_ptr<std::promise<std::string>> pChecksumPromise;
+    if (pChecksum)
+    {
+        pChecksumPromise = std::make_shared<std::promise<std::string>>();
+        *pChecksum = pChecksumPromise->get_future().share();
+    }
+    auto pTask = std::make_shared<std::packaged_task<std::string()>>([pPixbuf, pChecksumPromise]()
+    {
+        std::string rawBlob;
+        gchar* pBuffer{nullptr};
+        gsize buffer_size{0};
+        GError* pError{nullptr};
+        if (gdk_pixbuf_save_to_buffer(pPixbuf.get(), &pBuffer, &buffer_size, "png", &pError, NULL))
+        {
+            rawBlob.assign(pBuffer, buffer_size);
+            g_free(pBuffer);
+        }
+        else
+        {
+            std::cerr << "!! png encode " << (pError ? pError->message : "") << std::endl;
+            g_clear_error(&pError);
+        }
+        if (pChecksumPromise)
+        {
+            pChecksumPromise->set_value(Glib::Checksum::compute_checksum(Glib::Checksum::CHECKSUM_SHA256, rawBlob));
+        }
+        return rawBlob;
+    });
+    std::shared_future<std::string> rawBlob = pTask->get_future().share();
+    _post(Task{0, [pTask](){ (*pTask)(); }});
+    return rawBlob;
+}
+
+std::shared_future<std::string> CtImageCache::checksum_png(std::shared_future<std::string> rawBlob)
+{
+    // a png still encoding was queued before, so is taken by a worker thread first
+    auto pTask = std::make_shared<std::packaged_task<std::string()>>([rawBlob]()
+    {
+        return Glib::Checksum::compute_checksum(Glib::Checksum::CHECKSUM_SHA256, rawBlob.get());
+    });
+    std::shared_future<std::string> checksum = pTask->get_future().share();
+    _post(Task{0, [pTask](){ (*pTask)(); }});
+    return checksum;
+}
+
+std::shared_future<std::string> CtImageCache::checksum_embfile(std::shared_ptr<CtEmbFileBlob> pBlob)
+{
+    auto pTask = std::make_shared<std::packaged_task<std::string()>>([pBlob]()
+    {
+        return pBlob->get_checksum();
+    });
+    std::shared_future<std::string> checksum = pTask->get_future().share();
+    _post(Task{0, [pTask](){ (*pTask)(); }});
+    return checksum;
+}
+
+std::future<void> CtImageCache::run_async(std::function<void()> task)
+{
+    auto pTask = std::make_shared<std::packaged_task<void()>>(task);
+    std::future<void> done = pTask->get_future();
+    _post(Task{0, [pTask](){ (*pTask)(); }});
+    return done;
+}
+
+void CtImageCache::_post(Task&& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+        if (_workers.empty())
+        {
+            const unsigned numWorkers = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned i = 0; i < numWorkers; ++i)
+                _workers.push_back(std::thread(&CtImageCache::_worker_loop, this));
+        }
+    }
+    _tasksCond.notify_one();
+}
+
+void CtImageCache::_worker_loop()
+{
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _tasksCond.wait(lock, [this](){ return _quit or not _tasks.empty(); });
+            if (_quit) return;
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task.run();
+    }
+}
+
+void CtImageCache::_on_results()
+{
+    std::vector<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        results.swap(_results);
+    }
+    for (Result& result : results)
+    {
+        Glib::RefPtr<Gdk::Pixbuf> rPixbuf = Glib::wrap(result.pPixbuf); // takes the reference
+        auto it = _entries.find(result.imageId);
+        if (it == _entries.end())
+        {
+            continue; // the image was removed in the meantime
+        }
+        if (not rPixbuf)
+        {
+            std::cerr << "!! image decode " << result.imageId << std::endl;
+            continue;
+        }
+        it->second.pImage->set_display_pixbuf(rPixbuf);
+    }
+}
+
+void CtImageCache::_trim()
+{
+    const gint64 now = g_get_monotonic_time();
+    for (auto itLru = _lru.begin(); itLru != _lru.end() and _bytes > BUDGET_BYTES; )
+    {
+        Entry& entry = _entries[*itLru];
+        ++itLru; // the image may move in the list while dropping
+        if (now - entry.lastDrawn < RECENTLY_DRAWN_US)
+            break; // the following ones are drawn even more recently
+        if (entry.bytes > 0)
+            entry.pImage->drop_pixbufs();
+    }
+}
+
+Glib::RefPtr<Gdk::Pixbuf> CtImageCache::decode(const std::string& rawBlob, const int width, const int height)
+{
+    try
+    {
+        Glib::RefPtr<Gdk::PixbufLoader> rPixbufLoader = Gdk::PixbufLoader::create("image/png", true);
+        if (width > 0)
+            rPixbufLoader->set_size(width, height);
+        rPixbufLoader->write(reinterpret_cast<const guint8*>(rawBlob.c_str()), rawBlob.size());
+        rPixbufLoader->close();
+        return rPixbufLoader->get_pixbuf();
+    }
+    catch (Glib::Error& error)
+    {
+        std::cerr << "!! image decode " << error.what() << std::endl;
+    }
+    return Glib::RefPtr<Gdk::Pixbuf>{};
+}
+
+// Width and height from the png header, without decoding
+bool CtImageCache::get_png_size(const std::string& rawBlob, int& width, int& height)
+{
+    static const std::string PNG_SIGNATURE{"\x89PNG\r\n\x1a\n"};
+    if (rawBlob.size() < 24 or 0 != rawBlob.compare(0, 8, PNG_SIGNATURE) or 0 != rawBlob.compare(12, 4, "IHDR"))
+        return false;
+    auto read_uint32 = [&rawBlob](size_t pos) {
+        return (guint32)(guint8)rawBlob[pos] << 24 | (guint32)(guint8)rawBlob[pos+1] << 16 |
+               (guint32)(guint8)rawBlob[pos+2] << 8 | (guint32)(guint8)rawBlob[pos+3];
+    };
+    const guint32 pngWidth = read_uint32(16);
+    const guint32 pngHeight = read_uint32(20);
+    if (0 == pngWidth or 0 == pngHeight or pngWidth > G_MAXINT or pngHeight > G_MAXINT)
+        return false;
+    width = (int)pngWidth;
+    height = (int)pngHeight;
+    return true;
+}
+
+std::list<std::weak_ptr<CtEmbFileBlob>> CtEmbFileBlob::_dbBlobs;
+
+std::shared_ptr<CtEmbFileBlob> CtEmbFileBlob::create_from_db(std::shared_ptr<sqlite3> pDb, const gint64 rowId, const size_t size)
+{
+    auto pBlob = std::make_shared<CtEmbFileBlob>(std::string{});
+    pBlob->_pDb = pDb;
+    pBlob->_rowId = rowId;
+    pBlob->_size = size;
+    _dbBlobs.push_back(pBlob);
+    return pBlob;
+}
+
+std::string CtEmbFileBlob::read_all() const
+{
+    if (not _pDb)
+    {
+        return _data;
+    }
+    std::string data;
+    data.reserve(_size);
+    (void)_read_chunks([&data](const char* pChunk, const size_t chunkSize) {
+        data.append(pChunk, chunkSize);
+        return true;
+    });
+    return data;
+}
+
+bool CtEmbFileBlob::write_to_file(const std::string& filepath) const
+{
+    std::ofstream file(filepath, std::ios::out | std::ios::binary);
+    if (not file)
+    {
+        std::cerr << "!! embfile write " << filepath << std::endl;
+        return false;
+    }
+    return _read_chunks([&file](const char* pChunk, const size_t chunkSize) {
+        file.write(pChunk, chunkSize);
+        return static_cast<bool>(file);
+    });
+}
+
+const std::string& CtEmbFileBlob::get_checksum() const
+{
+    std::lock_guard<std::mutex> lock(_checksumMutex);
+    if (_checksum.empty())
+    {
+        GChecksum* pChecksum = g_checksum_new(G_CHECKSUM_SHA256);
+        (void)_read_chunks([pChecksum](const char* pChunk, const size_t chunkSize) {
+            g_checksum_update(pChecksum, reinterpret_cast<const guchar*>(pChunk), static_cast<gssize>(chunkSize));
+            return true;
+        });
+        _checksum = g_checksum_get_string(pChecksum);
+        g_checksum_free(pChecksum);
+    }
+    return _checksum;
+}
+
+bool CtEmbFileBlob::write_to_db_row(sqlite3* pDb, const gint64 rowId) const
+{
+    if (0 == size())
+    {
+        return true;
+    }
+    sqlite3_blob* pBlob{nullptr};
+    if (SQLITE_OK != sqlite3_blob_open(pDb, "main", "image", "png", rowId, 1/*read write*/, &pBlob))
+    {
+        std::cerr << "!! sqlite3_blob_open: " << sqlite3_errmsg(pDb) << std::endl;
+        return false;
+    }
+    int offset{0};
+    const bool retVal = _read_chunks([pBlob, &offset](const char* pChunk, const size_t chunkSize) {
+        if (SQLITE_OK != sqlite3_blob_write(pBlob, pChunk, static_cast<int>(chunkSize), offset))
+        {
+            return false;
+        }
+        offset += static_cast<int>(chunkSize);
+        return true;
+    });
+    if (not retVal)
+    {
+        std::cerr << "!! sqlite3_blob_write: " << sqlite3_errmsg(pDb) << std::endl;
+    }
+    sqlite3_blob_close(pBlob);
+    return retVal;
+}
+
+void CtEmbFileBlob::set_db_row(std::shared_ptr<sqlite3> pDb, const gint64 rowId)
+{
+    if (not _pDb)
+    {
+        _size = _data.size();
+        std::string().swap(_data);
+        _dbBlobs.push_back(weak_from_this());
+    }
+    _pDb = pDb;
+    _rowId = rowId;
+}
+
+std::vector<gint64> CtEmbFileBlob::get_db_row_ids(sqlite3* pDb)
+{
+    std::vector<gint64> rowIds;
+    for (auto it = _dbBlobs.begin(); it != _dbBlobs.end(); )
+    {
+        std::shared_ptr<CtEmbFileBlob> pBlob = it->lock();
+        if (not pBlob or not pBlob->_pDb)
+        {
+            it = _dbBlobs.erase(it);
+            continue;
+        }
+        if (pBlob->_pDb.get() == pDb)
+        {
+            rowIds.push_back(pBlob->_rowId);
+        }
+        ++it;
+    }
+    return rowIds;
+}
+
+void CtEmbFileBlob::on_db_rows_removed(sqlite3* pDb, const std::vector<gint64>& rowIds)
+{
+    for (auto it = _dbBlobs.begin(); it != _dbBlobs.end(); )
+    {
+        std::shared_ptr<CtEmbFileBlob> pBlob = it->lock();
+        if (pBlob and pBlob->_pDb.get() == pDb and vec::exists(rowIds, pBlob->_rowId))
+        {
+            // only held by the undo states, the row is not written again
+            pBlob->_data = pBlob->read_all();
+            pBlob->_pDb.reset();
+        }
+        if (not pBlob or not pBlob->_pDb)
+        {
+            it = _dbBlobs.erase(it);
+        }
+        else ++it;
+    }
+}
+
+void CtEmbFileBlob::on_db_rows_renumbered(sqlite3* pDb, const std::unordered_map<gint64, gint64>& newRowIds)
+{
+    for (const std::weak_ptr<CtEmbFileBlob>& wpBlob : _dbBlobs)
+    {
+        std::shared_ptr<CtEmbFileBlob> pBlob = wpBlob.lock();
+        if (pBlob and pBlob->_pDb.get() == pDb)
+        {
+            auto it = newRowIds.find(pBlob->_rowId);
+            if (it != newRowIds.end())
+            {
+                pBlob->_rowId = it->second;
+            }
+        }
+    }
+}
+
+bool CtEmbFileBlob::_read_chunks(const std::function<bool(const char*, const size_t)>& consumer) const
+{
+    if (not _pDb)
+    {
+        return consumer(_data.c_str(), _data.size());
+    }
+    if (0 == _size)
+    {
+        return true;
+    }
+    sqlite3_blob* pBlob{nullptr};
+    if (SQLITE_OK != sqlite3_blob_open(_pDb.get(), "main", "image", "png", _rowId, 0/*read only*/, &pBlob))
+    {
+        std::cerr << "!! sqlite3_blob_open: " << sqlite3_errmsg(_pDb.get()) << std::endl;
+        return false;
+    }
+    bool retVal{true};
+    std::vector<char> chunk(std::min(CHUNK_BYTES, _size));
+    for (size_t offset = 0; retVal and offset < _size; offset += chunk.size())
+    {
+        const size_t chunkSize = std::min(chunk.size(), _size - offset);
+        retVal = SQLITE_OK == sqlite3_blob_read(pBlob, chunk.data(), static_cast<int>(chunkSize), static_cast<int>(offset)) and
+                 consumer(chunk.data(), chunkSize);
+    }
+    sqlite3_blob_close(pBlob);
+    return retVal;
+}
@@ -22,34 +22,111 @@
 #pragma once
 
 #include <gtkmm.h>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <unordered_map>
 #include "ct_const.h"
 #include "ct_codebox.h"
 #include "ct_widgets.h"
 
+class CtImagePng;
+class CtEmbFileBlob;
+
+// Decodes the png images on worker threads, scaled to the size they are displayed at,
+// and keeps the decoded pixbufs within a memory budget dropping those drawn least recently.
+// The same worker threads encode the new images and write the images of the exports
+class CtImageCache
+{
+public:
+    CtImageCache();
+    ~CtImageCache();
+
+    guint64 add_image(CtImagePng* pImage);
+    void    remove_image(const guint64 imageId);
+    void    image_drawn(const guint64 imageId);
+    void    set_image_bytes(const guint64 imageId, const size_t bytes);
+    // scaled from the full pixbuf if any, else decoded from the png
+    void    request_decode(const guint64 imageId, std::shared_future<std::string> rawBlob, Glib::RefPtr<Gdk::Pixbuf> rFullPixbuf,
+                           const int width, const int height);
+
+    // the sha256 of the png is computed on the worker thread too if asked for
+    std::shared_future<std::string> encode_png(Glib::RefPtr<Gdk::Pixbuf> rPixbuf, std::shared_future<std::string>* pChecksum = nullptr);
+    std::shared_future<std::string> checksum_png(std::shared_future<std::string> rawBlob);
+    std::shared_future<std::string> checksum_embfile(std::shared_ptr<CtEmbFileBlob> pBlob);
+    std::future<void>               run_async(std::function<void()> task);
+
+    // full size if width is 0
+    static Glib::RefPtr<Gdk::Pixbuf> decode(const std::string& rawBlob, const int width, const int height);
+    static bool get_png_size(const std::string& rawBlob, int& width, int& height);
+
+    static const size_t  BUDGET_BYTES{256*1024*1024};
+    static const gint64  RECENTLY_DRAWN_US{2000000}; // never dropped, likely still on screen
+
+private:
+    struct Entry
+    {
+        CtImagePng*                  pImage;
+        size_t                       bytes{0};
+        gint64                       lastDrawn{0};
+        std::list<guint64>::iterator itLru;
+    };
+    struct Task
+    {
+        guint64               imageId; // dropped if the image is removed before it runs, 0 if never
+        std::function<void()> run;
+    };
+    struct Result
+    {
+        guint64    imageId;
+        GdkPixbuf* pPixbuf; // owned reference
+        int        width;
+    };
+    void _post(Task&& task);
+    void _worker_loop();
+    void _on_results();
+    void _trim();
+
+    std::unordered_map<guint64, Entry> _entries;   // main thread only
+    std::list<guint64>                 _lru;       // least recently drawn first
+    size_t                             _bytes{0};
+    guint64                            _nextImageId{1};
+
+    std::mutex                         _mutex;     // for the tasks and the results
+    std::condition_variable            _tasksCond;
+    std::deque<Task>                   _tasks;
+    std::vector<Result>                _results;
+    bool                               _quit{false};
+    std::vector<std::thread>           _workers;
+    Glib::Dispatcher                   _dispatcher;
+};
+
 class CtImage : public CtAnchoredWidget
 {
 public:
-    CtImage(CtMainWin* pCtMainWin,
-            const std::string& rawBlob,
-            const char* mimeType,
-            const int charOffset,
-            const std::string& justification);
     CtImage(CtMainWin* pCtMainWin,
             const char* stockImage,
             const int size,
             const int charOffset,
             const std::string& justification);
-    CtImage(CtMainWin* pCtMainWin,
-            Glib::RefPtr<Gdk::Pixbuf> pixBuf,
-            const int charOffset,
-            const std::string& justification);
     virtual ~CtImage() override;
 
     void apply_width_height(const int /*parentTextWidth*/) override {}
     void set_modified_false() override {}
 
-    void save(const Glib::ustring& file_name, const Glib::ustring& type);
-    Glib::RefPtr<Gdk::Pixbuf> get_pixbuf() { return _rPixbuf; }
+    virtual void save(const Glib::ustring& file_name, const Glib::ustring& type);
+    virtual Glib::RefPtr<Gdk::Pixbuf> get_pixbuf() { return _rPixbuf; }
+
+protected:
+    // no pixbuf yet
+    CtImage(CtMainWin* pCtMainWin,
+            const int charOffset,
+            const std::string& justification);
 
 protected:
     Gtk::Image _image;
@@ -64,28 +141,54 @@ public:
                const Glib::ustring& link,
                const int charOffset,
                const std::string& justification);
+    CtImagePng(CtMainWin* pCtMainWin,
+               std::shared_future<std::string> rawBlob,
+               const Glib::ustring& link,
+               const int charOffset,
+               const std::string& justification,
+               const guint64 rawBlobId = 0);
     CtImagePng(CtMainWin* pCtMainWin,
                Glib::RefPtr<Gdk::Pixbuf> pixBuf,
                const Glib::ustring& link,
                const int charOffset,
                const std::string& justification);
-    virtual ~CtImagePng() override {}
+    virtual ~CtImagePng() override;
 
     void to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment) override;
     bool to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment) override;
     CtAnchWidgType get_type() override { return CtAnchWidgType::ImagePng; }
     std::shared_ptr<CtAnchoredWidgetState> get_state() override;
+    void save(const Glib::ustring& file_name, const Glib::ustring& type) override;
+    void apply_width_height(const int parentTextWidth) override;
+    // full size, decoded now if not already
+    Glib::RefPtr<Gdk::Pixbuf> get_pixbuf() override;
+
+    void set_display_pixbuf(Glib::RefPtr<Gdk::Pixbuf> rPixbuf);
+    void drop_pixbufs();
 
-    const std::string get_raw_blob();
+    const std::string&              get_raw_blob() { return _rawBlob.get(); }
+    std::shared_future<std::string> get_raw_blob_future() { return _rawBlob; }
+    guint64                         get_raw_blob_id() { return _rawBlobId; }
     void update_label_widget();
     const Glib::ustring& get_link() { return _link; }
     void set_link(const Glib::ustring& link) { _link = link; }
 
 private:
     bool _on_button_press_event(GdkEventButton* event);
+    bool _on_image_draw(const Cairo::RefPtr<Cairo::Context>& cr);
+    void _update_cache_bytes();
 
 protected:
     Glib::ustring _link;
+    std::shared_future<std::string> _rawBlob; // encoded png, as read from the document or encoded on a worker thread
+    guint64 _rawBlobId;                       // the same for the images sharing the raw blob, as the pending ones can't be compared
+    guint64 _cacheId;
+    int     _fullWidth{0};
+    int     _fullHeight{0};
+    int     _displayWidth{0};        // fit to the text view width
+    int     _displayHeight{0};
+    int     _decodeRequestedWidth{0};
+    Glib::RefPtr<Gdk::Pixbuf> _rDisplayPixbuf;
 };
 
 class CtImageAnchor : public CtImage
@@ -113,12 +216,54 @@ protected:
     Glib::ustring _anchorName;
 };
 
+// Contents of an embedded file. Those read from a ctb/ctx document stay in the database, referenced
+// by their row, and are streamed on demand so that opening a node with a large attachment costs
+// kilobytes. The blob is shared by the widget and its undo states, which all follow the row
+// when it is rewritten.
+class CtEmbFileBlob : public std::enable_shared_from_this<CtEmbFileBlob>
+{
+public:
+    explicit CtEmbFileBlob(std::string data) : _data{std::move(data)} {}
+    static std::shared_ptr<CtEmbFileBlob> create_from_db(std::shared_ptr<sqlite3> pDb, const gint64 rowId, const size_t size);
+
+    size_t      size() const { return _pDb ? _size : _data.size(); }
+    size_t      get_memory_size() const { return _data.size(); }
+    std::string read_all() const;
+    bool        write_to_file(const std::string& filepath) const;
+    // sha256 of the contents, which never change, computed once
+    const std::string& get_checksum() const;
+    // into the png column of a row inserted with a zeroblob of the same size
+    bool        write_to_db_row(sqlite3* pDb, const gint64 rowId) const;
+    // the contents were written in the row, they are dropped from memory
+    void        set_db_row(std::shared_ptr<sqlite3> pDb, const gint64 rowId);
+
+    // rows of the database referenced by any blob
+    static std::vector<gint64> get_db_row_ids(sqlite3* pDb);
+    // the blobs still referencing the rows about to be deleted read them in memory
+    static void on_db_rows_removed(sqlite3* pDb, const std::vector<gint64>& rowIds);
+    static void on_db_rows_renumbered(sqlite3* pDb, const std::unordered_map<gint64, gint64>& newRowIds);
+
+    static constexpr size_t CHUNK_BYTES{1024*1024};
+
+private:
+    bool _read_chunks(const std::function<bool(const char*, const size_t)>& consumer) const;
+
+    std::string              _data;      // raw data, not a string, if not in the database
+    std::shared_ptr<sqlite3> _pDb;
+    gint64                   _rowId{0};
+    size_t                   _size{0};
+    mutable std::string      _checksum;
+    mutable std::mutex       _checksumMutex; // the checksum is computed on the worker threads too
+
+    static std::list<std::weak_ptr<CtEmbFileBlob>> _dbBlobs;
+};
+
 class CtImageEmbFile : public CtImage
 {
 public:
     CtImageEmbFile(CtMainWin* pCtMainWin,
                    const Glib::ustring& fileName,
-                   const std::string& rawBlob,
+                   std::shared_ptr<CtEmbFileBlob> rawBlob,
                    const double& timeSeconds,
                    const int charOffset,
                    const std::string& justification);
@@ -130,8 +275,8 @@ public:
     std::shared_ptr<CtAnchoredWidgetState> get_state() override;
 
     const Glib::ustring& get_file_name() { return _fileName; }
-    const std::string&   get_raw_blob() { return _rawBlob; }
-    void                 set_raw_blob(char* buffer, size_t size) { _rawBlob = std::string(buffer, size);}
+    std::shared_ptr<CtEmbFileBlob> get_raw_blob() { return _rawBlob; }
+    void                 set_raw_blob(const char* buffer, size_t size) { _rawBlob = std::make_shared<CtEmbFileBlob>(std::string(buffer, size)); }
     double               get_time() { return _timeSeconds; }
     void                 set_time(time_t time) { _timeSeconds = time; }
 
@@ -143,6 +288,6 @@ private:
 
 protected:
     Glib::ustring _fileName;
-    std::string   _rawBlob;      // raw data, not a string
+    std::shared_ptr<CtEmbFileBlob> _rawBlob;
     double        _timeSeconds;
 };
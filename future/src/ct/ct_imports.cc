@@ -26,24 +26,42 @@
 // Parse plain text for possible web links
 std::vector<std::pair<int, int>> CtImports::get_web_links_offsets_from_plain_text(const Glib::ustring& plain_text)
 {
+    // scan the bytes, the starters and separators are ascii, and count the chars on the way for the offsets
     std::vector<std::pair<int, int>> web_links;
-    int max_end_offset = (int)plain_text.size();
-    int max_start_offset = max_end_offset - 7;
-    int start_offset = 0;
-    while (start_offset < max_start_offset)
+    const std::string& text = plain_text.raw();
+    const size_t num_bytes = text.size();
+    int max_start_offset = (int)plain_text.size() - 7;
+    size_t byte_idx = 0;
+    int char_offset = 0;
+    auto advance_to = [&](const size_t byte_target) {
+        for (; byte_idx < byte_target; ++byte_idx)
+            if ((text[byte_idx] & 0xC0) != 0x80) // not an utf-8 continuation byte
+                ++char_offset;
+    };
+    while (char_offset < max_start_offset)
     {
-        if (CtTextIterUtil::get_first_chars_of_string_at_offset_are(plain_text, start_offset, CtConst::WEB_LINK_STARTERS))
+        size_t start_byte = text.find_first_of("hfw", byte_idx);
+        if (std::string::npos == start_byte)
+            break;
+        advance_to(start_byte);
+        if (char_offset >= max_start_offset)
+            break;
+        bool is_starter{false};
+        for (const auto& starter: CtConst::WEB_LINK_STARTERS)
+            if (0 == text.compare(start_byte, starter.bytes(), starter.raw()))
+            {
+                is_starter = true;
+                break;
+            }
+        if (is_starter)
         {
-            int end_offset = start_offset + 3;
-            while (end_offset < max_end_offset
-                   && plain_text[(size_t)end_offset] != CtConst::CHAR_SPACE[0]
-                   && plain_text[(size_t)end_offset] != CtConst::CHAR_NEWLINE[0])
-                end_offset += 1;
-            web_links.push_back(std::make_pair(start_offset, end_offset));
-            start_offset = end_offset + 1;
+            const int start_offset = char_offset;
+            size_t end_byte = text.find_first_of(" \n", start_byte + 3);
+            advance_to(std::string::npos == end_byte ? num_bytes : end_byte);
+            web_links.push_back(std::make_pair(start_offset, char_offset));
         }
-        else
-            start_offset += 1;
+        // the starter or the separator is a single byte char
+        advance_to(std::min(byte_idx + 1, num_bytes));
     }
     return web_links;
 }
@@ -59,11 +59,11 @@ CtMainWin::CtMainWin(CtConfig*        pCtConfig,
     if (_pCtConfig->treeRightSide)
     {
         _hPaned.add1(_vboxText);
-        _hPaned.add2(_scrolledwindowTree);
+        _hPaned.add2(_init_tree_filter());
     }
     else
     {
-        _hPaned.add1(_scrolledwindowTree);
+        _hPaned.add1(_init_tree_filter());
         _hPaned.add2(_vboxText);
     }
     _hPaned.property_wide_handle() = true;
@@ -94,6 +94,9 @@ CtMainWin::CtMainWin(CtConfig*        pCtConfig,
     _ctTextview.signal_event().connect(sigc::mem_fun(*this, &CtMainWin::_on_textview_event));
     _ctTextview.signal_event_after().connect(sigc::mem_fun(*this, &CtMainWin::_on_textview_event_after));
     _ctTextview.signal_scroll_event().connect(sigc::mem_fun(*this, &CtMainWin::_on_textview_scroll_event));
+    _scrolledwindowText.get_vadjustment()->signal_value_changed().connect([this](){
+        if (_widgetsWidthPending) _queue_widgets_width_update();
+    });
 
     _uCtPairCodeboxMainWin.reset(new CtPairCodeboxMainWin{nullptr, this});
     g_signal_connect(G_OBJECT(_ctTextview.gobj()), "cut-clipboard", G_CALLBACK(CtClipboard::on_cut_clipboard), _uCtPairCodeboxMainWin.get());
@@ -115,6 +118,7 @@ CtMainWin::CtMainWin(CtConfig*        pCtConfig,
 CtMainWin::~CtMainWin()
 {
     //printf("~CtMainWin\n");
+    _widgetsWidthConnection.disconnect();
 }
 
 Glib::RefPtr<Gdk::Pixbuf> CtMainWin::get_icon(const std::string& name, int size)
@@ -439,6 +443,116 @@ void CtMainWin::_reset_CtTreestore_CtTreeview()
     _uCtTreeview->signal_popup_menu().connect(sigc::mem_fun(*this, &CtMainWin::_on_treeview_popup_menu));
 
     _uCtTreeview->get_style_context()->add_class("ct-tree-panel");
+
+    _treeFilterEntry.set_text("");
+}
+
+Gtk::VBox& CtMainWin::_init_tree_filter()
+{
+    _treeFilterEntry.set_placeholder_text(_("Filter Nodes Names and Tags"));
+    _rTreeFilterStore = Gtk::ListStore::create(_treeFilterColumns);
+    _treeFilterView.set_model(_rTreeFilterStore);
+    _treeFilterView.set_headers_visible(false);
+    _treeFilterView.set_tooltip_column(2/*colNodePath*/);
+    _treeFilterView.append_column("", _treeFilterColumns.colNodeName);
+    _treeFilterView.append_column("", _treeFilterColumns.colNodePath);
+    // fixed height rows are not measured one by one
+    for (Gtk::TreeViewColumn* pColumn : _treeFilterView.get_columns())
+    {
+        pColumn->set_sizing(Gtk::TREE_VIEW_COLUMN_FIXED);
+        pColumn->set_resizable(true);
+    }
+    _treeFilterView.get_column(0)->set_fixed_width(150);
+    static_cast<Gtk::CellRendererText*>(_treeFilterView.get_column_cell_renderer(1))->property_ellipsize() = Pango::ELLIPSIZE_START;
+    _treeFilterView.set_fixed_height_mode(true);
+    _scrolledwindowTreeFilter.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+    _scrolledwindowTreeFilter.add(_treeFilterView);
+
+    _treeFilterEntry.signal_changed().connect(sigc::mem_fun(*this, &CtMainWin::_on_tree_filter_changed));
+    _treeFilterEntry.signal_key_press_event().connect(sigc::mem_fun(*this, &CtMainWin::_on_tree_filter_key_press_event), false);
+    _treeFilterEntry.signal_activate().connect([this](){
+        Gtk::TreeIter treeIter = _treeFilterView.get_selection()->get_selected();
+        if (not treeIter) treeIter = _rTreeFilterStore->children().begin();
+        if (treeIter) _tree_filter_select_node(treeIter->get_value(_treeFilterColumns.colNodeId));
+    });
+    _treeFilterView.signal_row_activated().connect([this](const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn*){
+        Gtk::TreeIter treeIter = _rTreeFilterStore->get_iter(path);
+        if (treeIter) _tree_filter_select_node(treeIter->get_value(_treeFilterColumns.colNodeId));
+    });
+
+    _vboxTree.pack_start(_treeFilterEntry, false, false);
+    _vboxTree.pack_start(_scrolledwindowTree);
+    _vboxTree.pack_start(_scrolledwindowTreeFilter);
+    return _vboxTree;
+}
+
+void CtMainWin::tree_filter_grab_focus()
+{
+    if (not _pCtConfig->treeVisible)
+    {
+        _pCtConfig->treeVisible = true;
+        show_hide_tree_view(true);
+    }
+    _treeFilterEntry.grab_focus();
+}
+
+// Narrow the matching nodes on every keystroke, the index keeps the latest matches
+void CtMainWin::_on_tree_filter_changed()
+{
+    const Glib::ustring pattern = _treeFilterEntry.get_text();
+    if (pattern.empty())
+    {
+        _rTreeFilterStore->clear();
+        _scrolledwindowTreeFilter.hide();
+        _scrolledwindowTree.show();
+        return;
+    }
+    const size_t maxResults{500}; // enough to choose from, few enough to fill in a frame
+    const std::vector<CtNodeNameIndex::Match> matches = _uCtTreestore->get_name_index().query(pattern, maxResults);
+    _treeFilterView.unset_model(); // no view updates while filling
+    _rTreeFilterStore->clear();
+    for (const CtNodeNameIndex::Match& match : matches)
+    {
+        Gtk::TreeRow row = *_rTreeFilterStore->append();
+        row[_treeFilterColumns.colNodeId] = match.nodeId;
+        row[_treeFilterColumns.colNodeName] = _uCtTreestore->get_node_name_from_node_id(match.nodeId);
+        row[_treeFilterColumns.colNodePath] = _uCtTreestore->get_name_index().get_node_path(match.nodeId);
+    }
+    _treeFilterView.set_model(_rTreeFilterStore);
+    if (not matches.empty())
+    {
+        _treeFilterView.set_cursor(Gtk::TreePath("0"));
+    }
+    _scrolledwindowTree.hide();
+    _scrolledwindowTreeFilter.show();
+}
+
+bool CtMainWin::_on_tree_filter_key_press_event(GdkEventKey* event)
+{
+    if (GDK_KEY_Escape == event->keyval)
+    {
+        _treeFilterEntry.set_text("");
+        _uCtTreeview->grab_focus();
+        return true;
+    }
+    if ( (GDK_KEY_Down == event->keyval or GDK_KEY_Up == event->keyval) and
+         _scrolledwindowTreeFilter.get_visible() )
+    {
+        _treeFilterView.grab_focus();
+        return true;
+    }
+    return false;
+}
+
+void CtMainWin::_tree_filter_select_node(const gint64 node_id)
+{
+    CtTreeIter treeIter = _uCtTreestore->get_node_from_node_id(node_id);
+    _treeFilterEntry.set_text("");
+    if (treeIter)
+    {
+        _uCtTreeview->set_cursor_safe(treeIter);
+        _ctTextview.grab_focus();
+    }
 }
 
 void CtMainWin::config_apply_before_show_all()
@@ -454,6 +568,7 @@ void CtMainWin::config_apply_before_show_all()
 
 void CtMainWin::config_apply_after_show_all()
 {
+    _scrolledwindowTreeFilter.hide();
     show_hide_tree_view(_pCtConfig->treeVisible);
     show_hide_win_header(_pCtConfig->showNodeNameHeader);
 
@@ -507,7 +622,7 @@ void CtMainWin::configure_theme()
     theme_css += ".ct-tree-panel:selected { background: #5294e2;  } ";
     theme_css += ".ct_header-panel { background-color: " + _pCtConfig->ttDefBg + "; } ";
     theme_css += ".ct-table-header-cell { font-weight: bold; } ";
-    theme_css += ".ct-table grid { background: #cccccc; border-style:solid; border-width: 1px; border-color: gray; } ";
+    theme_css += ".ct-table-grid { background: #cccccc; } ";
 
     if (!_css_provider_theme)
     {
@@ -540,6 +655,14 @@ Gtk::HBox& CtMainWin::_init_status_bar()
     return _ctStatusBar.hbox;
 }
 
+void CtMainWin::set_busy(const bool busy)
+{
+    _pMenuBar->set_sensitive(not busy);
+    _pToolbar->set_sensitive(not busy);
+    _hPaned.set_sensitive(not busy);
+    set_deletable(not busy);
+}
+
 Gtk::EventBox& CtMainWin::_init_window_header()
 {
     _ctWinHeader.nameLabel.set_padding(10, 0);
@@ -803,6 +926,11 @@ bool CtMainWin::read_nodes_from_gio_file(const Glib::RefPtr<Gio::File>& r_file,
     }
     if (retOk and not isImport)
     {
+        if (CtDocEncrypt::False == docEncrypt)
+        {
+            // no index cache beside encrypted documents, it would disclose their content
+            _uCtTreestore->search_index_load(filepath);
+        }
         _set_new_curr_doc(r_file, password);
         _title_update(false/*saveNeeded*/);
         set_bookmarks_menu_items();
@@ -912,6 +1040,7 @@ void CtMainWin::update_selected_node_statusbar_info()
             const std::string timestamp_lastsave = str::time_format(_pCtConfig->timestampFormat, treeIter.get_node_modification_time());
             statusbar_text += separator_text + _("Date Modified") + _(": ") + timestamp_lastsave;
         }
+        statusbar_text += separator_text + _("Undo Memory") + _(": ") + Glib::format_size(CtStateMachine::get_memory_usage());
     }
     _ctStatusBar.update_status(statusbar_text);
 }
@@ -954,6 +1083,7 @@ void CtMainWin::update_window_save_needed(const CtSaveNeededUpdType update_type,
         case CtSaveNeededUpdType::nbuf:
         {
             treeIter.pending_edit_db_node_buff();
+            _uCtTreestore->search_index_invalidate_node(treeIter.get_node_id());
             g_autoptr(GDateTime) pGDateTime = g_date_time_new_now_local();
             const gint64 curr_time = g_date_time_to_unix(pGDateTime);
             treeIter.set_node_modification_time(curr_time);
@@ -975,6 +1105,7 @@ void CtMainWin::update_window_save_needed(const CtSaveNeededUpdType update_type,
             std::vector<gint64> rm_node_ids = treeIter.get_children_node_ids();
             rm_node_ids.push_back(top_node_id);
             _uCtTreestore->pending_rm_db_nodes(rm_node_ids);
+            _uCtTreestore->search_index_remove_nodes(rm_node_ids);
             for (auto node_id: rm_node_ids)
                 get_state_machine().delete_states(node_id);
         } break;
@@ -1003,9 +1134,10 @@ void CtMainWin::load_buffer_from_state(std::shared_ptr<CtNodeState> state, CtTre
 
     text_buffer->erase(text_buffer->begin(), text_buffer->end());
     std::list<CtAnchoredWidget*> widgets;
-    for (xmlpp::Node* text_node: state->buffer_xml.get_root_node()->get_children())
+    CtXmlRead ctXmlRead(this, nullptr, state->get_buffer_xml().c_str());
+    for (xmlpp::Node* text_node: ctXmlRead.get_document()->get_root_node()->get_children())
     {
-        CtXmlRead(this).get_text_buffer_slot(gsv_buffer, nullptr, widgets, text_node);
+        ctXmlRead.get_text_buffer_slot(gsv_buffer, nullptr, widgets, text_node);
     }
     tree_iter.remove_all_embedded_widgets();
     // CtXmlRead(this).get_text_buffer_slot didn't fill widgets, they are kept separately
@@ -1286,11 +1418,44 @@ void CtMainWin::_on_textview_size_allocate(Gtk::Allocation& allocation)
     else if (_prevTextviewWidth != allocation.get_width())
     {
         _prevTextviewWidth = allocation.get_width();
-        auto widgets = curr_tree_iter().get_all_embedded_widgets();
-        for (auto& widget: widgets)
-            if (CtCodebox* codebox = dynamic_cast<CtCodebox*>(widget))
-                if (not codebox->get_width_in_pixels())
-                    codebox->apply_width_height(allocation.get_width());
+        _widgetsWidthPending = true;
+        _queue_widgets_width_update();
+    }
+}
+
+// The widgets are resized once the width settles, the ones out of view when scrolled into view
+void CtMainWin::_queue_widgets_width_update()
+{
+    _widgetsWidthConnection.disconnect();
+    _widgetsWidthConnection = Glib::signal_timeout().connect([this](){
+        _update_visible_widgets_width();
+        return false; /* one shot */
+    }, 100);
+}
+
+void CtMainWin::_update_visible_widgets_width()
+{
+    _widgetsWidthPending = false;
+    if (not curr_tree_iter()) return;
+    Gdk::Rectangle visibleRect;
+    _ctTextview.get_visible_rect(visibleRect);
+    Glib::RefPtr<Gtk::TextBuffer> rTextBuffer = _ctTextview.get_buffer();
+    for (CtAnchoredWidget* pWidget : curr_tree_iter().get_all_embedded_widgets())
+    {
+        CtCodebox* codebox = dynamic_cast<CtCodebox*>(pWidget);
+        if (not (codebox and not codebox->get_width_in_pixels()) and not dynamic_cast<CtImagePng*>(pWidget))
+            continue;
+        Gdk::Rectangle location;
+        _ctTextview.get_iter_location(rTextBuffer->get_iter_at_child_anchor(pWidget->getTextChildAnchor()), location);
+        if (location.get_y() + location.get_height() >= visibleRect.get_y() and
+            location.get_y() <= visibleRect.get_y() + visibleRect.get_height())
+        {
+            pWidget->apply_width_height(_prevTextviewWidth);
+        }
+        else
+        {
+            _widgetsWidthPending = true;
+        }
     }
 }
 
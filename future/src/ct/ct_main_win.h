@@ -54,6 +54,14 @@ private:
     bool _progress_stop;
 };
 
+struct CtTreeFilterModelColumns : public Gtk::TreeModel::ColumnRecord
+{
+    CtTreeFilterModelColumns() { add(colNodeId); add(colNodeName); add(colNodePath); }
+    Gtk::TreeModelColumn<gint64>         colNodeId;
+    Gtk::TreeModelColumn<Glib::ustring>  colNodeName;
+    Gtk::TreeModelColumn<Glib::ustring>  colNodePath;
+};
+
 struct CtWinHeader
 {
     Gtk::HBox        headerBox;
@@ -109,6 +117,8 @@ public:
                           CtSQLite* const pCtSQLite);
     void curr_file_mod_time_update_value(const bool doEnable); // pygtk: modification_time_update_value
     void update_selected_node_statusbar_info();
+    // while a long operation lets the events be processed, the user is left with the stop button only
+    void set_busy(const bool busy);
 
     CtTreeIter               curr_tree_iter()  { return _uCtTreestore->to_ct_tree_iter(_uCtTreeview->get_selection()->get_selected()); }
     CtTreeStore&             curr_tree_store() { return *_uCtTreestore; }
@@ -122,12 +132,15 @@ public:
     CtTmp*                   get_ct_tmp()      { return _pCtTmp; }
     Gtk::IconTheme*          get_icon_theme()  { return _pGtkIconTheme; }
     CtStateMachine&          get_state_machine() { return _ctStateMachine; }
+    CtImageCache&            get_image_cache() { return _ctImageCache; }
     Glib::RefPtr<Gtk::TextTagTable>&  get_text_tag_table() { return _rGtkTextTagTable; }
     Glib::RefPtr<Gtk::CssProvider>&   get_css_provider()   { return _rGtkCssProvider; }
     Gsv::LanguageManager*    get_language_manager() { return _pGsvLanguageManager; }
     Gsv::StyleSchemeManager* get_style_scheme_manager() { return _pGsvStyleSchemeManager; }
 
     bool&         user_active()     { return _userActive; } // use as a function, because it's easier to put breakpoint
+    void          set_paste_in_progress(const bool in_progress) { _pasteInProgress = in_progress; }
+    bool          is_paste_in_progress() { return _pasteInProgress; }
     int&          cursor_key_press() { return _cursorKeyPress; }
     int&          hovering_link_iter_offset() { return _hovering_link_iter_offset; }
 
@@ -145,6 +158,7 @@ public:
 private:
     Gtk::HBox&     _init_status_bar();
     Gtk::EventBox& _init_window_header();
+    Gtk::VBox&     _init_tree_filter();
 
 public:
     void window_header_update();
@@ -161,11 +175,12 @@ public:
     void set_menu_items_special_chars();
 
     void show_hide_toolbar(bool visible)    { _pToolbar->property_visible() = visible; }
-    void show_hide_tree_view(bool visible)  { _scrolledwindowTree.property_visible() = visible; }
+    void show_hide_tree_view(bool visible)  { _vboxTree.property_visible() = visible; }
     void show_hide_win_header(bool visible) { _ctWinHeader.headerBox.property_visible() = visible; }
     void set_toolbar_icon_size(int size)    { _pToolbar->property_icon_size() = CtMiscUtil::getIconSize(size); }
 
     void resetPrevTreeIter()                { _prevTreeIter = CtTreeIter(); }
+    void tree_filter_grab_focus();
 private:
     bool                _on_window_key_press_event(GdkEventKey* event);
 
@@ -174,11 +189,16 @@ private:
     bool                _on_treeview_key_press_event(GdkEventKey* event);
     bool                _on_treeview_popup_menu();
     bool                _on_treeview_scroll_event(GdkEventScroll* event);
+    void                _on_tree_filter_changed();
+    bool                _on_tree_filter_key_press_event(GdkEventKey* event);
+    void                _tree_filter_select_node(const gint64 node_id);
 
     void                _on_textview_populate_popup(Gtk::Menu* menu);
     bool                _on_textview_motion_notify_event(GdkEventMotion* event);
     bool                _on_textview_visibility_notify_event(GdkEventVisibility* event);
     void                _on_textview_size_allocate(Gtk::Allocation& allocation);
+    void                _queue_widgets_width_update();
+    void                _update_visible_widgets_width();
     bool                _on_textview_event(GdkEvent* event); // pygtk: on_sourceview_event
     void                _on_textview_event_after(GdkEvent* event); // pygtk: on_sourceview_event_after
     bool                _on_textview_scroll_event(GdkEventScroll* event);
@@ -211,8 +231,15 @@ private:
     Gtk::MenuItem*               _pSpecialCharsSubmenu{nullptr};
     Gtk::MenuItem*               _pRecentDocsSubmenu{nullptr};
     Gtk::MenuToolButton*         _pRecentDocsMenuToolButton{nullptr};
+    Gtk::VBox                    _vboxTree;
+    Gtk::SearchEntry             _treeFilterEntry;
+    Gtk::ScrolledWindow          _scrolledwindowTreeFilter;
+    Gtk::TreeView                _treeFilterView;
+    CtTreeFilterModelColumns     _treeFilterColumns;
+    Glib::RefPtr<Gtk::ListStore> _rTreeFilterStore;
     Gtk::ScrolledWindow          _scrolledwindowTree;
     Gtk::ScrolledWindow          _scrolledwindowText;
+    CtImageCache                 _ctImageCache; // before the tree store, outliving the images
     std::unique_ptr<CtTreeStore> _uCtTreestore;
     std::unique_ptr<CtTreeView>  _uCtTreeview;
     CtTextView                   _ctTextview;
@@ -231,9 +258,12 @@ private:
 
 private:
     bool                _userActive{true}; // pygtk: user_active
+    bool                _pasteInProgress{false}; // a large plain text paste by chunks, it owns the status bar stop button
     int                 _cursorKeyPress{-1};
     int                 _hovering_link_iter_offset{-1};
     int                 _prevTextviewWidth{0};
+    bool                _widgetsWidthPending{false}; // widgets out of view still to be resized to the text width
+    sigc::connection    _widgetsWidthConnection;
     bool                _fileSaveNeeded{false}; // pygtk: file_update
     std::unordered_map<gint64, gint64> _latestStatusbarUpdateTime; // pygtk: latest_statusbar_update_time
     CtTreeIter          _prevTreeIter;
@@ -29,6 +29,7 @@
 #include <regex>
 #include <glib/gstdio.h> // to get stats
 #include <fstream>
+#include <unordered_map>
 
 CtDocType CtMiscUtil::get_doc_type(const std::string& fileName)
 {
@@ -539,6 +540,49 @@ int CtStrUtil::natural_compare(const Glib::ustring& left, const Glib::ustring& r
     return 0;
 }
 
+std::string CtStrUtil::natural_sort_key(const Glib::ustring& text)
+{
+    // digits runs as 0x01 + number of digits + digits without leading zeros, so that digits sort first
+    // and longer numbers after shorter ones; other characters as 0x02 + collation key + 0x00
+    thread_local std::unordered_map<gunichar, std::string> charsKeys;
+    std::string key;
+    key.reserve(text.bytes() * 2);
+    auto it = text.begin();
+    while (it != text.end())
+    {
+        if (g_unichar_digit_value(*it) != -1)
+        {
+            std::string digits;
+            for (; it != text.end() && g_unichar_digit_value(*it) != -1; ++it)
+            {
+                const char digit = static_cast<char>('0' + g_unichar_digit_value(*it));
+                if (digits.empty() && '0' == digit) continue;
+                digits += digit;
+            }
+            const guint32 numDigits = static_cast<guint32>(digits.size());
+            key += '\x01';
+            for (int shift = 24; shift >= 0; shift -= 8)
+                key += static_cast<char>((numDigits >> shift) & 0xff);
+            key += digits;
+        }
+        else
+        {
+            auto itKey = charsKeys.find(*it);
+            if (itKey == charsKeys.end())
+            {
+                gchar* pCollateKey = g_utf8_collate_key(Glib::ustring(1, *it).c_str(), -1);
+                itKey = charsKeys.emplace(*it, pCollateKey).first;
+                g_free(pCollateKey);
+            }
+            key += '\x02';
+            key += itKey->second;
+            key += '\0';
+            ++it;
+        }
+    }
+    return key;
+}
+
 
 std::string CtFontUtil::get_font_family(const std::string& fontStr)
 {
@@ -711,6 +755,29 @@ std::string str::xml_escape(const std::string& text)
     return buffer;
 }
 
+std::string str::json_escape(const std::string& text)
+{
+    std::string buffer;
+    buffer.reserve(text.size());
+    for(size_t pos = 0; pos != text.size(); ++pos) {
+        switch(text[pos]) {
+            case '\"': buffer.append("\\\"");     break;
+            case '\\': buffer.append("\\\\");     break;
+            case '\n': buffer.append("\\n");      break;
+            case '\r': buffer.append("\\r");      break;
+            case '\t': buffer.append("\\t");      break;
+            case '<':  buffer.append("\\u003c"); break; // never closes a script element
+            default:
+                if (static_cast<unsigned char>(text[pos]) < 0x20)
+                    buffer.append(fmt::format("\\u{:04x}", static_cast<unsigned char>(text[pos])));
+                else
+                    buffer.append(&text[pos], 1);
+                break;
+        }
+    }
+    return buffer;
+}
+
 std::string str::re_escape(const std::string& text)
 {
     return Glib::Regex::escape_string(text);
@@ -865,3 +932,93 @@ Glib::ustring CtFileSystem::prepare_export_folder(Glib::ustring dir_place, Glib:
     return new_folder;
 }
 
+void CtCSV::read_rows(std::istream& inStream, const std::function<void(std::vector<Glib::ustring>& row)>& on_row)
+{
+    enum class State { FieldStart, Unquoted, Quoted, QuoteInQuoted, CarriageReturn };
+    State state{State::FieldStart};
+    std::string field;
+    std::vector<Glib::ustring> row;
+    auto end_field = [&]() {
+        row.push_back(field);
+        field.clear();
+    };
+    auto end_row = [&]() {
+        end_field();
+        if (row.size() > 1 or not row[0].empty())
+            on_row(row);
+        row.clear();
+    };
+    std::vector<char> chunk(64 * 1024);
+    while (inStream)
+    {
+        inStream.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const std::streamsize numRead = inStream.gcount();
+        for (std::streamsize i = 0; i < numRead; ++i)
+        {
+            const char c = chunk[static_cast<size_t>(i)];
+            if (State::CarriageReturn == state)
+            {
+                state = State::FieldStart;
+                if ('\n' == c) continue;
+            }
+            switch (state)
+            {
+                case State::Quoted:
+                    if ('"' == c) state = State::QuoteInQuoted;
+                    else field += c;
+                    break;
+                case State::QuoteInQuoted:
+                    if ('"' == c)
+                    {
+                        field += c;
+                        state = State::Quoted;
+                        break;
+                    }
+                    state = State::Unquoted; // the quoted part is over
+                    [[fallthrough]];
+                default:
+                    if (',' == c)
+                    {
+                        end_field();
+                        state = State::FieldStart;
+                    }
+                    else if ('\n' == c or '\r' == c)
+                    {
+                        end_row();
+                        state = '\r' == c ? State::CarriageReturn : State::FieldStart;
+                    }
+                    else if ('"' == c and State::FieldStart == state)
+                    {
+                        state = State::Quoted;
+                    }
+                    else
+                    {
+                        field += c;
+                        state = State::Unquoted;
+                    }
+            }
+        }
+    }
+    if (State::FieldStart != state or not row.empty())
+        end_row();
+}
+
+void CtCSV::write_field(std::ostream& outStream, const Glib::ustring& field)
+{
+    const std::string& raw = field.raw();
+    if (std::string::npos == raw.find_first_of(",\"\r\n"))
+    {
+        outStream << raw;
+        return;
+    }
+    outStream << '"';
+    size_t start{0};
+    for (size_t quotePos = raw.find('"'); std::string::npos != quotePos; quotePos = raw.find('"', start))
+    {
+        outStream.write(raw.data() + start, static_cast<std::streamsize>(quotePos + 1 - start));
+        outStream << '"';
+        start = quotePos + 1;
+    }
+    outStream.write(raw.data() + start, static_cast<std::streamsize>(raw.size() - start));
+    outStream << '"';
+}
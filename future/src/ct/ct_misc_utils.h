@@ -25,6 +25,8 @@
 #include <gtkmm/treeiter.h>
 #include <gtkmm/treestore.h>
 #include <unordered_set>
+#include <functional>
+#include <iostream>
 #include "ct_treestore.h"
 #include "ct_types.h"
 #include "src/fmt/fmt.h"
@@ -113,6 +115,10 @@ bool is_pgchar_in_pgchar_iterable(const gchar* pGcharNeedle, const IterableOfPgc
 // https://stackoverflow.com/questions/642213/how-to-implement-a-natural-sort-algorithm-in-c
 int natural_compare(const Glib::ustring& left, const Glib::ustring& right);
 
+// key such that comparing two keys bytewise gives the same order as natural_compare on their strings,
+// computed once per string when sorting many strings
+std::string natural_sort_key(const Glib::ustring& text);
+
 
 } // namespace CtStrUtil
 
@@ -156,6 +162,9 @@ int indexOf(const Glib::ustring& str, const gunichar& uc);
 
 std::string xml_escape(const std::string& text);
 
+// to go between the double quotes of a json/javascript string
+std::string json_escape(const std::string& text);
+
 std::string re_escape(const std::string& text);
 
 std::string time_format(const std::string& format, const gint64& time);
@@ -328,3 +337,13 @@ void external_folderpath_open(const std::string& folderpath);
 Glib::ustring prepare_export_folder(Glib::ustring dir_place, Glib::ustring new_folder, bool overwrite_existing);
 
 } // namespace CtFileSystem
+
+namespace CtCSV {
+
+// RFC 4180: fields separated by commas, quoted if containing commas, quotes or line ends, quotes doubled.
+// The input is read in chunks and every row is handed over as soon as it is complete, blank lines skipped
+void read_rows(std::istream& inStream, const std::function<void(std::vector<Glib::ustring>& row)>& on_row);
+
+void write_field(std::ostream& outStream, const Glib::ustring& field);
+
+} // namespace CtCSV
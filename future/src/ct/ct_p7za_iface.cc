@@ -22,6 +22,10 @@
 #include <glib/gstdio.h>
 #include <glibmm.h>
 #include "ct_p7za_iface.h"
+#include <iostream>
+#include "../7za/C/Alloc.h"
+#include "../7za/C/LzmaEnc.h"
+#include "../7za/C/LzmaDec.h"
 
 extern int p7za_exec(int numArgs, char *args[]);
 
@@ -65,3 +69,65 @@ int CtP7zaIface::p7za_archive(const gchar* input_path, const gchar* output_path,
     g_strfreev(pp_args);
     return ret_val;
 }
+
+static const size_t LZMA_HEADER_SIZE{8 + LZMA_PROPS_SIZE}; // original size (little endian) + encoder properties
+
+bool CtP7zaIface::lzma_compress(const std::string& input, std::string& output, const int level)
+{
+    CLzmaEncProps props;
+    LzmaEncProps_Init(&props);
+    props.level = level;
+    props.dictSize = 1 << 20;
+    props.numThreads = 1;
+    // room for a slightly expanded incompressible input
+    SizeT destLen = input.size() + input.size()/3 + 128;
+    output.resize(LZMA_HEADER_SIZE + destLen);
+    guint64 inputSize = input.size();
+    for (size_t i = 0; i < 8; ++i)
+    {
+        output[i] = static_cast<char>((inputSize >> (8*i)) & 0xff);
+    }
+    SizeT propsSize = LZMA_PROPS_SIZE;
+    const SRes res = LzmaEncode(reinterpret_cast<Byte*>(&output[LZMA_HEADER_SIZE]), &destLen,
+                                reinterpret_cast<const Byte*>(input.data()), input.size(),
+                                &props, reinterpret_cast<Byte*>(&output[8]), &propsSize,
+                                0/*writeEndMark*/, nullptr/*progress*/, &g_Alloc, &g_BigAlloc);
+    if (SZ_OK != res)
+    {
+        std::cerr << "!! lzma_compress " << res << std::endl;
+        output.clear();
+        return false;
+    }
+    output.resize(LZMA_HEADER_SIZE + destLen);
+    return true;
+}
+
+bool CtP7zaIface::lzma_decompress(const std::string& input, std::string& output)
+{
+    if (input.size() < LZMA_HEADER_SIZE)
+    {
+        std::cerr << "!! lzma_decompress header" << std::endl;
+        return false;
+    }
+    guint64 outputSize{0};
+    for (size_t i = 0; i < 8; ++i)
+    {
+        outputSize |= static_cast<guint64>(static_cast<guint8>(input[i])) << (8*i);
+    }
+    output.resize(outputSize);
+    if (0 == outputSize) return true;
+    SizeT destLen = outputSize;
+    SizeT srcLen = input.size() - LZMA_HEADER_SIZE;
+    ELzmaStatus status;
+    const SRes res = LzmaDecode(reinterpret_cast<Byte*>(&output[0]), &destLen,
+                                reinterpret_cast<const Byte*>(&input[LZMA_HEADER_SIZE]), &srcLen,
+                                reinterpret_cast<const Byte*>(&input[8]), LZMA_PROPS_SIZE,
+                                LZMA_FINISH_END, &status, &g_Alloc);
+    if (SZ_OK != res or destLen != outputSize)
+    {
+        std::cerr << "!! lzma_decompress " << res << std::endl;
+        output.clear();
+        return false;
+    }
+    return true;
+}
@@ -22,6 +22,7 @@
 #pragma once
 #include <glib.h>
 #include <glib/gtypes.h>
+#include <string>
 
 namespace CtP7zaIface {
 
@@ -29,5 +30,10 @@ int p7za_extract(const gchar* input_path, const gchar* out_dir, const gchar* pas
 
 int p7za_archive(const gchar* input_path, const gchar* output_path, const gchar* passwd, const bool dbg_print_cmd=false);
 
+// in memory LZMA, the output starts with the original size and the encoder properties
+bool lzma_compress(const std::string& input, std::string& output, const int level=1);
+
+bool lzma_decompress(const std::string& input, std::string& output);
+
 } // namespace CtP7zaIface
 
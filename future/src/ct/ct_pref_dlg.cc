@@ -411,6 +411,14 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     spinbutton_limit_undoable_steps->set_value(pConfig->limitUndoableSteps);
     hbox_misc_text->pack_start(*label_limit_undoable_steps, false, false);
     hbox_misc_text->pack_start(*spinbutton_limit_undoable_steps, false, false);
+    Gtk::HBox* hbox_undo_memory = Gtk::manage(new Gtk::HBox());
+    hbox_undo_memory->set_spacing(4);
+    Gtk::Label* label_limit_undo_memory = Gtk::manage(new Gtk::Label(_("Limit of Undo Memory for All Nodes (MB)")));
+    Glib::RefPtr<Gtk::Adjustment> adj_limit_undo_memory = Gtk::Adjustment::create(pConfig->limitUndoMemoryMb, 1, 100000, 1);
+    Gtk::SpinButton* spinbutton_limit_undo_memory = Gtk::manage(new Gtk::SpinButton(adj_limit_undo_memory));
+    spinbutton_limit_undo_memory->set_value(pConfig->limitUndoMemoryMb);
+    hbox_undo_memory->pack_start(*label_limit_undo_memory, false, false);
+    hbox_undo_memory->pack_start(*spinbutton_limit_undo_memory, false, false);
 
     Gtk::VBox* vbox_misc_text = Gtk::manage(new Gtk::VBox());
     vbox_misc_text->pack_start(*checkbutton_rt_show_white_spaces, false, false);
@@ -419,6 +427,7 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     vbox_misc_text->pack_start(*hbox_embfile_size, false, false);
     vbox_misc_text->pack_start(*checkbutton_embfile_show_filename, false, false);
     vbox_misc_text->pack_start(*hbox_misc_text, false, false);
+    vbox_misc_text->pack_start(*hbox_undo_memory, false, false);
     Gtk::Frame* frame_misc_text = Gtk::manage(new Gtk::Frame(std::string("<b>")+_("Miscellaneous")+"</b>"));
     ((Gtk::Label*)frame_misc_text->get_label_widget())->set_use_markup(true);
     frame_misc_text->set_shadow_type(Gtk::SHADOW_NONE);
@@ -516,6 +525,9 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     spinbutton_limit_undoable_steps->signal_value_changed().connect([pConfig, spinbutton_limit_undoable_steps](){
         pConfig->limitUndoableSteps = spinbutton_limit_undoable_steps->get_value_as_int();
     });
+    spinbutton_limit_undo_memory->signal_value_changed().connect([pConfig, spinbutton_limit_undo_memory](){
+        pConfig->limitUndoMemoryMb = spinbutton_limit_undo_memory->get_value_as_int();
+    });
 
     return pMainBox;
 }
@@ -585,6 +597,16 @@ Gtk::Widget* CtPrefDlg::build_tab_plain_text_n_code()
     button_reset_term->set_tooltip_text(_("Reset to Default"));
     hbox_term_run->pack_start(*entry_term_run, true, false);
     hbox_term_run->pack_start(*button_reset_term, false, false);
+    Gtk::CheckButton* checkbutton_in_terminal = Gtk::manage(new Gtk::CheckButton(_("Run in the Terminal instead of the Output Window")));
+    checkbutton_in_terminal->set_active(pConfig->codexecInTerminal);
+    Gtk::HBox* hbox_timeout = Gtk::manage(new Gtk::HBox());
+    hbox_timeout->set_spacing(4);
+    Gtk::Label* label_timeout = Gtk::manage(new Gtk::Label(_("Timeout in Seconds (0 for None)")));
+    Glib::RefPtr<Gtk::Adjustment> adj_timeout = Gtk::Adjustment::create(pConfig->codexecTimeoutSecs, 0, 86400, 1);
+    Gtk::SpinButton* spinbutton_timeout = Gtk::manage(new Gtk::SpinButton(adj_timeout));
+    spinbutton_timeout->set_value(pConfig->codexecTimeoutSecs);
+    hbox_timeout->pack_start(*label_timeout, false, false);
+    hbox_timeout->pack_start(*spinbutton_timeout, false, false);
     Gtk::HBox* hbox_cmd_per_type = Gtk::manage(new Gtk::HBox());
     hbox_cmd_per_type->pack_start(*scrolledwindow, true, true);
     hbox_cmd_per_type->pack_start(*vbox_buttons, false, false);
@@ -597,6 +619,8 @@ Gtk::Widget* CtPrefDlg::build_tab_plain_text_n_code()
     label2->set_use_markup(true);
     vbox_codexec->pack_start(*label2, false, false);
     vbox_codexec->pack_start(*hbox_term_run, false, false);
+    vbox_codexec->pack_start(*checkbutton_in_terminal, false, false);
+    vbox_codexec->pack_start(*hbox_timeout, false, false);
 
     Gtk::Frame* frame_codexec = Gtk::manage(new Gtk::Frame(std::string("<b>")+_("Code Execution")+"</b>"));
     ((Gtk::Label*)frame_codexec->get_label_widget())->set_use_markup(true);
@@ -636,6 +660,12 @@ Gtk::Widget* CtPrefDlg::build_tab_plain_text_n_code()
     entry_term_run->signal_changed().connect([pConfig, entry_term_run](){
         pConfig->customCodexecTerm = entry_term_run->get_text();
     });
+    checkbutton_in_terminal->signal_toggled().connect([pConfig, checkbutton_in_terminal](){
+        pConfig->codexecInTerminal = checkbutton_in_terminal->get_active();
+    });
+    spinbutton_timeout->signal_value_changed().connect([pConfig, spinbutton_timeout](){
+        pConfig->codexecTimeoutSecs = spinbutton_timeout->get_value_as_int();
+    });
     button_add->signal_clicked().connect([this, liststore](){
         add_new_command_in_model(liststore);
     });
@@ -52,7 +52,7 @@ void CtPrint::print_text(CtMainWin* pCtMainWin, const Glib::ustring& pdf_filepat
     for (auto& widget: widgets)
     {
         if (CtImage* image = dynamic_cast<CtImage*>(widget))            _widgets.push_back(std::shared_ptr<CtPrintImageProxy>(new CtPrintImageProxy(image)));
-        else if (CtTable* table = dynamic_cast<CtTable*>(widget))       _widgets.push_back(std::shared_ptr<CtPrintTableProxy>(new CtPrintTableProxy(table, 1, table->get_table_matrix().size())));
+        else if (CtTable* table = dynamic_cast<CtTable*>(widget))       _widgets.push_back(std::shared_ptr<CtPrintTableProxy>(new CtPrintTableProxy(table, 1, table->get_num_rows())));
         else if (CtCodebox* codebox = dynamic_cast<CtCodebox*>(widget)) _widgets.push_back(std::shared_ptr<CtPrintCodeboxProxy>(new CtPrintCodeboxProxy(codebox)));
         else                                                            _widgets.push_back(std::shared_ptr<CtPrintSomeProxy>(new CtPrintSomeProxy(widget)));
     }
@@ -70,20 +70,25 @@ void CtPrint::print_text(CtMainWin* pCtMainWin, const Glib::ustring& pdf_filepat
     print_data.operation->signal_begin_print().connect(sigc::bind(fun_begin_print_text, &print_data));
     print_data.operation->signal_draw_page().connect(sigc::bind(fun_draw_page_text, &print_data));
     print_data.operation->set_export_filename(pdf_filepath);
+    // without a window, as printing to pdf in the unit tests, the errors go to the console
+    auto on_error = [pCtMainWin](const Glib::ustring& message) {
+        if (pCtMainWin) CtDialogs::error_dialog(message, *pCtMainWin);
+        else std::cerr << "!! " << message << std::endl;
+    };
     try
     {
         auto res = print_data.operation->run(pdf_filepath != "" ? Gtk::PRINT_OPERATION_ACTION_EXPORT : Gtk::PRINT_OPERATION_ACTION_PRINT_DIALOG);
         if (res == Gtk::PRINT_OPERATION_RESULT_ERROR)
-            CtDialogs::error_dialog("Error printing file: (bad res)", *pCtMainWin);
+            on_error("Error printing file: (bad res)");
         else if (res == Gtk::PRINT_OPERATION_RESULT_APPLY)
             _pPrintSettings = print_data.operation->get_print_settings();
     }
     catch (Glib::Error& ex)
     {
-        CtDialogs::error_dialog("Error printing file:\n" + ex.what() + " (exception caught)", *pCtMainWin);
+        on_error("Error printing file:\n" + ex.what() + " (exception caught)");
     }
-    if (print_data.warning != "")
-        _pCtMainWin->get_status_bar().update_status(print_data.warning);
+    if (print_data.warning != "" && pCtMainWin)
+        pCtMainWin->get_status_bar().update_status(print_data.warning);
 
     // remove proxy widgets
     _widgets.clear();
@@ -95,130 +100,90 @@ void CtPrint::_on_begin_print_text(const Glib::RefPtr<Gtk::PrintContext>& contex
 {
     _page_width = context->get_width();
     _page_height = context->get_height() * 1.02; // tolerance at bottom of the page
-    bool any_image_resized = false;
     auto layout_newline = context->create_pango_layout();
     layout_newline->set_font_description(_pango_font);
     layout_newline->set_width(int(_page_width * Pango::SCALE));
     layout_newline->set_markup(CtConst::CHAR_NEWLINE);
     _layout_newline_height = _layout_line_get_width_height(layout_newline->get_line(0)).height;
-    int codebox_height = 0, table_height = 0; // to keep data for current slot from previous slot
 
-    while (1)
+    // every widget is laid out once and the ones taller than the page are split into pieces that fit
+    _prepare_widgets(context, print_data);
+
+    print_data->layout.clear();
+    print_data->forced_page_break.clear();
+    print_data->layout_is_new_line.clear();
+    print_data->layout_lines.clear();
+    print_data->all_lines_y.clear();
+    for (Glib::ustring& text_slot: print_data->text)
     {
-        print_data->layout.clear();
-        print_data->forced_page_break.clear();
-        print_data->layout_is_new_line.clear();
-        print_data->layout_num_lines.clear();
-        print_data->all_lines_y.clear();
-
-        bool exit_ok = true;
-        for (Glib::ustring& text_slot: print_data->text)
-        {
-            bool is_forced_page_break = str::startswith(text_slot, CtConst::CHAR_NEWPAGE + CtConst::CHAR_NEWPAGE);
-            print_data->forced_page_break.push_back(is_forced_page_break);
-            // in other cases we detect the newline from a following line
-            // but here we have a single layout line
-            print_data->layout_is_new_line.push_back(text_slot == CtConst::CHAR_NEWLINE);
+        bool is_forced_page_break = str::startswith(text_slot, CtConst::CHAR_NEWPAGE + CtConst::CHAR_NEWPAGE);
+        print_data->forced_page_break.push_back(is_forced_page_break);
+        // in other cases we detect the newline from a following line
+        // but here we have a single layout line
+        print_data->layout_is_new_line.push_back(text_slot == CtConst::CHAR_NEWLINE);
+
+        auto layout = context->create_pango_layout();
+        print_data->layout.push_back(layout);
+        layout->set_font_description(_pango_font);
+        layout->set_width(int(_page_width * Pango::SCALE));
+        layout->set_markup(is_forced_page_break ? text_slot.substr(2) : text_slot);
+        print_data->layout_lines.push_back(layout->get_lines_readonly());
+    }
 
-            auto layout = context->create_pango_layout();
-            print_data->layout.push_back(layout);
-            layout->set_font_description(_pango_font);
-            layout->set_width(int(_page_width * Pango::SCALE));
-            layout->set_markup(is_forced_page_break ? text_slot.substr(2) : text_slot);
-            print_data->layout_num_lines.push_back(layout->get_line_count());
+    print_data->page_breaks.clear();
+    _y_idx = 0;
+    double curr_y = 0;
+    double inline_pending_height = 0;
+    auto inline_starter = std::make_pair(0, 0);
+    for (size_t i = 0; i < print_data->layout.size(); ++i)
+    {
+        const CtPrintLayoutLines& layout_lines = print_data->layout_lines[i];
+        if (print_data->forced_page_break[i] && curr_y > 0)
+        {
+            print_data->page_breaks.push_back(inline_starter);
+            curr_y = 0;
         }
-
-        print_data->page_breaks.clear();
-        _y_idx = 0;
-        double curr_y = 0;
-        double inline_pending_height = 0;
-        auto inline_starter = std::make_pair(0, 0);
-        for (size_t i = 0; i < print_data->layout.size(); ++i)
+        const int num_lines = (int)layout_lines.size();
+        for (int layout_line_idx = 0; layout_line_idx < num_lines; ++layout_line_idx)
         {
-            auto layout = print_data->layout[i];
-            if (print_data->forced_page_break[i] && curr_y > 0)
-            {
-                print_data->page_breaks.push_back(inline_starter);
-                curr_y = 0;
-            }
-            int layout_line_idx = 0;
-            while (layout_line_idx < print_data->layout_num_lines[i])
+            auto line_height = _layout_line_get_width_height(layout_lines[layout_line_idx]).height;
+            // process the line
+            if (line_height > inline_pending_height) inline_pending_height = line_height;
+            if (layout_line_idx < num_lines - 1 || print_data->layout_is_new_line[i])
             {
-                auto layout_line = layout->get_line(layout_line_idx);
-                auto line_height = _layout_line_get_width_height(layout_line).height;
-                // process the line
-                if (line_height > inline_pending_height) inline_pending_height = line_height;
-                if (layout_line_idx < print_data->layout_num_lines[i] - 1 || print_data->layout_is_new_line[i])
+                if (curr_y + inline_pending_height > _page_height)
                 {
-                    if (curr_y + inline_pending_height > _page_height)
-                    {
-                        print_data->page_breaks.push_back(inline_starter);
-                        curr_y = 0;
-                        if (inline_pending_height > _page_height)
-                        {
-                            CtPrintCodeboxProxy* codebox = dynamic_cast<CtPrintCodeboxProxy*>(_widgets[i-1].get());
-                            CtPrintTableProxy* table = dynamic_cast<CtPrintTableProxy*>(_widgets[i-1].get());
-                            if (codebox && codebox_height > _page_height)
-                            {
-                                _codebox_long_split(i-1, context, print_data);
-                                exit_ok = false;
-                                break; // go to a new main loop
-                            }
-                            else if (table && table_height > _page_height)
-                            {
-                                _table_long_split(i-1, context, print_data);
-                                exit_ok = false;
-                                break; // go to a new main loop
-                            }
-                        }
-                    }
-                    curr_y += inline_pending_height;
-                    print_data->all_lines_y.push_back(curr_y);
-                    inline_pending_height = 0; // reset the pending elements line to append
-                    inline_starter = std::make_pair(i, layout_line_idx+1);
+                    print_data->page_breaks.push_back(inline_starter);
+                    curr_y = 0;
                 }
-                layout_line_idx += 1;
+                curr_y += inline_pending_height;
+                print_data->all_lines_y.push_back(curr_y);
+                inline_pending_height = 0; // reset the pending elements line to append
+                inline_starter = std::make_pair(i, layout_line_idx+1);
+            }
+        }
+        // pixbuf or table or codebox
+        if (i < print_data->layout.size() - 1) // the latest element is supposed to be text
+        {
+            double widget_height = 0;
+            if (CtPrintImageProxy* imageProxy = dynamic_cast<CtPrintImageProxy*>(_widgets[i].get()))
+            {
+                widget_height = imageProxy->get_height();
             }
-            if (!exit_ok)
-                break; // go to a new main loop
-            // pixbuf or table or codebox
-            if (i < print_data->layout.size() - 1) // the latest element is supposed to be text
+            else if (CtPrintTableProxy* tableProxy = dynamic_cast<CtPrintTableProxy*>(_widgets[i].get()))
             {
-                if (CtPrintImageProxy* imageProxy = dynamic_cast<CtPrintImageProxy*>(_widgets[i].get()))
-                {
-                    auto pixbuf = imageProxy->get_pixbuf();
-                    // don't know curr_x, so will recalc scale again in draw function
-                    double scale_w = _page_width / pixbuf->get_width();
-                    double scale_h = (_page_height - _layout_newline_height - CtConst::WHITE_SPACE_BETW_PIXB_AND_TEXT)/pixbuf->get_height();
-                    double scale = std::min(scale_w, scale_h);
-                    if (scale > 1.0) scale = 1.0;
-                    double pixbuf_height = pixbuf->get_height() * scale + CtConst::WHITE_SPACE_BETW_PIXB_AND_TEXT;
-
-                    if (inline_pending_height < pixbuf_height)
-                        inline_pending_height = pixbuf_height;
-                }
-                else if (CtPrintTableProxy* tableProxy = dynamic_cast<CtPrintTableProxy*>(_widgets[i].get()))
-                {
-                    auto table_layouts = _get_table_layouts(context, tableProxy);
-                    auto table_grid = _get_table_grid(table_layouts, tableProxy->get_table()->get_col_min());
-                    double table_height = _get_table_height_from_grid(table_grid);
-                    if (inline_pending_height < table_height + BOX_OFFSET)
-                        inline_pending_height = table_height + BOX_OFFSET;
-                }
-                else if (CtPrintCodeboxProxy* codeboxProxy = dynamic_cast<CtPrintCodeboxProxy*>(_widgets[i].get()))
-                {
-                    auto codebox_layout = _get_codebox_layout(context, codeboxProxy);
-                    double codebox_height = _get_height_from_layout(codebox_layout);
-                    if (inline_pending_height < codebox_height + BOX_OFFSET)
-                        inline_pending_height = codebox_height + BOX_OFFSET;
-                }
+                widget_height = _get_table_height_from_grid(tableProxy->get_grid()) + BOX_OFFSET;
             }
+            else if (CtPrintCodeboxProxy* codeboxProxy = dynamic_cast<CtPrintCodeboxProxy*>(_widgets[i].get()))
+            {
+                widget_height = _get_height_from_lines(codeboxProxy->get_lines(), codeboxProxy->get_first_line(), codeboxProxy->get_end_line()) + BOX_OFFSET;
+            }
+            if (inline_pending_height < widget_height)
+                inline_pending_height = widget_height;
         }
-        if (exit_ok)
-            break;
     }
     print_data->operation->set_n_pages((int)print_data->page_breaks.size() + 1);
-    if (any_image_resized)
+    if (print_data->any_image_resized)
     {
         print_data->warning = Glib::ustring(_("Warning: One or More Images Were Reduced to Enter the Page")) + " ("
                                        + std::to_string(int(_page_width))+ "x" + std::to_string(int(_page_height)) + ")";
@@ -230,7 +195,7 @@ void CtPrint::_on_draw_page_text(const Glib::RefPtr<Gtk::PrintContext>& context,
 {
     // layout num, line num
     std::pair<int, int> start_line_num = page_nr == 0 ? std::make_pair(0, 0) : print_data->page_breaks[page_nr - 1];
-    std::pair<int, int> end_line_num = page_nr < (int)print_data->page_breaks.size() ? print_data->page_breaks[page_nr] : std::make_pair((int)print_data->layout.size()-1, print_data->layout_num_lines.back());
+    std::pair<int, int> end_line_num = page_nr < (int)print_data->page_breaks.size() ? print_data->page_breaks[page_nr] : std::make_pair((int)print_data->layout.size()-1, (int)print_data->layout_lines.back().size());
     auto operation = print_data->operation;
     auto cairo_context = context->get_cairo_context();
     cairo_context->set_source_rgb(0.5, 0.5, 0.5);
@@ -248,9 +213,11 @@ void CtPrint::_on_draw_page_text(const Glib::RefPtr<Gtk::PrintContext>& context,
         cairo_context->set_source_rgb(0, 0, 0);
         if (i > start_line_num.first)
             layout_line_idx = 0; //reset line idx
-        while (layout_line_idx < print_data->layout_num_lines[i])
+        const CtPrintLayoutLines& layout_lines = print_data->layout_lines[i];
+        const int num_lines = (int)layout_lines.size();
+        while (layout_line_idx < num_lines)
         {
-            auto layout_line = print_data->layout[i]->get_line(layout_line_idx);
+            auto layout_line = layout_lines[layout_line_idx];
             double line_width = _layout_line_get_width_height(layout_line).width;
             // process the line
             if (line_width > 0)
@@ -259,7 +226,7 @@ void CtPrint::_on_draw_page_text(const Glib::RefPtr<Gtk::PrintContext>& context,
                 layout_line->show_in_cairo_context(cairo_context);
                 curr_x += line_width;
             }
-            if (layout_line_idx < print_data->layout_num_lines[i]-1 || print_data->layout_is_new_line[i])
+            if (layout_line_idx < num_lines - 1 || print_data->layout_is_new_line[i])
             {
                 curr_x = 0.0;
                 _y_idx += 1;
@@ -292,8 +259,8 @@ void CtPrint::_on_draw_page_text(const Glib::RefPtr<Gtk::PrintContext>& context,
             }
             else if (CtPrintTableProxy* tableProxy = dynamic_cast<CtPrintTableProxy*>(_widgets[i].get()))
             {
-                auto table_layouts = _get_table_layouts(context, tableProxy);
-                auto table_grid = _get_table_grid(table_layouts, tableProxy->get_table()->get_col_min());
+                const auto& table_layouts = tableProxy->get_layouts();
+                const auto& table_grid = tableProxy->get_grid();
                 double table_width = _get_table_width_from_grid(table_grid);
                 double table_height = _get_table_height_from_grid(table_grid);
                 _table_draw_grid(cairo_context, table_grid, curr_x,
@@ -305,13 +272,15 @@ void CtPrint::_on_draw_page_text(const Glib::RefPtr<Gtk::PrintContext>& context,
             }
             else if (CtPrintCodeboxProxy* codeboxProxy = dynamic_cast<CtPrintCodeboxProxy*>(_widgets[i].get()))
             {
-                auto codebox_layout = _get_codebox_layout(context, codeboxProxy);
-                double codebox_height = _get_height_from_layout(codebox_layout);
-                double codebox_width = _get_width_from_layout(codebox_layout);
+                const CtPrintLayoutLines& codebox_lines = codeboxProxy->get_lines();
+                const int first_line = codeboxProxy->get_first_line();
+                const int end_line = codeboxProxy->get_end_line();
+                double codebox_height = _get_height_from_lines(codebox_lines, first_line, end_line);
+                double codebox_width = _get_width_from_lines(codebox_lines, first_line, end_line);
                 _codebox_draw_box(cairo_context, curr_x,
                                   print_data->all_lines_y[_y_idx] - codebox_height,
                                   codebox_width, codebox_height);
-                _codebox_draw_code(cairo_context, codebox_layout, curr_x,
+                _codebox_draw_code(cairo_context, codeboxProxy, curr_x,
                                    print_data->all_lines_y[_y_idx] - codebox_height);
                 curr_x += codebox_width;
             }
@@ -331,28 +300,28 @@ Cairo::Rectangle CtPrint::_layout_line_get_width_height(Glib::RefPtr<const Pango
     return rect;
 }
 
-// Returns the Height given the Layout
-double CtPrint::_get_height_from_layout(Glib::RefPtr<Pango::Layout> layout)
+// Returns the Height given the Lines of a Layout, or the range [first_line, end_line)
+double CtPrint::_get_height_from_lines(const CtPrintLayoutLines& lines, int first_line, int end_line)
 {
+    if (end_line < 0) end_line = (int)lines.size();
     double height = 0;
-    for (int layout_line_idx = 0; layout_line_idx < layout->get_line_count(); ++layout_line_idx)
+    for (int layout_line_idx = first_line; layout_line_idx < end_line; ++layout_line_idx)
     {
-        Glib::RefPtr<const Pango::LayoutLine> layout_line = layout->get_line(layout_line_idx);
-        double line_height = _layout_line_get_width_height(layout_line).height;
+        double line_height = _layout_line_get_width_height(lines[layout_line_idx]).height;
         height += line_height;
     }
 
     return height + 2 * CtConst::GRID_SLIP_OFFSET;
 }
 
-// Returns the Height given the Layout
-double CtPrint::_get_width_from_layout(Glib::RefPtr<Pango::Layout> layout)
+// Returns the Width given the Lines of a Layout, or the range [first_line, end_line)
+double CtPrint::_get_width_from_lines(const CtPrintLayoutLines& lines, int first_line, int end_line)
 {
+    if (end_line < 0) end_line = (int)lines.size();
     double width = 0;
-    for (int layout_line_idx = 0; layout_line_idx < layout->get_line_count(); ++layout_line_idx)
+    for (int layout_line_idx = first_line; layout_line_idx < end_line; ++layout_line_idx)
     {
-        Glib::RefPtr<const Pango::LayoutLine> layout_line = layout->get_line(layout_line_idx);
-        double line_width = _layout_line_get_width_height(layout_line).width;
+        double line_width = _layout_line_get_width_height(lines[layout_line_idx]).width;
         if (line_width > width)
             width = line_width;
     }
@@ -374,9 +343,9 @@ Glib::RefPtr<Pango::Layout> CtPrint::_get_codebox_layout(const Glib::RefPtr<Gtk:
 }
 
 // Return the Table Cells Layouts
-std::vector<std::vector<Glib::RefPtr<Pango::Layout>>> CtPrint::_get_table_layouts(const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintTableProxy* tableProxy)
+CtPrintTableLayouts CtPrint::_get_table_layouts(const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintTableProxy* tableProxy)
 {
-    std::vector<std::vector<Glib::RefPtr<Pango::Layout>>> table_layouts;
+    CtPrintTableLayouts table_layouts;
     for (int i = 0; i < tableProxy->get_row_num(); ++i)
     {
         std::vector<Glib::RefPtr<Pango::Layout>> layouts;
@@ -397,20 +366,19 @@ std::vector<std::vector<Glib::RefPtr<Pango::Layout>>> CtPrint::_get_table_layout
 }
 
 // Returns the Dimensions of Rows and Columns
-std::pair<std::vector<double>, std::vector<double>> CtPrint::_get_table_grid(std::vector<std::vector<Glib::RefPtr<Pango::Layout>>>& table_layouts, int col_min)
+CtPrintTableGrid CtPrint::_get_table_grid(const CtPrintTableLayouts& table_layouts, int col_min)
 {
     std::vector<double> rows_h(table_layouts.size(), 0);
     std::vector<double> cols_w(table_layouts[0].size(), col_min);
     for (size_t i = 0; i < table_layouts.size(); ++i)
     {
-        auto layout_row = table_layouts[i];
+        const auto& layout_row = table_layouts[i];
         for (size_t j = 0; j < layout_row.size(); ++j)
         {
-            auto layout_cell = layout_row[j];
+            const auto& layout_cell = layout_row[j];
             double cell_height = 0;
-            for (int layout_line_idx = 0; layout_line_idx < layout_cell->get_line_count(); ++ layout_line_idx)
+            for (const auto& layout_line : layout_cell->get_lines_readonly())
             {
-                auto layout_line = layout_cell->get_line(layout_line_idx);
                 auto line_size = _layout_line_get_width_height(layout_line);
                 cell_height += line_size.height;
                 if (cols_w[j] < line_size.width) cols_w[j] = line_size.width;
@@ -422,7 +390,7 @@ std::pair<std::vector<double>, std::vector<double>> CtPrint::_get_table_grid(std
 }
 
 // Returns the Table Width given the table_grid vector
-double CtPrint::_get_table_width_from_grid(std::pair<std::vector<double>, std::vector<double>>& table_grid)
+double CtPrint::_get_table_width_from_grid(const CtPrintTableGrid& table_grid)
 {
     double table_width = 0;
     for (auto& col_w: table_grid.second)
@@ -431,7 +399,7 @@ double CtPrint::_get_table_width_from_grid(std::pair<std::vector<double>, std::v
 }
 
 // Returns the Table Height given the table_grid vector
-double CtPrint::_get_table_height_from_grid(std::pair<std::vector<double>, std::vector<double>>& table_grid)
+double CtPrint::_get_table_height_from_grid(const CtPrintTableGrid& table_grid)
 {
     double table_height = 0;
     for (auto& row_h: table_grid.first)
@@ -439,103 +407,128 @@ double CtPrint::_get_table_height_from_grid(std::pair<std::vector<double>, std::
     return table_height;
 }
 
-// Split Long Tables
-void CtPrint::_table_long_split(size_t idx, const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data)
+// Lay Out the Widgets and Split the Ones Taller than the Page
+void CtPrint::_prepare_widgets(const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data)
 {
-    CtPrintTableProxy* tableProxy = dynamic_cast<CtPrintTableProxy*>(_widgets[(size_t)idx].get());
-    std::vector<std::shared_ptr<CtPrintTableProxy>> new_tables;
-    std::shared_ptr<CtPrintTableProxy> new_table;
-    for (int row_num = 1 /*header row*/ + 1 /*next row*/; row_num < tableProxy->get_row_num(); ++row_num)
+    for (size_t idx = 0; idx < _widgets.size(); )
     {
-        new_table = tableProxy->create_new_with(row_num);
-        auto table_layouts = _get_table_layouts(context, new_table.get());
-        auto table_grid = _get_table_grid(table_layouts, new_table->get_table()->get_col_min());
-        double table_height = _get_table_height_from_grid(table_grid);
-        if (table_height + BOX_OFFSET > (_page_height - _layout_newline_height)) // hit upper limit
+        if (CtPrintImageProxy* imageProxy = dynamic_cast<CtPrintImageProxy*>(_widgets[idx].get()))
         {
-            // this slot is done
-            new_table = tableProxy->create_new_with(row_num - 1); // todo: hmm, what if it will be just header?
-            new_tables.push_back(new_table);
-            new_table.reset();
-            // start cycle again with reduced tabled
-            tableProxy->remove_first_rows(row_num - 1 - 1 /* skip header */);
-            row_num = 1; // will be incremented to 2
+            auto pixbuf = imageProxy->get_pixbuf();
+            // don't know curr_x, so will recalc scale again in draw function
+            double scale_w = _page_width / pixbuf->get_width();
+            double scale_h = (_page_height - _layout_newline_height - CtConst::WHITE_SPACE_BETW_PIXB_AND_TEXT)/pixbuf->get_height();
+            double scale = std::min(scale_w, scale_h);
+            if (scale < 1.0) print_data->any_image_resized = true;
+            else scale = 1.0;
+            imageProxy->set_height(pixbuf->get_height() * scale + CtConst::WHITE_SPACE_BETW_PIXB_AND_TEXT);
+            idx += 1;
+        }
+        else if (dynamic_cast<CtPrintTableProxy*>(_widgets[idx].get()))
+        {
+            idx += _table_layout_split(idx, context, print_data);
+        }
+        else if (dynamic_cast<CtPrintCodeboxProxy*>(_widgets[idx].get()))
+        {
+            idx += _codebox_layout_split(idx, context, print_data);
         }
-    }
-    if (new_table && new_table->get_row_num() > 1)
-        new_tables.push_back(new_table);
-
-    for (size_t i = 0; i < new_tables.size(); ++i)
-    {
-        if (i == 0)
-            *tableProxy = *new_tables[i];
         else
         {
-            //  add a newline
-            print_data->text.insert(print_data->text.begin() + idx + i, CtConst::CHAR_NEWLINE);
-            // add a table
-            _widgets.insert(_widgets.begin() + idx + i, new_tables[i]);
+            idx += 1;
         }
     }
 }
 
-// Split Long CodeBoxes
-void CtPrint::_codebox_long_split(size_t idx, const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data)
+// Lay Out a Table Once and Split it by Rows in Pieces that Fit the Page, Returns the Number of Pieces
+size_t CtPrint::_table_layout_split(size_t idx, const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data)
 {
-    CtPrintCodeboxProxy* codeboxProxy = dynamic_cast<CtPrintCodeboxProxy*>(_widgets[(size_t)idx].get());
-    std::vector<Glib::ustring> original_splitted_pango = str::split(codeboxProxy->get_text_content(), CtConst::CHAR_NEWLINE.c_str());
-    // fix for not-closed span, I suppose
-    for (size_t i = 0; i < original_splitted_pango.size(); ++i)
+    CtPrintTableProxy* tableProxy = dynamic_cast<CtPrintTableProxy*>(_widgets[idx].get());
+    CtPrintTableLayouts table_layouts = _get_table_layouts(context, tableProxy);
+    CtPrintTableGrid table_grid = _get_table_grid(table_layouts, tableProxy->get_table()->get_col_min());
+    const int row_num = (int)table_grid.first.size();
+    const double max_height = _page_height - _layout_newline_height;
+    auto row_height = [&](int row) { return table_grid.first[row] + _table_line_thickness; };
+    if (row_num <= 2 || _get_table_height_from_grid(table_grid) + BOX_OFFSET <= max_height)
     {
-        auto& element = original_splitted_pango[i];
-        auto last_close = element.rfind("</span");
-        auto last_open = element.rfind("<span");
-        if (last_close < last_open)
-        {
-            auto non_closed_span = element.substr(last_open);
-            auto end_non_closed_span_idx = non_closed_span.find(">");
-            non_closed_span = non_closed_span.substr(0, end_non_closed_span_idx+1);
-            original_splitted_pango[i] += "</span>";
-            original_splitted_pango[i+1] = non_closed_span + original_splitted_pango[i+1];
-        }
+        tableProxy->set_layouts(std::move(table_layouts), std::move(table_grid));
+        return 1;
     }
 
-    std::vector<Glib::ustring> result_pango;
-    std::vector<Glib::ustring> splitted_pango;
-    Glib::ustring partial_pango = "";
-    Glib::ustring partial_pango_prev = "";
-    while (splitted_pango.size() < original_splitted_pango.size())
+    // every piece repeats the header row and has at least one row, the columns keep the width of the whole table
+    std::vector<std::shared_ptr<CtPrintWidgetProxy>> pieces;
+    const double header_height = row_height(0);
+    for (int first_row = 1; first_row < row_num; )
     {
-        splitted_pango.push_back(original_splitted_pango[splitted_pango.size()]);
-        if (partial_pango != "")
-            partial_pango_prev = partial_pango;
-        partial_pango = str::join(splitted_pango, CtConst::CHAR_NEWLINE);
-        CtPrintCodeboxProxy temp_proxy(codeboxProxy->get_codebox(), partial_pango);
-        auto codebox_layout = _get_codebox_layout(context, &temp_proxy);
-        double codebox_height = _get_height_from_layout(codebox_layout);
-        if (codebox_height + BOX_OFFSET > (_page_height - _layout_newline_height))
+        double piece_height = header_height + row_height(first_row);
+        int end_row = first_row + 1;
+        while (end_row < row_num && piece_height + row_height(end_row) + BOX_OFFSET <= max_height)
+        {
+            piece_height += row_height(end_row);
+            end_row += 1;
+        }
+        CtPrintTableLayouts piece_layouts{table_layouts[0]};
+        CtPrintTableGrid piece_grid{{table_grid.first[0]}, table_grid.second};
+        for (int row = first_row; row < end_row; ++row)
         {
-            // this slot is done
-            result_pango.push_back(partial_pango_prev);
-            original_splitted_pango.erase(original_splitted_pango.begin(), original_splitted_pango.begin() + (splitted_pango.size() - 1)); // todo: not sure, need to test it
-            splitted_pango.clear();
+            piece_layouts.push_back(table_layouts[row]);
+            piece_grid.first.push_back(table_grid.first[row]);
         }
+        auto piece = std::make_shared<CtPrintTableProxy>(tableProxy->get_table(), tableProxy->get_start_row() + first_row - 1, 1 + end_row - first_row);
+        piece->set_layouts(std::move(piece_layouts), std::move(piece_grid));
+        pieces.push_back(piece);
+        first_row = end_row;
     }
-    // this is the last piece
-    result_pango.push_back(partial_pango);
-    for (size_t i = 0; i < result_pango.size(); ++i)
+    _insert_widget_pieces(idx, pieces, print_data);
+    return pieces.size();
+}
+
+// Lay Out a CodeBox Once and Split it by Lines in Pieces that Fit the Page, Returns the Number of Pieces
+size_t CtPrint::_codebox_layout_split(size_t idx, const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data)
+{
+    CtPrintCodeboxProxy* codeboxProxy = dynamic_cast<CtPrintCodeboxProxy*>(_widgets[idx].get());
+    auto codebox_layout = _get_codebox_layout(context, codeboxProxy);
+    auto codebox_lines = std::make_shared<const CtPrintLayoutLines>(codebox_layout->get_lines_readonly());
+    const int line_count = (int)codebox_lines->size();
+    const double max_height = _page_height - _layout_newline_height;
+    if (_get_height_from_lines(*codebox_lines) + BOX_OFFSET <= max_height)
     {
-        if (i == 0)
-            codeboxProxy->set_proxy_content(result_pango[i]);
-        else
+        codeboxProxy->set_layout(codebox_layout, codebox_lines, 0, line_count);
+        return 1;
+    }
+
+    // every piece has at least one line, the pieces share the layout
+    std::vector<std::shared_ptr<CtPrintWidgetProxy>> pieces;
+    const double box_height = 2 * CtConst::GRID_SLIP_OFFSET + BOX_OFFSET;
+    for (int first_line = 0; first_line < line_count; )
+    {
+        double piece_height = box_height + _layout_line_get_width_height((*codebox_lines)[first_line]).height;
+        int end_line = first_line + 1;
+        while (end_line < line_count)
         {
-            size_t index = idx+i;
-            // add a newline
-            print_data->text.insert(print_data->text.begin() + index, CtConst::CHAR_NEWLINE);
-            // add a codebox
-            auto proxy = std::shared_ptr<CtPrintCodeboxProxy>(new CtPrintCodeboxProxy(codeboxProxy->get_codebox(), result_pango[i]));
-            _widgets.insert(_widgets.begin() + index, proxy);
+            double line_height = _layout_line_get_width_height((*codebox_lines)[end_line]).height;
+            if (piece_height + line_height > max_height) break;
+            piece_height += line_height;
+            end_line += 1;
         }
+        auto piece = std::make_shared<CtPrintCodeboxProxy>(codeboxProxy->get_codebox());
+        piece->set_layout(codebox_layout, codebox_lines, first_line, end_line);
+        pieces.push_back(piece);
+        first_line = end_line;
+    }
+    _insert_widget_pieces(idx, pieces, print_data);
+    return pieces.size();
+}
+
+// Replace the Widget with its Pieces, each Piece after the First on a New Line
+void CtPrint::_insert_widget_pieces(size_t idx, const std::vector<std::shared_ptr<CtPrintWidgetProxy>>& pieces, CtPrintData* print_data)
+{
+    _widgets[idx] = pieces[0];
+    for (size_t i = 1; i < pieces.size(); ++i)
+    {
+        // add a newline
+        print_data->text.insert(print_data->text.begin() + idx + i, CtConst::CHAR_NEWLINE);
+        // add the piece
+        _widgets.insert(_widgets.begin() + idx + i, pieces[i]);
     }
 }
 
@@ -548,13 +541,14 @@ void CtPrint::_codebox_draw_box(Cairo::RefPtr<Cairo::Context> cairo_context, dou
 }
 
 // Draw the code inside of the Box
-void CtPrint::_codebox_draw_code(Cairo::RefPtr<Cairo::Context> cairo_context, Glib::RefPtr<Pango::Layout> codebox_layout, double x0, double y0)
+void CtPrint::_codebox_draw_code(Cairo::RefPtr<Cairo::Context> cairo_context, CtPrintCodeboxProxy* codeboxProxy, double x0, double y0)
 {
+    const CtPrintLayoutLines& codebox_lines = codeboxProxy->get_lines();
     double y = y0;
     cairo_context->set_source_rgb(0, 0, 0);
-    for (int layout_line_idx = 0; layout_line_idx < codebox_layout->get_line_count(); ++layout_line_idx)
+    for (int layout_line_idx = codeboxProxy->get_first_line(); layout_line_idx < codeboxProxy->get_end_line(); ++layout_line_idx)
     {
-        auto layout_line = codebox_layout->get_line(layout_line_idx);
+        auto layout_line = codebox_lines[layout_line_idx];
         double line_height = _layout_line_get_width_height(layout_line).height;
         cairo_context->move_to(x0 + CtConst::GRID_SLIP_OFFSET, y + line_height);
         y += line_height;
@@ -563,7 +557,7 @@ void CtPrint::_codebox_draw_code(Cairo::RefPtr<Cairo::Context> cairo_context, Gl
 }
 
 // Draw the Table Grid
-void CtPrint::_table_draw_grid(Cairo::RefPtr<Cairo::Context> cairo_context, const std::pair<std::vector<double>, std::vector<double>>& table_grid,
+void CtPrint::_table_draw_grid(Cairo::RefPtr<Cairo::Context> cairo_context, const CtPrintTableGrid& table_grid,
                                double x0, double y0, double table_width, double table_height)
 {
     double x = x0;
@@ -593,8 +587,8 @@ void CtPrint::_table_draw_grid(Cairo::RefPtr<Cairo::Context> cairo_context, cons
 
 // Draw the text inside of the Table Cells
 void CtPrint::_table_draw_text(Cairo::RefPtr<Cairo::Context> cairo_context,
-                              const std::pair<std::vector<double>, std::vector<double>>& table_grid,
-                              const std::vector<std::vector<Glib::RefPtr<Pango::Layout>>>& table_layouts,
+                              const CtPrintTableGrid& table_grid,
+                              const CtPrintTableLayouts& table_layouts,
                               double x0, double y0)
 {
     cairo_context->set_source_rgb(0, 0, 0);
@@ -608,9 +602,8 @@ void CtPrint::_table_draw_text(Cairo::RefPtr<Cairo::Context> cairo_context,
             double col_w = table_grid.second[j];
             auto layout_cell = table_layouts[i][j];
             double local_y = y;
-            for (int layout_line_id = 0; layout_line_id < layout_cell->get_line_count(); ++layout_line_id)
+            for (const auto& layout_line : layout_cell->get_lines_readonly())
             {
-                auto layout_line = layout_cell->get_line(layout_line_id);
                 double line_height = _layout_line_get_width_height(layout_line).height;
                 cairo_context->move_to(x, local_y + line_height);
                 local_y += line_height;
@@ -31,6 +31,10 @@ public:
     virtual ~CtPrintWidgetProxy() {}
 };
 
+using CtPrintTableLayouts = std::vector<std::vector<Glib::RefPtr<Pango::Layout>>>;
+using CtPrintTableGrid = std::pair<std::vector<double>, std::vector<double>>;
+using CtPrintLayoutLines = std::vector<Glib::RefPtr<const Pango::LayoutLine>>;
+
 // proxy to keep pixbuf
 class CtPrintImageProxy : public CtPrintWidgetProxy
 {
@@ -38,9 +42,13 @@ public:
     CtPrintImageProxy(CtImage* image) : _image(image) {}
     CtImage*                  get_image()  { return _image; }
     Glib::RefPtr<Gdk::Pixbuf> get_pixbuf() { return _image->get_pixbuf(); }
+    // the height on the line, at the scale that fits the page, decided before the text is paginated
+    void                      set_height(double height) { _height = height; }
+    double                    get_height() { return _height; }
 
 private:
     CtImage* _image;
+    double   _height{0};
 };
 
 // proxy to split tables
@@ -49,48 +57,53 @@ class CtPrintTableProxy : public CtPrintWidgetProxy
 public:
     CtPrintTableProxy(CtTable* table, int startRow, int rowNum): _table(table), _startRow(startRow), _rowNum(rowNum) {}
 
-    std::shared_ptr<CtPrintTableProxy> create_new_with(int row_num) { return std::shared_ptr<CtPrintTableProxy>(new CtPrintTableProxy(_table, _startRow, row_num)); }
-
-    void     remove_first_rows(int remove_row_num) { _startRow += remove_row_num; _rowNum -= remove_row_num; }
     CtTable* get_table()                    { return _table; }
+    int      get_start_row()                { return _startRow; }
     int      get_row_num()                  { return _rowNum; }
-    int      get_col_num()                  { return (int)_table->get_table_matrix().begin()->size(); }
-    // todo: it can work slow because of moving iterators every time; to fix: replace list by vector or use cache
+    int      get_col_num()                  { return _table->get_num_columns(); }
     Glib::ustring get_cell(int row, int col) {
         // 0 row is always header row, 1 row starts from _startRow
         row = (row == 0) ? 0 : row - 1 + _startRow;
-        auto tableRow = _table->get_table_matrix().begin();
-        std::advance(tableRow, row);
-        auto tableCell = tableRow->begin();
-        std::advance(tableCell, col);
-        return (*tableCell)->get_text_content();
+        return _table->get_cell_text(row, col);
     }
+    // the layouts of the cells are created once, the proxies splitting a table share them
+    void                        set_layouts(CtPrintTableLayouts layouts, CtPrintTableGrid grid) { _layouts = std::move(layouts); _grid = std::move(grid); }
+    const CtPrintTableLayouts&  get_layouts() { return _layouts; }
+    CtPrintTableGrid&           get_grid()    { return _grid; }
 
 private:
     CtTable* _table;
     int      _startRow;  // never starts from header row (because proxies for the same table have the same header)
     int      _rowNum;    // includes header row
-
+    CtPrintTableLayouts _layouts;
+    CtPrintTableGrid    _grid;
 };
 
 // proxy to split codebox
 class CtPrintCodeboxProxy : public CtPrintWidgetProxy
 {
 public:
-    CtPrintCodeboxProxy(CtCodebox* codebox) : _codebox(codebox), _use_proxy_text(false) {}
-    CtPrintCodeboxProxy(CtCodebox* codebox, const Glib::ustring& proxy_text) : _codebox(codebox),_proxy_text(proxy_text), _use_proxy_text(true)  {}
+    CtPrintCodeboxProxy(CtCodebox* codebox) : _codebox(codebox) {}
     CtCodebox*          get_codebox()          { return _codebox; }
     bool                get_width_in_pixels()  { return _codebox->get_width_in_pixels(); }
     int                 get_frame_width()      { return _codebox->get_frame_width(); }
-    const Glib::ustring get_text_content()     { return _use_proxy_text ? _proxy_text : pango_from_code_buffer(_codebox); }
-    void                set_proxy_content(const Glib::ustring& text) { _proxy_text = text; _use_proxy_text = true; }
+    const Glib::ustring get_text_content()     { return pango_from_code_buffer(_codebox); }
+    // the layout is created once, the proxies splitting a codebox share it and each draws a range of its lines
+    void                set_layout(Glib::RefPtr<Pango::Layout> layout, std::shared_ptr<const CtPrintLayoutLines> lines, int firstLine, int endLine)
+                        { _layout = layout; _lines = lines; _firstLine = firstLine; _endLine = endLine; }
+    Glib::RefPtr<Pango::Layout> get_layout()   { return _layout; }
+    const CtPrintLayoutLines& get_lines()      { return *_lines; }
+    int                 get_first_line()       { return _firstLine; }
+    int                 get_end_line()         { return _endLine; }
 
     Glib::ustring       pango_from_code_buffer(CtCodebox* codebox); // couldn't use CtExport2Pango in .h, so created helper function
 
 private:
-    CtCodebox*    _codebox;
-    Glib::ustring _proxy_text;
-    bool          _use_proxy_text;
+    CtCodebox*                  _codebox;
+    Glib::RefPtr<Pango::Layout> _layout;
+    std::shared_ptr<const CtPrintLayoutLines> _lines;
+    int                         _firstLine{0};
+    int                         _endLine{0};
 };
 
 // proxy for nullptr and others
@@ -109,9 +122,10 @@ struct CtPrintData
     std::vector<Glib::RefPtr<Pango::Layout>>        layout;
     std::vector<bool>                               forced_page_break;
     std::vector<bool>                               layout_is_new_line;
-    std::vector<int>                                layout_num_lines;
+    std::vector<CtPrintLayoutLines>                 layout_lines; // walked by index, pango_layout_get_line() walks a list
     std::vector<std::pair<int, int>>                page_breaks;
     std::vector<double>                             all_lines_y;
+    bool                                            any_image_resized{false};
     Glib::ustring                                   warning;
 };
 
@@ -138,25 +152,25 @@ private:
 
 private:
     Cairo::Rectangle            _layout_line_get_width_height(Glib::RefPtr<const Pango::LayoutLine> line);
-    double                      _get_height_from_layout(Glib::RefPtr<Pango::Layout> layout);
-    double                      _get_width_from_layout(Glib::RefPtr<Pango::Layout> layout);
+    double                      _get_height_from_lines(const CtPrintLayoutLines& lines, int first_line = 0, int end_line = -1);
+    double                      _get_width_from_lines(const CtPrintLayoutLines& lines, int first_line = 0, int end_line = -1);
     Glib::RefPtr<Pango::Layout> _get_codebox_layout(const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintCodeboxProxy* codeboxProxy);
-    std::vector<std::vector<Glib::RefPtr<Pango::Layout>>>
-                                _get_table_layouts(const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintTableProxy* tableProxy);
-    std::pair<std::vector<double>, std::vector<double>>
-                                _get_table_grid(std::vector<std::vector<Glib::RefPtr<Pango::Layout>>>& table_layouts, int col_min);
-    double                      _get_table_width_from_grid(std::pair<std::vector<double>, std::vector<double>>& table_grid);
-    double                      _get_table_height_from_grid(std::pair<std::vector<double>, std::vector<double>>& table_grid);
-    void                        _table_long_split(size_t idx, const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data);
-    void                        _codebox_long_split(size_t idx, const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data);
+    CtPrintTableLayouts         _get_table_layouts(const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintTableProxy* tableProxy);
+    CtPrintTableGrid            _get_table_grid(const CtPrintTableLayouts& table_layouts, int col_min);
+    double                      _get_table_width_from_grid(const CtPrintTableGrid& table_grid);
+    double                      _get_table_height_from_grid(const CtPrintTableGrid& table_grid);
+    void                        _prepare_widgets(const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data);
+    size_t                      _table_layout_split(size_t idx, const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data);
+    size_t                      _codebox_layout_split(size_t idx, const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data);
+    void                        _insert_widget_pieces(size_t idx, const std::vector<std::shared_ptr<CtPrintWidgetProxy>>& pieces, CtPrintData* print_data);
 
     void _codebox_draw_box(Cairo::RefPtr<Cairo::Context> cairo_context, double x0, double y0, double codebox_width, double codebox_height);
-    void _codebox_draw_code(Cairo::RefPtr<Cairo::Context> cairo_context, Glib::RefPtr<Pango::Layout> codebox_layout, double x0, double y0);
-    void _table_draw_grid(Cairo::RefPtr<Cairo::Context> cairo_context, const std::pair<std::vector<double>, std::vector<double>>& table_grid,
+    void _codebox_draw_code(Cairo::RefPtr<Cairo::Context> cairo_context, CtPrintCodeboxProxy* codeboxProxy, double x0, double y0);
+    void _table_draw_grid(Cairo::RefPtr<Cairo::Context> cairo_context, const CtPrintTableGrid& table_grid,
                           double x0, double y0, double table_width, double table_height);
     void _table_draw_text(Cairo::RefPtr<Cairo::Context> cairo_context,
-                          const std::pair<std::vector<double>, std::vector<double>>& table_grid,
-                          const std::vector<std::vector<Glib::RefPtr<Pango::Layout>>>& table_layouts,
+                          const CtPrintTableGrid& table_grid,
+                          const CtPrintTableLayouts& table_layouts,
                           double x0, double y0);
 
 private:
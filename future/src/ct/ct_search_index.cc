@@ -0,0 +1,621 @@
+/*
+ * ct_search_index.cc
+ *
+ * Copyright 2017-2020 Giuseppe Penone <giuspen@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_search_index.h"
+#include "ct_misc_utils.h"
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <set>
+
+static const char    CACHE_MAGIC[] = "ctidx01";
+static const guint32 CACHE_BYTE_ORDER = 0x01020304;
+
+void CtTrigramIndex::clear()
+{
+    _nodesTrigrams.clear();
+    _postings.clear();
+}
+
+void CtTrigramIndex::set_node_text(const gint64 node_id, const std::string& text)
+{
+    remove_node(node_id);
+    std::vector<Trigram> trigrams = get_text_trigrams(text);
+    _postings_add(node_id, trigrams);
+    _nodesTrigrams[node_id] = std::move(trigrams);
+}
+
+void CtTrigramIndex::append_node_text(const gint64 node_id, const std::string& text)
+{
+    std::vector<Trigram>& nodeTrigrams = _nodesTrigrams[node_id];
+    const std::vector<Trigram> textTrigrams = get_text_trigrams(text);
+    std::vector<Trigram> newTrigrams;
+    std::set_difference(textTrigrams.begin(), textTrigrams.end(),
+                        nodeTrigrams.begin(), nodeTrigrams.end(),
+                        std::back_inserter(newTrigrams));
+    if (newTrigrams.empty())
+    {
+        return;
+    }
+    _postings_add(node_id, newTrigrams);
+    std::vector<Trigram> mergedTrigrams;
+    mergedTrigrams.reserve(nodeTrigrams.size() + newTrigrams.size());
+    std::merge(nodeTrigrams.begin(), nodeTrigrams.end(),
+               newTrigrams.begin(), newTrigrams.end(),
+               std::back_inserter(mergedTrigrams));
+    nodeTrigrams = std::move(mergedTrigrams);
+}
+
+void CtTrigramIndex::remove_node(const gint64 node_id)
+{
+    auto iterNode = _nodesTrigrams.find(node_id);
+    if (iterNode != _nodesTrigrams.end())
+    {
+        _postings_remove(node_id, iterNode->second);
+        _nodesTrigrams.erase(iterNode);
+    }
+}
+
+void CtTrigramIndex::_postings_add(const gint64 node_id, const std::vector<Trigram>& trigrams)
+{
+    for (const Trigram trigram : trigrams)
+    {
+        std::vector<gint64>& nodeIds = _postings[trigram];
+        auto iterPos = std::lower_bound(nodeIds.begin(), nodeIds.end(), node_id);
+        if (iterPos == nodeIds.end() or *iterPos != node_id)
+        {
+            nodeIds.insert(iterPos, node_id);
+        }
+    }
+}
+
+void CtTrigramIndex::_postings_remove(const gint64 node_id, const std::vector<Trigram>& trigrams)
+{
+    for (const Trigram trigram : trigrams)
+    {
+        auto iterPosting = _postings.find(trigram);
+        if (iterPosting == _postings.end())
+        {
+            continue;
+        }
+        std::vector<gint64>& nodeIds = iterPosting->second;
+        auto iterPos = std::lower_bound(nodeIds.begin(), nodeIds.end(), node_id);
+        if (iterPos != nodeIds.end() and *iterPos == node_id)
+        {
+            nodeIds.erase(iterPos);
+        }
+        if (nodeIds.empty())
+        {
+            _postings.erase(iterPosting);
+        }
+    }
+}
+
+std::unordered_set<gint64> CtTrigramIndex::get_candidates(const std::vector<Trigram>& trigrams) const
+{
+    std::unordered_set<gint64> candidates;
+    std::vector<const std::vector<gint64>*> postings;
+    for (const Trigram trigram : trigrams)
+    {
+        auto iterPosting = _postings.find(trigram);
+        if (iterPosting == _postings.end())
+        {
+            return candidates; // no indexed node contains this trigram
+        }
+        postings.push_back(&iterPosting->second);
+    }
+    if (postings.empty())
+    {
+        return candidates;
+    }
+    // intersect starting from the rarest trigram
+    std::sort(postings.begin(), postings.end(), [](const std::vector<gint64>* a, const std::vector<gint64>* b){
+        return a->size() < b->size();
+    });
+    std::vector<gint64> nodeIds = *postings.front();
+    for (size_t i = 1; i < postings.size() and not nodeIds.empty(); ++i)
+    {
+        std::vector<gint64> intersection;
+        std::set_intersection(nodeIds.begin(), nodeIds.end(),
+                              postings[i]->begin(), postings[i]->end(),
+                              std::back_inserter(intersection));
+        nodeIds = std::move(intersection);
+    }
+    candidates.insert(nodeIds.begin(), nodeIds.end());
+    return candidates;
+}
+
+std::vector<CtTrigramIndex::Trigram> CtTrigramIndex::get_text_trigrams(const std::string& text)
+{
+    std::vector<Trigram> trigrams;
+    if (text.size() < 3)
+    {
+        return trigrams;
+    }
+    trigrams.reserve(text.size() - 2);
+    Trigram window{0};
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        const guint8 byte = static_cast<guint8>(g_ascii_tolower(text[i]));
+        window = ((window << 8) | byte) & 0xffffff;
+        if (i >= 2)
+        {
+            trigrams.push_back(window);
+        }
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+// a caseless match of an ASCII trigram can only hit the same ASCII trigram, apart from
+// 'k' and 's' which also match the Kelvin sign and the long s
+static bool _is_caseless_safe(const CtTrigramIndex::Trigram trigram)
+{
+    for (int shift = 0; shift <= 16; shift += 8)
+    {
+        const guint8 byte = (trigram >> shift) & 0xff;
+        if (byte >= 0x80 or 'k' == byte or 's' == byte)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<CtTrigramIndex::Trigram> CtTrigramIndex::get_required_trigrams(const std::string& pattern, const bool isRegExp, const bool matchCase)
+{
+    const std::vector<std::string> literals = isRegExp ? get_required_literals(pattern) : std::vector<std::string>{pattern};
+    std::set<Trigram> required;
+    for (const std::string& literal : literals)
+    {
+        for (const Trigram trigram : get_text_trigrams(literal))
+        {
+            if (matchCase or _is_caseless_safe(trigram))
+            {
+                required.insert(trigram);
+            }
+        }
+    }
+    return std::vector<Trigram>(required.begin(), required.end());
+}
+
+// Conservative decomposition: whatever is not surely mandatory is left out,
+// and on any construct not understood no literal is returned at all
+std::vector<std::string> CtTrigramIndex::get_required_literals(const std::string& regExp)
+{
+    std::vector<std::string> literals;
+    if ( std::string::npos != regExp.find('|') or
+         std::string::npos != regExp.find("(?") )
+    {
+        return literals; // alternatives or inline options
+    }
+    std::string run;
+    auto flush_run = [&literals, &run]()
+    {
+        if (not run.empty())
+        {
+            literals.push_back(run);
+            run.clear();
+        }
+    };
+    auto drop_last_char = [&run]()
+    {
+        while (not run.empty() and 0x80 == (static_cast<guint8>(run.back()) & 0xc0))
+        {
+            run.pop_back();
+        }
+        if (not run.empty())
+        {
+            run.pop_back();
+        }
+    };
+    // returns the position of the closing ']' of the class starting at pos, or npos
+    auto skip_class = [&regExp](size_t pos)->size_t
+    {
+        ++pos;
+        if (pos < regExp.size() and '^' == regExp[pos]) ++pos;
+        if (pos < regExp.size() and ']' == regExp[pos]) ++pos;
+        while (pos < regExp.size() and ']' != regExp[pos])
+        {
+            if ('\\' == regExp[pos])
+            {
+                ++pos;
+            }
+            else if ('[' == regExp[pos] and pos+1 < regExp.size() and ':' == regExp[pos+1])
+            {
+                const size_t posixEnd = regExp.find(":]", pos+2);
+                if (std::string::npos == posixEnd) return std::string::npos;
+                pos = posixEnd + 1;
+            }
+            ++pos;
+        }
+        return pos < regExp.size() ? pos : std::string::npos;
+    };
+    const size_t len = regExp.size();
+    for (size_t i = 0; i < len; ++i)
+    {
+        const char c = regExp[i];
+        switch (c)
+        {
+            case '\\':
+            {
+                if (i+1 >= len) return {};
+                const char escaped = regExp[++i];
+                if (g_ascii_isalnum(escaped))
+                {
+                    // only the escapes of fixed length, others (\x, \p, \Q...) are not decoded
+                    if (nullptr == strchr("dDwWsSbBAzZGhHvVRnrtfe", escaped)) return {};
+                    flush_run();
+                }
+                else
+                {
+                    run += escaped;
+                }
+            } break;
+            case '[':
+            {
+                flush_run();
+                i = skip_class(i);
+                if (std::string::npos == i) return {};
+            } break;
+            case '(':
+            {
+                flush_run();
+                int depth{1};
+                while (depth > 0 and ++i < len)
+                {
+                    if ('\\' == regExp[i]) ++i;
+                    else if ('[' == regExp[i])
+                    {
+                        i = skip_class(i);
+                        if (std::string::npos == i) return {};
+                    }
+                    else if ('(' == regExp[i]) ++depth;
+                    else if (')' == regExp[i]) --depth;
+                }
+                if (depth > 0) return {};
+            } break;
+            case ')':
+                return {};
+            case '?':
+            case '*':
+            {
+                drop_last_char();
+                flush_run();
+            } break;
+            case '{':
+            {
+                drop_last_char();
+                flush_run();
+                i = regExp.find('}', i);
+                if (std::string::npos == i) return {};
+            } break;
+            case '+':
+            case '.':
+            case '^':
+            case '$':
+            {
+                flush_run();
+            } break;
+            default:
+            {
+                run += c;
+            } break;
+        }
+    }
+    flush_run();
+    return literals;
+}
+
+std::string CtTrigramIndex::get_cache_filepath(const std::string& doc_filepath)
+{
+    return Glib::build_filename(Glib::path_get_dirname(doc_filepath), "." + Glib::path_get_basename(doc_filepath) + ".idx");
+}
+
+template<typename T> static void _cache_append(std::string& buffer, const T& value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T> static bool _cache_extract(const gchar* pData, const gsize dataLen, gsize& offset, T& value)
+{
+    if (offset + sizeof(T) > dataLen)
+    {
+        return false;
+    }
+    memcpy(&value, pData + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+bool CtTrigramIndex::write_cache(const std::string& doc_filepath) const
+{
+    std::string buffer{CACHE_MAGIC};
+    _cache_append(buffer, CACHE_BYTE_ORDER);
+    _cache_append(buffer, static_cast<gint64>(CtFileSystem::getmtime(doc_filepath)));
+    _cache_append(buffer, static_cast<gint64>(CtFileSystem::getsize(doc_filepath)));
+    _cache_append(buffer, static_cast<guint64>(_nodesTrigrams.size()));
+    for (const auto& nodePair : _nodesTrigrams)
+    {
+        _cache_append(buffer, nodePair.first);
+        _cache_append(buffer, static_cast<guint32>(nodePair.second.size()));
+        buffer.append(reinterpret_cast<const char*>(nodePair.second.data()), nodePair.second.size()*sizeof(Trigram));
+    }
+    const std::string cache_filepath = get_cache_filepath(doc_filepath);
+    g_autoptr(GError) pError{nullptr};
+    if (not g_file_set_contents(cache_filepath.c_str(), buffer.data(), buffer.size(), &pError))
+    {
+        std::cerr << "!! W " << cache_filepath << " " << pError->message << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CtTrigramIndex::read_cache(const std::string& doc_filepath)
+{
+    clear();
+    const std::string cache_filepath = get_cache_filepath(doc_filepath);
+    if (not Glib::file_test(cache_filepath, Glib::FILE_TEST_IS_REGULAR))
+    {
+        return false;
+    }
+    g_autofree gchar* pData{nullptr};
+    gsize dataLen{0};
+    if (not g_file_get_contents(cache_filepath.c_str(), &pData, &dataLen, nullptr))
+    {
+        return false;
+    }
+    gsize offset = strlen(CACHE_MAGIC);
+    guint32 byteOrder{0};
+    gint64 docMtime{0};
+    gint64 docSize{0};
+    guint64 numNodes{0};
+    if ( dataLen < offset or
+         0 != memcmp(pData, CACHE_MAGIC, offset) or
+         not _cache_extract(pData, dataLen, offset, byteOrder) or
+         not _cache_extract(pData, dataLen, offset, docMtime) or
+         not _cache_extract(pData, dataLen, offset, docSize) or
+         not _cache_extract(pData, dataLen, offset, numNodes) or
+         CACHE_BYTE_ORDER != byteOrder or
+         docMtime != static_cast<gint64>(CtFileSystem::getmtime(doc_filepath)) or
+         docSize != static_cast<gint64>(CtFileSystem::getsize(doc_filepath)) )
+    {
+        // stale or foreign cache
+        return false;
+    }
+    for (guint64 n = 0; n < numNodes; ++n)
+    {
+        gint64 nodeId{0};
+        guint32 numTrigrams{0};
+        if ( not _cache_extract(pData, dataLen, offset, nodeId) or
+             not _cache_extract(pData, dataLen, offset, numTrigrams) or
+             offset + numTrigrams*sizeof(Trigram) > dataLen )
+        {
+            std::cerr << "!! " << cache_filepath << std::endl;
+            clear();
+            return false;
+        }
+        std::vector<Trigram> trigrams(numTrigrams);
+        memcpy(trigrams.data(), pData + offset, numTrigrams*sizeof(Trigram));
+        offset += numTrigrams*sizeof(Trigram);
+        for (const Trigram trigram : trigrams)
+        {
+            _postings[trigram].push_back(nodeId);
+        }
+        _nodesTrigrams[nodeId] = std::move(trigrams);
+    }
+    for (auto& postingPair : _postings)
+    {
+        std::sort(postingPair.second.begin(), postingPair.second.end());
+    }
+    return true;
+}
+
+void CtNodeNameIndex::clear()
+{
+    _entries.clear();
+    _latestMatches.clear();
+    ++_generation;
+    ++_pathGeneration;
+}
+
+void CtNodeNameIndex::set_node(const gint64 node_id, const gint64 father_id, const Glib::ustring& name, const Glib::ustring& tags)
+{
+    Entry& entry = _entries[node_id];
+    if (entry.fatherId != father_id or entry.name != name)
+    {
+        entry.fatherId = father_id;
+        entry.name = name;
+        entry.foldedName = name.casefold();
+        ++_pathGeneration;
+        ++_generation;
+    }
+    std::string foldedTags = tags.casefold();
+    if (entry.foldedTags != foldedTags)
+    {
+        entry.foldedTags = std::move(foldedTags);
+        ++_generation;
+    }
+}
+
+void CtNodeNameIndex::remove_node(const gint64 node_id)
+{
+    if (_entries.erase(node_id))
+    {
+        ++_pathGeneration;
+        ++_generation;
+    }
+}
+
+const std::string& CtNodeNameIndex::_get_folded_path(Entry& entry)
+{
+    if (entry.pathGeneration != _pathGeneration)
+    {
+        auto iterFather = _entries.find(entry.fatherId);
+        if (iterFather != _entries.end() and &iterFather->second != &entry)
+        {
+            entry.foldedPath = _get_folded_path(iterFather->second) + "/" + entry.foldedName;
+        }
+        else
+        {
+            entry.foldedPath = entry.foldedName;
+        }
+        entry.pathGeneration = _pathGeneration;
+    }
+    return entry.foldedPath;
+}
+
+Glib::ustring CtNodeNameIndex::get_node_path(const gint64 node_id) const
+{
+    Glib::ustring path;
+    auto iterEntry = _entries.find(node_id);
+    while (iterEntry != _entries.end())
+    {
+        if (not path.empty())
+        {
+            path = " / " + path;
+        }
+        path = iterEntry->second.name + path;
+        if (iterEntry->second.fatherId == iterEntry->first)
+        {
+            break;
+        }
+        iterEntry = _entries.find(iterEntry->second.fatherId);
+    }
+    return path;
+}
+
+int CtNodeNameIndex::get_match_score(const std::string& text, const std::string& foldedQuery)
+{
+    if (foldedQuery.empty())
+    {
+        return 0;
+    }
+    const size_t pos = text.find(foldedQuery);
+    if (0 == pos)
+    {
+        return text.size() == foldedQuery.size() ? 1000 : 800 - static_cast<int>(std::min<size_t>(text.size() - foldedQuery.size(), 100));
+    }
+    if (std::string::npos != pos)
+    {
+        const bool wordStart = not g_ascii_isalnum(text[pos-1]);
+        return (wordStart ? 600 : 400) - static_cast<int>(std::min<size_t>(pos, 100));
+    }
+    // fuzzy, all the query characters in order
+    size_t textPos{0};
+    size_t lastFound{std::string::npos};
+    int gaps{0};
+    for (const char c : foldedQuery)
+    {
+        const size_t found = text.find(c, textPos);
+        if (std::string::npos == found)
+        {
+            return 0;
+        }
+        if (std::string::npos != lastFound and found != lastFound + 1)
+        {
+            ++gaps;
+        }
+        lastFound = found;
+        textPos = found + 1;
+    }
+    return std::max(1, 200 - 10*gaps);
+}
+
+int CtNodeNameIndex::_get_entry_score(Entry& entry, const std::string& foldedQuery, const bool withPath)
+{
+    int score = get_match_score(entry.foldedName, foldedQuery);
+    if (score < 300 and std::string::npos != entry.foldedTags.find(foldedQuery))
+    {
+        score = 300;
+    }
+    if (withPath and score < 150 and std::string::npos != _get_folded_path(entry).find(foldedQuery))
+    {
+        score = 150;
+    }
+    return score;
+}
+
+std::vector<CtNodeNameIndex::Match> CtNodeNameIndex::query(const Glib::ustring& pattern, const size_t maxResults)
+{
+    std::vector<Match> matches;
+    const std::string foldedQuery = pattern.casefold();
+    if (foldedQuery.empty())
+    {
+        _latestQuery.clear();
+        _latestMatches.clear();
+        return matches;
+    }
+    // the path is matched only by queries with a separator, a narrowed query
+    // can reuse the latest matches only if both match the same fields
+    const bool withPath = std::string::npos != foldedQuery.find('/');
+    const bool narrowing = ( _latestGeneration == _generation and
+                             not _latestQuery.empty() and
+                             withPath == (std::string::npos != _latestQuery.find('/')) and
+                             str::startswith(foldedQuery, _latestQuery) );
+    std::vector<gint64> allMatched;
+    auto consider = [&](const gint64 node_id, Entry& entry)
+    {
+        const int score = _get_entry_score(entry, foldedQuery, withPath);
+        if (score > 0)
+        {
+            allMatched.push_back(node_id);
+            matches.push_back(Match{node_id, score});
+        }
+    };
+    if (narrowing)
+    {
+        for (const gint64 node_id : _latestMatches)
+        {
+            consider(node_id, _entries.at(node_id));
+        }
+    }
+    else
+    {
+        for (auto& entryPair : _entries)
+        {
+            consider(entryPair.first, entryPair.second);
+        }
+    }
+    _latestQuery = foldedQuery;
+    _latestGeneration = _generation;
+    _latestMatches = std::move(allMatched);
+
+    auto compare = [this](const Match& a, const Match& b)
+    {
+        if (a.score != b.score) return a.score > b.score;
+        const size_t aLen = _entries.at(a.nodeId).foldedName.size();
+        const size_t bLen = _entries.at(b.nodeId).foldedName.size();
+        if (aLen != bLen) return aLen < bLen;
+        return a.nodeId < b.nodeId;
+    };
+    if (matches.size() > maxResults)
+    {
+        std::partial_sort(matches.begin(), matches.begin() + maxResults, matches.end(), compare);
+        matches.resize(maxResults);
+    }
+    else
+    {
+        std::sort(matches.begin(), matches.end(), compare);
+    }
+    return matches;
+}
@@ -0,0 +1,110 @@
+/*
+ * ct_search_index.h
+ *
+ * Copyright 2017-2020 Giuseppe Penone <giuspen@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <glibmm.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <string>
+
+// Trigram index over the searchable text of the nodes (text, codeboxes, table cells,
+// embedded file names and anchor names), used to skip nodes that cannot contain a match.
+// Trigrams are computed on the UTF-8 bytes with ASCII letters lowercased.
+// A node which is not indexed is always a candidate, so the index may only narrow a search,
+// never hide a match.
+class CtTrigramIndex
+{
+public:
+    using Trigram = guint32;
+
+    void clear();
+    bool empty() const { return _nodesTrigrams.empty(); }
+
+    void set_node_text(const gint64 node_id, const std::string& text);
+    void append_node_text(const gint64 node_id, const std::string& text);
+    void remove_node(const gint64 node_id);
+    bool is_node_indexed(const gint64 node_id) const { return 0 != _nodesTrigrams.count(node_id); }
+
+    // nodes containing all of the given trigrams
+    std::unordered_set<gint64> get_candidates(const std::vector<Trigram>& trigrams) const;
+
+    // trigrams that any text matching the pattern must contain, empty if no filter can be applied
+    static std::vector<Trigram> get_required_trigrams(const std::string& pattern, const bool isRegExp, const bool matchCase);
+    // literal runs that any text matching the regular expression must contain
+    static std::vector<std::string> get_required_literals(const std::string& regExp);
+    static std::vector<Trigram> get_text_trigrams(const std::string& text);
+
+    static std::string get_cache_filepath(const std::string& doc_filepath);
+    bool write_cache(const std::string& doc_filepath) const;
+    bool read_cache(const std::string& doc_filepath);
+
+private:
+    void _postings_add(const gint64 node_id, const std::vector<Trigram>& trigrams);
+    void _postings_remove(const gint64 node_id, const std::vector<Trigram>& trigrams);
+
+    std::unordered_map<gint64, std::vector<Trigram>>  _nodesTrigrams; // sorted, unique
+    std::unordered_map<Trigram, std::vector<gint64>>  _postings;      // sorted node ids
+};
+
+// In-memory index of the node names, tags and paths, behind the as-you-type tree filter
+class CtNodeNameIndex
+{
+public:
+    struct Match
+    {
+        gint64 nodeId;
+        int    score;
+    };
+
+    void   clear();
+    void   set_node(const gint64 node_id, const gint64 father_id, const Glib::ustring& name, const Glib::ustring& tags);
+    void   remove_node(const gint64 node_id);
+    size_t size() const { return _entries.size(); }
+
+    // best matches first, at most maxResults
+    std::vector<Match> query(const Glib::ustring& pattern, const size_t maxResults);
+    Glib::ustring      get_node_path(const gint64 node_id) const;
+
+    // 0 if no match, higher for exact, prefix, word start, substring and then fuzzy matches
+    static int get_match_score(const std::string& text, const std::string& foldedQuery);
+
+private:
+    struct Entry
+    {
+        gint64        fatherId{0};
+        Glib::ustring name;
+        std::string   foldedName;
+        std::string   foldedTags;
+        std::string   foldedPath;
+        guint64       pathGeneration{0};
+    };
+    const std::string& _get_folded_path(Entry& entry);
+    int                _get_entry_score(Entry& entry, const std::string& foldedQuery, const bool withPath);
+
+    std::unordered_map<gint64, Entry> _entries;
+    guint64             _generation{1};      // bumped on every change, invalidates the latest matches
+    guint64             _pathGeneration{1};  // bumped on renames and moves, invalidates the paths
+    std::string         _latestQuery;
+    guint64             _latestGeneration{0};
+    std::vector<gint64> _latestMatches;      // all the nodes matching the latest query
+};
@@ -87,7 +87,7 @@ const char CtSQLite::TABLE_IMAGE_CREATE[]{"CREATE TABLE image ("
 ")"
 };
 const char CtSQLite::TABLE_IMAGE_INSERT[]{"INSERT INTO image VALUES(?,?,?,?,?,?,?,?)"};
-const char CtSQLite::TABLE_IMAGE_DELETE[]{"DELETE FROM image WHERE node_id=?"};
+const char CtSQLite::TABLE_IMAGE_DELETE[]{"DELETE FROM image WHERE node_id=? AND rowid<=?"};
 
 const char CtSQLite::TABLE_CHILDREN_CREATE[]{"CREATE TABLE children ("
 "node_id INTEGER UNIQUE,"
@@ -116,6 +116,7 @@ CtSQLite::CtSQLite(CtMainWin* pCtMainWin, const char* filepath)
     if (SQLITE_OK == ret_code)
     {
         _dbOpenOk = true;
+        _spDb.reset(_pDb, sqlite3_close);
     }
     else
     {
@@ -125,11 +126,8 @@ CtSQLite::CtSQLite(CtMainWin* pCtMainWin, const char* filepath)
 
 CtSQLite::~CtSQLite()
 {
-    if (_dbOpenOk)
-    {
-        sqlite3_close(_pDb);
-        //printf("db closed\n");
-    }
+    // the db is closed once no embedded file is read from it any more
+    _spDb.reset();
 }
 
 bool CtSQLite::_exec_no_callback(const char* sqlCmd)
@@ -262,6 +260,95 @@ Glib::RefPtr<Gsv::Buffer> CtSQLite::get_text_buffer(const std::string& syntax,
     return rRetTextBuffer;
 }
 
+bool CtSQLite::read_nodes_search_text(const std::set<gint64>& nodeIds,
+                                      const std::function<void(const gint64, const std::string&)>& callback) const
+{
+    bool retVal{true};
+    const char* queries[4]{"SELECT node_id, txt, syntax FROM node",
+                           "SELECT node_id, txt FROM codebox",
+                           "SELECT node_id, txt FROM grid",
+                           "SELECT node_id, anchor, filename FROM image"};
+    for (int i=0; i<4; i++)
+    {
+        sqlite3_stmt *p_stmt;
+        if (sqlite3_prepare_v2(_pDb, queries[i], -1, &p_stmt, nullptr) != SQLITE_OK)
+        {
+            std::cerr << CtSQLite::ERR_SQLITE_PREPV2 << sqlite3_errmsg(_pDb) << std::endl;
+            retVal = false;
+            continue;
+        }
+        while (sqlite3_step(p_stmt) == SQLITE_ROW)
+        {
+            const gint64 nodeId = sqlite3_column_int64(p_stmt, 0);
+            if (0 == nodeIds.count(nodeId))
+            {
+                continue;
+            }
+            const char* textContent = reinterpret_cast<const char*>(sqlite3_column_text(p_stmt, 1));
+            if (nullptr == textContent)
+            {
+                continue;
+            }
+            if (0 == i)
+            {
+                const char* syntax = reinterpret_cast<const char*>(sqlite3_column_text(p_stmt, 2));
+                if (nullptr == syntax or CtConst::RICH_TEXT_ID != syntax)
+                {
+                    callback(nodeId, textContent);
+                    continue;
+                }
+                // same text that the buffer would get from the rich text slots
+                std::string nodeText;
+                CtXmlRead ctXmlRead(_pCtMainWin, nullptr, textContent);
+                if (nullptr != ctXmlRead.get_document())
+                {
+                    for (xmlpp::Node* pNode : ctXmlRead.get_document()->get_root_node()->get_children("rich_text"))
+                    {
+                        xmlpp::TextNode* pTextNode = static_cast<xmlpp::Element*>(pNode)->get_child_text();
+                        if (pTextNode)
+                        {
+                            nodeText += pTextNode->get_content();
+                        }
+                    }
+                }
+                callback(nodeId, nodeText);
+            }
+            else if (2 == i)
+            {
+                CtXmlRead ctXmlRead(_pCtMainWin, nullptr, textContent);
+                if (nullptr != ctXmlRead.get_document())
+                {
+                    for (xmlpp::Node* pNodeRow : ctXmlRead.get_document()->get_root_node()->get_children("row"))
+                    {
+                        for (xmlpp::Node* pNodeCell : pNodeRow->get_children("cell"))
+                        {
+                            xmlpp::TextNode* pTextNode = static_cast<xmlpp::Element*>(pNodeCell)->get_child_text();
+                            if (pTextNode)
+                            {
+                                callback(nodeId, pTextNode->get_content());
+                            }
+                        }
+                    }
+                }
+            }
+            else
+            {
+                callback(nodeId, textContent);
+                if (3 == i)
+                {
+                    const char* fileName = reinterpret_cast<const char*>(sqlite3_column_text(p_stmt, 2));
+                    if (nullptr != fileName)
+                    {
+                        callback(nodeId, fileName);
+                    }
+                }
+            }
+        }
+        sqlite3_finalize(p_stmt);
+    }
+    return retVal;
+}
+
 void CtSQLite::_get_text_buffer_anchored_widgets(Glib::RefPtr<Gsv::Buffer>& rTextBuffer,
                                                  std::list<CtAnchoredWidget*>& anchoredWidgets,
                                                  const gint64& nodeId,
@@ -275,16 +362,17 @@ void CtSQLite::_get_text_buffer_anchored_widgets(Glib::RefPtr<Gsv::Buffer>& rTex
     const int cOffsetRead{-2};
     int charOffset[3]{cOffsetNone, cOffsetNone, cOffsetNone};
     Glib::ustring justification[3];
-    const char* table_name[3]{"codebox", "grid", "image"};
+    // the contents of the embedded files are not read, only their size
+    const char* queries[3]{"SELECT * FROM codebox WHERE node_id=? ORDER BY offset ASC",
+                           "SELECT * FROM grid WHERE node_id=? ORDER BY offset ASC",
+                           "SELECT node_id, offset, justification, anchor, CASE WHEN filename='' THEN png END, filename, link, time, rowid, length(png) "
+                           "FROM image WHERE node_id=? ORDER BY offset ASC"};
 
     for (int i=0; i<3; i++)
     {
         if (has_it[i])
         {
-            char query_buff[64];
-            snprintf(query_buff, 64, "SELECT * FROM %s WHERE node_id=? ORDER BY offset ASC", table_name[i]);
-            //std::cout << query_buff << std::endl;
-            if (SQLITE_OK != sqlite3_prepare_v2(_pDb, query_buff, -1, &pp_stmt[i], nullptr))
+            if (SQLITE_OK != sqlite3_prepare_v2(_pDb, queries[i], -1, &pp_stmt[i], nullptr))
             {
                 std::cerr << CtSQLite::ERR_SQLITE_PREPV2 << sqlite3_errmsg(_pDb) << std::endl;
             }
@@ -361,7 +449,7 @@ void CtSQLite::_get_text_buffer_anchored_widgets(Glib::RefPtr<Gsv::Buffer>& rTex
             {
                 const bool isHeadFront = ctXmlRead.populate_table_matrix_get_is_head_front(tableMatrix, ctXmlRead.get_document()->get_root_node());
 
-                pAnchoredWidget = new CtTable(_pCtMainWin, tableMatrix, colMin, colMax, isHeadFront, charOffset[i], justification[i]);
+                pAnchoredWidget = new CtTable(_pCtMainWin, std::move(tableMatrix), colMin, colMax, isHeadFront, charOffset[i], justification[i]);
                 //std::cout << "table " << charOffset[i] << std::endl;
                 charOffset[i] = cOffsetRead;
             }
@@ -384,16 +472,19 @@ void CtSQLite::_get_text_buffer_anchored_widgets(Glib::RefPtr<Gsv::Buffer>& rTex
             else
             {
                 const Glib::ustring fileName = reinterpret_cast<const char*>(sqlite3_column_text(pp_stmt[i], 5));
-                const void* pBlob = sqlite3_column_blob(pp_stmt[i], 4);
-                const int blobSize = sqlite3_column_bytes(pp_stmt[i], 4);
-                const std::string rawBlob(reinterpret_cast<const char*>(pBlob), static_cast<size_t>(blobSize));
                 if (!fileName.empty())
                 {
                     const double timeDouble = sqlite3_column_int64(pp_stmt[i], 7);
-                    pAnchoredWidget = new CtImageEmbFile(_pCtMainWin, fileName, rawBlob, timeDouble, charOffset[i], justification[i]);
+                    const gint64 rowId = sqlite3_column_int64(pp_stmt[i], 8);
+                    const size_t blobSize = static_cast<size_t>(sqlite3_column_int64(pp_stmt[i], 9));
+                    pAnchoredWidget = new CtImageEmbFile(_pCtMainWin, fileName, CtEmbFileBlob::create_from_db(_spDb, rowId, blobSize),
+                                                         timeDouble, charOffset[i], justification[i]);
                 }
                 else
                 {
+                    const void* pBlob = sqlite3_column_blob(pp_stmt[i], 4);
+                    const int blobSize = sqlite3_column_bytes(pp_stmt[i], 4);
+                    const std::string rawBlob(reinterpret_cast<const char*>(pBlob), static_cast<size_t>(blobSize));
                     const Glib::ustring link = reinterpret_cast<const char*>(sqlite3_column_text(pp_stmt[i], 6));
                     pAnchoredWidget = new CtImagePng(_pCtMainWin, rawBlob, link, charOffset[i], justification[i]);
                 }
@@ -728,7 +819,7 @@ bool CtSQLite::pending_data_write(CtTreeStore* pTreeStore,
         _syncPending.nodes_to_rm_set.clear();
         if (run_vacuum)
         {
-            (void)_exec_no_callback("VACUUM");
+            (void)_vacuum();
             (void)_exec_no_callback("REINDEX");
         }
     }
@@ -739,7 +830,7 @@ bool CtSQLite::_remove_db_node_n_children(const gint64 node_id)
 {
     bool soFarSoGood = ( _exec_bind_int64(CtSQLite::TABLE_CODEBOX_DELETE, node_id) &&
                          _exec_bind_int64(CtSQLite::TABLE_TABLE_DELETE, node_id) &&
-                         _exec_bind_int64(CtSQLite::TABLE_IMAGE_DELETE, node_id) &&
+                         _remove_db_images(node_id, G_MAXINT64) &&
                          _exec_bind_int64(CtSQLite::TABLE_NODE_DELETE, node_id) &&
                          _exec_bind_int64(CtSQLite::TABLE_CHILDREN_DELETE, node_id) );
     if (soFarSoGood)
@@ -761,6 +852,111 @@ bool CtSQLite::_remove_db_node_n_children(const gint64 node_id)
     return soFarSoGood;
 }
 
+gint64 CtSQLite::_get_max_image_rowid()
+{
+    gint64 max_rowid{0};
+    sqlite3_stmt *p_stmt;
+    if (sqlite3_prepare_v2(_pDb, "SELECT max(rowid) FROM image", -1, &p_stmt, nullptr) != SQLITE_OK)
+    {
+        std::cerr << CtSQLite::ERR_SQLITE_PREPV2 << sqlite3_errmsg(_pDb) << std::endl;
+    }
+    else
+    {
+        if (SQLITE_ROW == sqlite3_step(p_stmt))
+        {
+            max_rowid = sqlite3_column_int64(p_stmt, 0);
+        }
+        sqlite3_finalize(p_stmt);
+    }
+    return max_rowid;
+}
+
+bool CtSQLite::_remove_db_images(const gint64 node_id, const gint64 max_rowid)
+{
+    sqlite3_stmt *p_stmt;
+    if (sqlite3_prepare_v2(_pDb, "SELECT rowid FROM image WHERE node_id=? AND rowid<=?", -1, &p_stmt, nullptr) != SQLITE_OK)
+    {
+        std::cerr << CtSQLite::ERR_SQLITE_PREPV2 << sqlite3_errmsg(_pDb) << std::endl;
+        return false;
+    }
+    std::vector<gint64> rowIds;
+    sqlite3_bind_int64(p_stmt, 1, node_id);
+    sqlite3_bind_int64(p_stmt, 2, max_rowid);
+    while (SQLITE_ROW == sqlite3_step(p_stmt))
+    {
+        rowIds.push_back(sqlite3_column_int64(p_stmt, 0));
+    }
+    sqlite3_finalize(p_stmt);
+    // the embedded files still reading from these rows are only held by undo states
+    CtEmbFileBlob::on_db_rows_removed(_pDb, rowIds);
+
+    bool retVal{true};
+    if (sqlite3_prepare_v2(_pDb, CtSQLite::TABLE_IMAGE_DELETE, -1, &p_stmt, nullptr) != SQLITE_OK)
+    {
+        std::cerr << CtSQLite::ERR_SQLITE_PREPV2 << sqlite3_errmsg(_pDb) << std::endl;
+        retVal = false;
+    }
+    else
+    {
+        sqlite3_bind_int64(p_stmt, 1, node_id);
+        sqlite3_bind_int64(p_stmt, 2, max_rowid);
+        if (sqlite3_step(p_stmt) != SQLITE_DONE)
+        {
+            std::cerr << CtSQLite::ERR_SQLITE_STEP << sqlite3_errmsg(_pDb) << std::endl;
+            retVal = false;
+        }
+        sqlite3_finalize(p_stmt);
+    }
+    return retVal;
+}
+
+bool CtSQLite::_vacuum()
+{
+    // the image table has no explicit primary key, the rows the embedded files are read from may be renumbered
+    std::vector<std::pair<gint64, std::pair<gint64, gint64>>> rowsKeys; // rowid, (node_id, offset)
+    sqlite3_stmt *p_stmt;
+    if (sqlite3_prepare_v2(_pDb, "SELECT node_id, offset FROM image WHERE rowid=?", -1, &p_stmt, nullptr) != SQLITE_OK)
+    {
+        std::cerr << CtSQLite::ERR_SQLITE_PREPV2 << sqlite3_errmsg(_pDb) << std::endl;
+        return false;
+    }
+    for (const gint64 rowId : CtEmbFileBlob::get_db_row_ids(_pDb))
+    {
+        sqlite3_bind_int64(p_stmt, 1, rowId);
+        if (SQLITE_ROW == sqlite3_step(p_stmt))
+        {
+            rowsKeys.push_back(std::make_pair(rowId, std::make_pair(sqlite3_column_int64(p_stmt, 0), sqlite3_column_int64(p_stmt, 1))));
+        }
+        sqlite3_reset(p_stmt);
+    }
+    sqlite3_finalize(p_stmt);
+
+    const bool retVal = _exec_no_callback("VACUUM");
+
+    if (not rowsKeys.empty())
+    {
+        if (sqlite3_prepare_v2(_pDb, "SELECT rowid FROM image WHERE node_id=? AND offset=? AND filename<>''", -1, &p_stmt, nullptr) != SQLITE_OK)
+        {
+            std::cerr << CtSQLite::ERR_SQLITE_PREPV2 << sqlite3_errmsg(_pDb) << std::endl;
+            return false;
+        }
+        std::unordered_map<gint64, gint64> newRowIds;
+        for (const auto& rowKey : rowsKeys)
+        {
+            sqlite3_bind_int64(p_stmt, 1, rowKey.second.first);
+            sqlite3_bind_int64(p_stmt, 2, rowKey.second.second);
+            if (SQLITE_ROW == sqlite3_step(p_stmt))
+            {
+                newRowIds[rowKey.first] = sqlite3_column_int64(p_stmt, 0);
+            }
+            sqlite3_reset(p_stmt);
+        }
+        sqlite3_finalize(p_stmt);
+        CtEmbFileBlob::on_db_rows_renumbered(_pDb, newRowIds);
+    }
+    return retVal;
+}
+
 bool CtSQLite::_write_db_node(CtTreeIter ct_tree_iter,
                               const gint64 sequence,
                               const gint64 node_father_id,
@@ -797,11 +993,13 @@ bool CtSQLite::_write_db_node(CtTreeIter ct_tree_iter,
         {
             node_txt = Glib::locale_from_utf8(ctXmlWrite.write_to_string());
             // anchored widgets
+            gint64 max_image_rowid{0};
             if (write_dict.upd)
             {
                 soFarSoGood = ( _exec_bind_int64(CtSQLite::TABLE_CODEBOX_DELETE, node_id) &&
-                                _exec_bind_int64(CtSQLite::TABLE_TABLE_DELETE, node_id) &&
-                                _exec_bind_int64(CtSQLite::TABLE_IMAGE_DELETE, node_id) );
+                                _exec_bind_int64(CtSQLite::TABLE_TABLE_DELETE, node_id) );
+                // the embedded files may be copied from the current rows, deleted once the new ones are written
+                max_image_rowid = _get_max_image_rowid();
             }
             if (soFarSoGood)
             {
@@ -812,6 +1010,13 @@ bool CtSQLite::_write_db_node(CtTreeIter ct_tree_iter,
                     {
                         break;
                     }
+                    if (CtExporting::No == exporting)
+                    {
+                        if (CtImageEmbFile* pImageEmbFile = dynamic_cast<CtImageEmbFile*>(pAnchoredWidget))
+                        {
+                            pImageEmbFile->get_raw_blob()->set_db_row(_spDb, sqlite3_last_insert_rowid(_pDb));
+                        }
+                    }
                     switch (pAnchoredWidget->get_type())
                     {
                         case CtAnchWidgType::CodeBox: has_codebox = true; break;
@@ -820,6 +1025,10 @@ bool CtSQLite::_write_db_node(CtTreeIter ct_tree_iter,
                     }
                 }
             }
+            if (soFarSoGood and write_dict.upd)
+            {
+                soFarSoGood = _remove_db_images(node_id, max_image_rowid);
+            }
         }
         else
         {
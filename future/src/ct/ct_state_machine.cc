@@ -22,11 +22,56 @@
 #include "ct_state_machine.h"
 #include "ct_main_win.h"
 #include "ct_doc_rw.h"
+#include "ct_p7za_iface.h"
+#include <algorithm>
+
+// Blobs
+std::unordered_multimap<std::string, std::shared_ptr<CtEmbFileBlob>> CtStateBlobPool::_blobs;
+
+std::shared_ptr<CtEmbFileBlob> CtStateBlobPool::get_blob(std::shared_ptr<CtEmbFileBlob> blob)
+{
+    const std::string& checksum = blob->get_checksum();
+    auto range = _blobs.equal_range(checksum);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == blob)
+            return blob;
+    }
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second->size() == blob->size() and it->second->read_all() == blob->read_all())
+            return it->second;
+    }
+    _blobs.emplace(checksum, blob);
+    return blob;
+}
+
+void CtStateBlobPool::purge()
+{
+    for (auto it = _blobs.begin(); it != _blobs.end(); )
+    {
+        if (1 == it->second.use_count())
+        {
+            it = _blobs.erase(it);
+        }
+        else ++it;
+    }
+}
+
+size_t CtStateBlobPool::get_memory_size()
+{
+    size_t memorySize{0};
+    for (const auto& checksumBlob : _blobs)
+    {
+        memorySize += checksumBlob.second->get_memory_size();
+    }
+    return memorySize;
+}
 
 // ImagePng
 CtAnchoredWidgetState_ImagePng::CtAnchoredWidgetState_ImagePng(CtImagePng* image)
     :CtAnchoredWidgetState(image->getOffset(), image->getJustification()),
-      link(image->get_link()), pixbuf(image->get_pixbuf()->copy())
+      link(image->get_link()), rawBlob(image->get_raw_blob_future()), rawBlobId(image->get_raw_blob_id())
 {
 
 }
@@ -34,15 +79,24 @@ CtAnchoredWidgetState_ImagePng::CtAnchoredWidgetState_ImagePng(CtImagePng* image
 bool CtAnchoredWidgetState_ImagePng::equal(std::shared_ptr<CtAnchoredWidgetState> state)
 {
     CtAnchoredWidgetState_ImagePng* other_state = dynamic_cast<CtAnchoredWidgetState_ImagePng*>(state.get());
-    return other_state && charOffset == other_state->charOffset && justification == other_state->justification &&
-            link == other_state->link &&
-            pixbuf->get_byte_length() == other_state->pixbuf->get_byte_length() &&
-            memcmp(pixbuf->get_pixels(), other_state->pixbuf->get_pixels(), pixbuf->get_byte_length() * sizeof(guint8));
+    if (not other_state or charOffset != other_state->charOffset or justification != other_state->justification or
+        link != other_state->link)
+        return false;
+    if (rawBlobId == other_state->rawBlobId)
+        return true;
+    // the bytes are compared only if both are already encoded, an encoding under way is not waited for
+    auto is_ready = [](const std::shared_future<std::string>& blob){ return std::future_status::ready == blob.wait_for(std::chrono::seconds(0)); };
+    return is_ready(rawBlob) and is_ready(other_state->rawBlob) and rawBlob.get() == other_state->rawBlob.get();
 }
 
 CtAnchoredWidget* CtAnchoredWidgetState_ImagePng::to_widget(CtMainWin* pCtMainWin)
 {
-    return new CtImagePng(pCtMainWin, pixbuf->copy(), link, charOffset, justification);
+    return new CtImagePng(pCtMainWin, rawBlob, link, charOffset, justification, rawBlobId);
+}
+
+size_t CtAnchoredWidgetState_ImagePng::get_memory_size() const
+{
+    return sizeof(*this) + justification.size() + link.bytes();
 }
 
 // ImageAnchor
@@ -65,10 +119,15 @@ CtAnchoredWidget* CtAnchoredWidgetState_Anchor::to_widget(CtMainWin* pCtMainWin)
     return new CtImageAnchor(pCtMainWin, name, charOffset, justification);
 }
 
+size_t CtAnchoredWidgetState_Anchor::get_memory_size() const
+{
+    return sizeof(*this) + justification.size() + name.bytes();
+}
+
 // ImageEmbFile
 CtAnchoredWidgetState_EmbFile::CtAnchoredWidgetState_EmbFile(CtImageEmbFile* embFile)
     :CtAnchoredWidgetState(embFile->getOffset(), embFile->getJustification()),
-      fileName(embFile->get_file_name()), rawBlob(embFile->get_raw_blob()), timeSeconds(embFile->get_time())
+      fileName(embFile->get_file_name()), rawBlob(CtStateBlobPool::get_blob(embFile->get_raw_blob())), timeSeconds(embFile->get_time())
 {
 
 }
@@ -77,7 +136,7 @@ bool CtAnchoredWidgetState_EmbFile::equal(std::shared_ptr<CtAnchoredWidgetState>
 {
     CtAnchoredWidgetState_EmbFile* other_state = dynamic_cast<CtAnchoredWidgetState_EmbFile*>(state.get());
     return other_state && charOffset == other_state->charOffset && justification == other_state->justification &&
-            fileName == other_state->fileName && rawBlob == other_state->rawBlob && timeSeconds == other_state->timeSeconds;
+            fileName == other_state->fileName && rawBlob == other_state->rawBlob /*pooled by content*/ && timeSeconds == other_state->timeSeconds;
 }
 
 CtAnchoredWidget* CtAnchoredWidgetState_EmbFile::to_widget(CtMainWin* pCtMainWin)
@@ -85,6 +144,11 @@ CtAnchoredWidget* CtAnchoredWidgetState_EmbFile::to_widget(CtMainWin* pCtMainWin
     return new CtImageEmbFile(pCtMainWin, fileName, rawBlob, timeSeconds, charOffset, justification);
 }
 
+size_t CtAnchoredWidgetState_EmbFile::get_memory_size() const
+{
+    return sizeof(*this) + justification.size() + fileName.bytes();
+}
+
 // Codebox
 CtAnchoredWidgetState_Codebox::CtAnchoredWidgetState_Codebox(CtCodebox* codebox)
     :CtAnchoredWidgetState(codebox->getOffset(), codebox->getJustification()),
@@ -108,15 +172,16 @@ CtAnchoredWidget* CtAnchoredWidgetState_Codebox::to_widget(CtMainWin* pCtMainWin
                          charOffset, justification, widthInPixels, brackets, showNum);
 }
 
+size_t CtAnchoredWidgetState_Codebox::get_memory_size() const
+{
+    return sizeof(*this) + justification.size() + content.bytes() + syntax.bytes();
+}
+
 // Table
 CtAnchoredWidgetState_Table::CtAnchoredWidgetState_Table(CtTable* table)
-    :CtAnchoredWidgetState(table->getOffset(), table->getJustification()), colMin(table->get_col_min()), colMax(table->get_col_max())
+    :CtAnchoredWidgetState(table->getOffset(), table->getJustification()), colMin(table->get_col_min()), colMax(table->get_col_max()),
+     rows(table->get_table_matrix())
 {
-    for (auto& row: table->get_table_matrix())
-    {
-        rows.push_back(std::vector<Glib::ustring>());
-        for (auto& cell: row)  rows.back().push_back(cell->get_text_content());
-    }
 }
 
 bool CtAnchoredWidgetState_Table::equal(std::shared_ptr<CtAnchoredWidgetState> state)
@@ -128,18 +193,82 @@ bool CtAnchoredWidgetState_Table::equal(std::shared_ptr<CtAnchoredWidgetState> s
 
 CtAnchoredWidget* CtAnchoredWidgetState_Table::to_widget(CtMainWin* pCtMainWin)
 {
-    CtTableMatrix tableMatrix;
-    for (auto& row: rows)
+    return new CtTable(pCtMainWin, rows, colMin, colMax, true, charOffset, justification);
+}
+
+size_t CtAnchoredWidgetState_Table::get_memory_size() const
+{
+    size_t size = sizeof(*this) + justification.size();
+    for (const auto& row: rows)
+    {
+        size += sizeof(row);
+        for (const auto& cell: row) size += sizeof(cell) + cell.bytes();
+    }
+    return size;
+}
+
+// Node full state
+std::string CtNodeState::get_buffer_xml() const
+{
+    if (not compressed) return bufferXml;
+    std::string buffer_xml;
+    CtP7zaIface::lzma_decompress(bufferXml, buffer_xml);
+    return buffer_xml;
+}
+
+void CtNodeState::compress()
+{
+    if (compressed) return;
+    std::string compressedXml;
+    if (CtP7zaIface::lzma_compress(bufferXml, compressedXml) and compressedXml.size() < bufferXml.size())
     {
-        tableMatrix.push_back(CtTableRow());
-        for (auto& cell: row) tableMatrix.back().push_back(new CtTableCell(pCtMainWin, cell, CtConst::TABLE_CELL_TEXT_ID));
+        bufferXml.swap(compressedXml);
+        bufferXml.shrink_to_fit();
+        compressed = true;
     }
-    return new CtTable(pCtMainWin, tableMatrix, colMin, colMax, true, charOffset, justification);
+}
+
+size_t CtNodeState::get_memory_size() const
+{
+    size_t size = sizeof(*this) + bufferXml.capacity();
+    for (const auto& widgetState : widgetStates)
+        size += widgetState->get_memory_size();
+    return size;
 }
 
 
 
 //
+static const gunichar OBJ_REPLACEMENT_CHAR{0xFFFC}; // in place of the widgets in a buffer slice
+
+size_t CtStateMachine::_nodesMemorySize{0};
+
+static size_t get_step_memory_size(const CtNodeStep& step)
+{
+    size_t size = sizeof(step);
+    for (const CtBufferOp& op : step.ops)
+    {
+        size += sizeof(op) + op.text.bytes() + op.tagName.bytes();
+        for (const CtTagRun& tagRun : op.tagRuns)
+            size += sizeof(tagRun) + tagRun.tagName.bytes();
+    }
+    for (const auto& widgetChange : step.widgetChanges)
+        size += widgetChange.first->get_memory_size() + widgetChange.second->get_memory_size();
+    if (step.snapshot)
+        size += step.snapshot->get_memory_size();
+    return size;
+}
+
+bool CtStateMachine::is_rich_text_tag(const Glib::ustring& tagName)
+{
+    for (const gchar* tagProperty : CtConst::TAG_PROPERTIES)
+    {
+        if (str::startswith(tagName, std::string{tagProperty} + "_"))
+            return true;
+    }
+    return false;
+}
+
 CtStateMachine::CtStateMachine(CtMainWin *pCtMainWin) : _pCtMainWin(pCtMainWin)
 {
     _word_regex = Glib::Regex::create("\\w");
@@ -148,12 +277,20 @@ CtStateMachine::CtStateMachine(CtMainWin *pCtMainWin) : _pCtMainWin(pCtMainWin)
     _visited_nodes_idx = -1;
 }
 
+CtStateMachine::~CtStateMachine()
+{
+    reset();
+}
+
 // State Machine Reset
 void CtStateMachine::reset()
 {
     _visited_nodes_list.clear();
     _visited_nodes_idx = -1;
+    for (const auto& node_states : _node_states)
+        _forget_node_memory(node_states.second);
     _node_states.clear();
+    CtStateBlobPool::purge();
 }
 
 // Requested the Previous Visited Node
@@ -190,21 +327,26 @@ void CtStateMachine::node_selected_changed(gint64 node_id)
         _visited_nodes_list.push_back(node_id);
         _visited_nodes_idx = _visited_nodes_list.size() - 1;
     }
-    if (!map::exists(_node_states, node_id))
+    if (!map::exists(_node_states, node_id) || _node_states[node_id].steps.empty())
     {
         auto node = _pCtMainWin->curr_tree_iter();
-        auto state = std::shared_ptr<CtNodeState>(new CtNodeState());
-        state->buffer_xml.append_node_buffer(node, state->buffer_xml.get_root_node(), false/*no widgets */);
-        state->buffer_xml_string = state->buffer_xml.write_to_string();
-        for (auto widget: node.get_embedded_pixbufs_tables_codeboxes())
-            state->widgetStates.push_back(widget->get_state());
-        state->cursor_pos = 0;
-
-        CtNodeStates states;
-        states.states.push_back(state);
+        CtNodeStep step;
+        step.snapshot = get_node_snapshot(node);
+        step.snapshot->cursor_pos = 0;
+        step.charCount = node.get_node_text_buffer()->get_char_count();
+
+        CtNodeStates& states = _node_states[node_id];
+        states.widgetStates = step.snapshot->widgetStates;
+        states.steps.push_back(std::move(step));
         states.index = 0;     // first state
         states.indicator = 0; // the current buffer state is saved
-        _node_states.insert(std::make_pair(node_id, states));
+        _touch_node(states);
+        _update_node_memory(states);
+        _trim_memory(node);
+    }
+    else
+    {
+        _touch_node(_node_states[node_id]);
     }
 }
 
@@ -226,34 +368,109 @@ void CtStateMachine::text_variation(gint64 node_id, const Glib::ustring& varied_
         update_state();
 }
 
-// A Previous State, if Existing, is Requested
-std::shared_ptr<CtNodeState> CtStateMachine::requested_state_previous(gint64 node_id)
+// Insertion or Removal of text inside a widget (codebox) of the given node_id, before it happens
+void CtStateMachine::widget_text_variation(gint64 node_id, const Glib::ustring& varied_text)
 {
-    if (curr_index_is_last_index(node_id))
-        update_state();
-    if (_node_states[node_id].index > 0)
-        _node_states[node_id].index -= 1;
-    return _node_states[node_id].get_state();
+    _before_widgets_change(node_id, false/*anchors*/);
+    text_variation(node_id, varied_text);
+}
+
+// Record the changes of the node text buffer as operations
+std::list<sigc::connection> CtStateMachine::track_node_buffer(gint64 node_id, Glib::RefPtr<Gtk::TextBuffer> rTextBuffer)
+{
+    // connected before the default handlers, while the buffer still has the text and tags to be changed
+    std::list<sigc::connection> connections;
+    connections.push_back(rTextBuffer->signal_insert().connect([this, node_id](const Gtk::TextIter& pos, const Glib::ustring& text, int /*bytes*/)
+    {
+        _on_buffer_insert(node_id, pos, text);
+    }, false/*after*/));
+    connections.push_back(rTextBuffer->signal_erase().connect([this, node_id](const Gtk::TextIter& range_start, const Gtk::TextIter& range_end)
+    {
+        _on_buffer_erase(node_id, range_start, range_end);
+    }, false/*after*/));
+    connections.push_back(rTextBuffer->signal_apply_tag().connect([this, node_id](const Glib::RefPtr<Gtk::TextTag>& rTextTag, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end)
+    {
+        _on_buffer_tag(node_id, rTextTag, range_start, range_end, true/*apply*/);
+    }, false/*after*/));
+    connections.push_back(rTextBuffer->signal_remove_tag().connect([this, node_id](const Glib::RefPtr<Gtk::TextTag>& rTextTag, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end)
+    {
+        _on_buffer_tag(node_id, rTextTag, range_start, range_end, false/*apply*/);
+    }, false/*after*/));
+    connections.push_back(rTextBuffer->signal_insert_child_anchor().connect([this, node_id](const Gtk::TextIter& /*pos*/, const Glib::RefPtr<Gtk::TextChildAnchor>& /*rChildAnchor*/)
+    {
+        _before_widgets_change(node_id, true/*anchors*/);
+    }, false/*after*/));
+    return connections;
+}
+
+// A Previous State, if Existing, is Loaded
+bool CtStateMachine::requested_step_back(CtTreeIter tree_iter)
+{
+    if (_not_undoable_timeslot) return false; // the changes under way are not recorded yet
+    const gint64 node_id = tree_iter.get_node_id();
+    if (not map::exists(_node_states, node_id)) return false;
+    CtNodeStates& node_states = _node_states[node_id];
+    if (curr_index_is_last_index(node_id) or not node_states.pendingOps.empty() or node_states.pendingAnchors)
+        update_state(tree_iter);
+    if (node_states.index <= 0)
+        return false;
+    const CtNodeStep& step = node_states.steps[node_states.index];
+    const int target_index = node_states.index - 1;
+    if (step.byOps and tree_iter.get_node_text_buffer()->get_char_count() == step.charCount)
+        _apply_ops(tree_iter, step, false/*forward*/);
+    else if (not _load_step(tree_iter, node_states, target_index))
+        return false;
+    node_states.index = target_index;
+    _touch_node(node_states);
+    _after_step_loaded(tree_iter, node_states.steps[target_index].cursorPos);
+    return true;
 }
 
-// The current state is requested
-std::shared_ptr<CtNodeState> CtStateMachine::requested_state_current(gint64 node_id)
+// A Subsequent State, if Existing, is Loaded
+bool CtStateMachine::requested_step_ahead(CtTreeIter tree_iter)
 {
-    return _node_states[node_id].get_state();
+    if (_not_undoable_timeslot) return false; // the changes under way are not recorded yet
+    const gint64 node_id = tree_iter.get_node_id();
+    if (not map::exists(_node_states, node_id)) return false;
+    CtNodeStates& node_states = _node_states[node_id];
+    if (not node_states.pendingOps.empty() or node_states.pendingAnchors)
+        update_state(tree_iter); // the subsequent states are dropped
+    if (curr_index_is_last_index(node_id))
+        return false;
+    const CtNodeStep& step = node_states.steps[node_states.index + 1];
+    const int target_index = node_states.index + 1;
+    if (step.byOps and tree_iter.get_node_text_buffer()->get_char_count() == node_states.steps[node_states.index].charCount)
+        _apply_ops(tree_iter, step, true/*forward*/);
+    else if (not _load_step(tree_iter, node_states, target_index))
+        return false;
+    node_states.index = target_index;
+    _touch_node(node_states);
+    _after_step_loaded(tree_iter, node_states.steps[target_index].cursorPos);
+    return true;
 }
 
-// A Subsequent State, if Existing, is Requested
-std::shared_ptr<CtNodeState> CtStateMachine::requested_state_subsequent(gint64 node_id)
+// Full state of the given node
+std::shared_ptr<CtNodeState> CtStateMachine::get_node_snapshot(CtTreeIter tree_iter)
 {
-    if (_node_states[node_id].index < (int)_node_states[node_id].states.size()-1)
-        _node_states[node_id].index += 1;
-    return _node_states[node_id].get_state();
+    auto state = std::shared_ptr<CtNodeState>(new CtNodeState());
+    CtXmlWrite buffer_xml("buffer");
+    buffer_xml.append_node_buffer(tree_iter, buffer_xml.get_root_node(), false/*no widgets*/);
+    state->bufferXml = buffer_xml.write_to_string();
+    for (auto widget: tree_iter.get_embedded_pixbufs_tables_codeboxes())
+        state->widgetStates.push_back(widget->get_state());
+    state->cursor_pos = tree_iter.get_node_text_buffer()->property_cursor_position();
+    return state;
 }
 
 // Delete the states for the given node_id
 void CtStateMachine::delete_states(gint64 node_id)
 {
-    _node_states.erase(node_id);
+    auto it = _node_states.find(node_id);
+    if (it != _node_states.end())
+    {
+        _forget_node_memory(it->second);
+        _node_states.erase(it);
+    }
     if (vec::exists(_visited_nodes_list, node_id))
     {
         vec::remove(_visited_nodes_list, node_id);
@@ -265,7 +482,7 @@ void CtStateMachine::delete_states(gint64 node_id)
 bool CtStateMachine::curr_index_is_last_index(gint64 node_id)
 {
     int curr_index = _node_states[node_id].index;
-    int last_index = _node_states[node_id].states.size() - 1;
+    int last_index = _node_states[node_id].steps.size() - 1;
     return curr_index == last_index;
 }
 
@@ -292,44 +509,462 @@ void CtStateMachine::update_state(CtTreeIter tree_iter)
         return;
     gint64 node_id = tree_iter.get_node_id();
     auto& node_states = _node_states[node_id];
-    if (!curr_index_is_last_index(node_id))
+    Glib::RefPtr<Gsv::Buffer> rTextBuffer = tree_iter.get_node_text_buffer();
+    if (node_states.steps.empty())
     {
-        node_states.states.erase(node_states.states.begin() + node_states.index + 1, node_states.states.end());
+        CtNodeStep step;
+        step.snapshot = get_node_snapshot(tree_iter);
+        _push_step(tree_iter, node_states, std::move(step));
+        return;
     }
 
-    auto new_state = std::shared_ptr<CtNodeState>(new CtNodeState());
-    new_state->buffer_xml.append_node_buffer(tree_iter, new_state->buffer_xml.get_root_node(), false/*no widgets*/);
-    new_state->buffer_xml_string = new_state->buffer_xml.write_to_string();
-    for (auto widget: tree_iter.get_embedded_pixbufs_tables_codeboxes())
-        new_state->widgetStates.push_back(widget->get_state());
-    new_state->cursor_pos = tree_iter.get_node_text_buffer()->property_cursor_position();
-
-    if (node_states.states.size() > 0)
-    {
-        auto compare_widgets = [](const std::list<std::shared_ptr<CtAnchoredWidgetState>> lhs, const std::list<std::shared_ptr<CtAnchoredWidgetState>> rhs) {
-            return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](std::shared_ptr<CtAnchoredWidgetState> lhs, std::shared_ptr<CtAnchoredWidgetState> rhs) {
-                return lhs->equal(rhs);
-            });
-        };
-        auto last_state = node_states.states.back();
-        if (new_state->buffer_xml_string == last_state->buffer_xml_string && compare_widgets(new_state->widgetStates, last_state->widgetStates))
+    std::list<std::shared_ptr<CtAnchoredWidgetState>> widgetStates;
+    bool widgetsChanged{false};
+    bool widgetsAligned{false};
+    if (node_states.widgetsVaried or (node_states.pendingOps.empty() and not node_states.pendingAnchors))
+    {
+        for (auto widget: tree_iter.get_embedded_pixbufs_tables_codeboxes())
+            widgetStates.push_back(widget->get_state());
+        widgetsAligned = widgetStates.size() == node_states.widgetStates.size();
+        for (auto itNew = widgetStates.begin(), itOld = node_states.widgetStates.begin();
+             widgetsAligned and itNew != widgetStates.end(); ++itNew, ++itOld)
         {
-            last_state->cursor_pos = new_state->cursor_pos;
-            return; // #print "update_state not needed"
+            widgetsAligned = (*itNew)->charOffset == (*itOld)->charOffset;
+            if (not (*itNew)->equal(*itOld)) widgetsChanged = true;
         }
+        if (not widgetsAligned) widgetsChanged = true;
+    }
+    if (node_states.pendingOps.empty() and not node_states.pendingAnchors and not widgetsChanged)
+    {
+        node_states.widgetsVaried = false;
+        if (not curr_index_is_last_index(node_id))
+        {
+            node_states.steps.erase(node_states.steps.begin() + node_states.index + 1, node_states.steps.end());
+            _update_node_memory(node_states);
+        }
+        node_states.steps.back().cursorPos = rTextBuffer->property_cursor_position();
+        return; // #print "update_state not needed"
     }
 
-    node_states.states.push_back(new_state);
-    while ((int)node_states.states.size() > _pCtMainWin->get_ct_config()->limitUndoableSteps)
-        node_states.states.erase(node_states.states.begin());
-    node_states.index = node_states.states.size() - 1;
-    node_states.indicator = 0; // the current buffer state is saved
+    CtNodeStep step;
+    if (not node_states.pendingAnchors and widgetsChanged and widgetsAligned and node_states.pendingOps.empty())
+    {
+        // widgets content only, replaced one by one
+        step.byOps = true;
+        for (auto itNew = widgetStates.begin(), itOld = node_states.widgetStates.begin(); itNew != widgetStates.end(); ++itNew, ++itOld)
+            if (not (*itNew)->equal(*itOld))
+                step.widgetChanges.push_back(std::make_pair(*itOld, *itNew));
+        node_states.widgetStates = widgetStates;
+    }
+    else if (node_states.pendingAnchors or widgetsChanged)
+    {
+        // widgets added or removed, or mixed up with the text changes
+        step.snapshot = get_node_snapshot(tree_iter);
+    }
+    else
+    {
+        step.byOps = true;
+        step.ops.swap(node_states.pendingOps);
+    }
+    _push_step(tree_iter, node_states, std::move(step));
 }
 
 // If the buffer is still not modified update cursor pos
 void CtStateMachine::update_curr_state_cursor_pos(gint64 node_id)
 {
     if (!map::exists(_node_states, node_id)) return;
+    if (_node_states[node_id].steps.empty()) return;
     int cursor_pos = _pCtMainWin->curr_buffer()->property_cursor_position();
-    _node_states[node_id].get_state()->cursor_pos = cursor_pos;
+    _node_states[node_id].steps[_node_states[node_id].index].cursorPos = cursor_pos;
+}
+
+// The states of the node if its buffer changes are to be recorded
+CtNodeStates* CtStateMachine::_get_tracked_states(gint64 node_id)
+{
+    if (_applying_step) return nullptr;
+    auto it = _node_states.find(node_id);
+    if (it == _node_states.end() or it->second.steps.empty()) return nullptr;
+    if (it->second.pendingAnchors) return nullptr; // the step will be a full state anyway
+    return &it->second;
+}
+
+// Tags of the rich text over the given range, or just where the given tag is
+static std::vector<CtTagRun> get_tag_runs(const Gtk::TextIter& range_start, const Gtk::TextIter& range_end, Glib::RefPtr<Gtk::TextTag> rFilterTag)
+{
+    std::vector<CtTagRun> tagRuns;
+    Gtk::TextIter curr_iter = range_start;
+    while (curr_iter < range_end)
+    {
+        Gtk::TextIter next_iter = curr_iter;
+        if (not next_iter.forward_to_tag_toggle(rFilterTag) or next_iter > range_end)
+            next_iter = range_end;
+        for (const Glib::RefPtr<Gtk::TextTag>& rTextTag : curr_iter.get_tags())
+        {
+            if (rFilterTag ? rTextTag != rFilterTag : not CtStateMachine::is_rich_text_tag(rTextTag->property_name()))
+                continue;
+            const Glib::ustring tagName = rTextTag->property_name();
+            auto itRun = std::find_if(tagRuns.rbegin(), tagRuns.rend(), [&tagName](const CtTagRun& tagRun){ return tagRun.tagName == tagName; });
+            if (itRun != tagRuns.rend() and itRun->endOffset == curr_iter.get_offset())
+                itRun->endOffset = next_iter.get_offset();
+            else
+                tagRuns.push_back(CtTagRun{curr_iter.get_offset(), next_iter.get_offset(), tagName});
+        }
+        curr_iter = next_iter;
+    }
+    return tagRuns;
+}
+
+void CtStateMachine::_on_buffer_insert(gint64 node_id, const Gtk::TextIter& pos, const Glib::ustring& text)
+{
+    CtNodeStates* pNodeStates = _get_tracked_states(node_id);
+    if (not pNodeStates) return;
+    record_insert(pNodeStates->pendingOps, pos, text);
+}
+
+void CtStateMachine::_on_buffer_erase(gint64 node_id, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end)
+{
+    CtNodeStates* pNodeStates = _get_tracked_states(node_id);
+    if (not pNodeStates) return;
+    if (not record_erase(pNodeStates->pendingOps, range_start, range_end))
+        _before_widgets_change(node_id, true/*anchors*/);
+}
+
+void CtStateMachine::_on_buffer_tag(gint64 node_id, const Glib::RefPtr<Gtk::TextTag>& rTextTag,
+                                    const Gtk::TextIter& range_start, const Gtk::TextIter& range_end, bool apply)
+{
+    if (not is_rich_text_tag(rTextTag->property_name())) return; // syntax highlighting, spell check...
+    CtNodeStates* pNodeStates = _get_tracked_states(node_id);
+    if (not pNodeStates) return;
+    record_tag(pNodeStates->pendingOps, rTextTag, range_start, range_end, apply);
+}
+
+// Append a buffer change to the operations, merged with the latest one where they add up or cancel out
+void CtStateMachine::record_insert(std::vector<CtBufferOp>& ops, const Gtk::TextIter& pos, const Glib::ustring& text)
+{
+    const int start_offset = pos.get_offset();
+    if (not ops.empty())
+    {
+        CtBufferOp& lastOp = ops.back();
+        if (CtBufferOp::Type::Insert == lastOp.type and lastOp.endOffset == start_offset)
+        {
+            // typing goes on
+            lastOp.text += text;
+            lastOp.endOffset += text.size();
+            return;
+        }
+    }
+    ops.push_back(CtBufferOp{CtBufferOp::Type::Insert, start_offset, start_offset + (int)text.size(), text, "", {}});
+}
+
+// false if the range holds widgets, not recorded as text
+bool CtStateMachine::record_erase(std::vector<CtBufferOp>& ops, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end)
+{
+    const Glib::ustring text = range_start.get_slice(range_end);
+    if (text.find(OBJ_REPLACEMENT_CHAR) != Glib::ustring::npos)
+        return false;
+    const int start_offset = range_start.get_offset();
+    const int end_offset = range_end.get_offset();
+    if (not ops.empty())
+    {
+        CtBufferOp& lastOp = ops.back();
+        if (CtBufferOp::Type::Insert == lastOp.type and lastOp.endOffset == end_offset and lastOp.startOffset <= start_offset)
+        {
+            // the tail of the latest insertion is erased, as a temporary insertion or a backspace while typing
+            lastOp.text.erase(start_offset - lastOp.startOffset);
+            lastOp.endOffset = start_offset;
+            if (lastOp.text.empty())
+                ops.pop_back();
+            return true;
+        }
+    }
+    ops.push_back(CtBufferOp{CtBufferOp::Type::Erase, start_offset, end_offset,
+                             text, "", get_tag_runs(range_start, range_end, Glib::RefPtr<Gtk::TextTag>{})});
+    return true;
+}
+
+void CtStateMachine::record_tag(std::vector<CtBufferOp>& ops, const Glib::RefPtr<Gtk::TextTag>& rTextTag,
+                                const Gtk::TextIter& range_start, const Gtk::TextIter& range_end, bool apply)
+{
+    const Glib::ustring tagName = rTextTag->property_name();
+    if (not apply and not ops.empty())
+    {
+        const CtBufferOp& lastOp = ops.back();
+        if (CtBufferOp::Type::TagApply == lastOp.type and lastOp.tagName == tagName and lastOp.tagRuns.empty() and
+            lastOp.startOffset == range_start.get_offset() and lastOp.endOffset == range_end.get_offset())
+        {
+            // the tag just applied where it was not is removed again
+            ops.pop_back();
+            return;
+        }
+    }
+    ops.push_back(CtBufferOp{apply ? CtBufferOp::Type::TagApply : CtBufferOp::Type::TagRemove,
+                             range_start.get_offset(), range_end.get_offset(),
+                             "", tagName, get_tag_runs(range_start, range_end, rTextTag)});
+}
+
+// Called before widgets are inserted, removed or edited: the text changes so far get their own step
+// and the widgets as they are now are kept to compare with
+void CtStateMachine::_before_widgets_change(gint64 node_id, bool anchors)
+{
+    CtNodeStates* pNodeStates = _get_tracked_states(node_id);
+    if (not pNodeStates) return;
+    if (anchors ? pNodeStates->pendingAnchors : pNodeStates->widgetsVaried) return;
+    CtTreeIter tree_iter = _pCtMainWin->curr_tree_iter();
+    if (not tree_iter or tree_iter.get_node_id() != node_id) return;
+    if (not pNodeStates->pendingOps.empty())
+        _push_ops_step(tree_iter, *pNodeStates);
+    if (anchors)
+    {
+        // the widgets removal or insertion is undone loading the full state before it
+        CtNodeStep& curr_step = pNodeStates->steps[pNodeStates->index];
+        if (not curr_step.snapshot)
+        {
+            curr_step.snapshot = get_node_snapshot(tree_iter);
+            _update_node_memory(*pNodeStates);
+        }
+        pNodeStates->pendingAnchors = true;
+    }
+    else
+    {
+        pNodeStates->widgetStates.clear();
+        for (auto widget: tree_iter.get_embedded_pixbufs_tables_codeboxes())
+            pNodeStates->widgetStates.push_back(widget->get_state());
+        pNodeStates->widgetsVaried = true;
+    }
+}
+
+void CtStateMachine::_push_step(CtTreeIter tree_iter, CtNodeStates& node_states, CtNodeStep&& step)
+{
+    Glib::RefPtr<Gsv::Buffer> rTextBuffer = tree_iter.get_node_text_buffer();
+    if (not node_states.steps.empty() and not curr_index_is_last_index(tree_iter.get_node_id()))
+    {
+        node_states.steps.erase(node_states.steps.begin() + node_states.index + 1, node_states.steps.end());
+    }
+    if (step.byOps and not step.snapshot and ++node_states.opsStepsSinceSnapshot >= CHECKPOINT_STEPS)
+    {
+        // checkpoint, bounds the operations to replay when a full state must be loaded
+        step.snapshot = get_node_snapshot(tree_iter);
+    }
+    if (step.snapshot)
+    {
+        node_states.opsStepsSinceSnapshot = 0;
+        node_states.widgetStates = step.snapshot->widgetStates;
+    }
+    step.cursorPos = rTextBuffer->property_cursor_position();
+    step.charCount = rTextBuffer->get_char_count();
+    node_states.steps.push_back(std::move(step));
+    node_states.index = node_states.steps.size() - 1;
+    while ((int)node_states.steps.size() > _pCtMainWin->get_ct_config()->limitUndoableSteps and
+           erase_oldest_steps(node_states, [&](){ return get_node_snapshot(tree_iter); }))
+        ;
+    node_states.indicator = 0; // the current buffer state is saved
+    node_states.pendingOps.clear();
+    node_states.pendingAnchors = false;
+    node_states.widgetsVaried = false;
+    for (int i = 0; i < (int)node_states.steps.size() - UNCOMPRESSED_STEPS; ++i)
+    {
+        if (node_states.steps[i].snapshot)
+            node_states.steps[i].snapshot->compress();
+    }
+    _touch_node(node_states);
+    _update_node_memory(node_states);
+    _trim_memory(tree_iter);
+}
+
+void CtStateMachine::_push_ops_step(CtTreeIter tree_iter, CtNodeStates& node_states)
+{
+    CtNodeStep step;
+    step.byOps = true;
+    step.ops.swap(node_states.pendingOps);
+    const bool widgetsVaried = node_states.widgetsVaried;
+    _push_step(tree_iter, node_states, std::move(step));
+    node_states.widgetsVaried = widgetsVaried;
+}
+
+// Replay (forward) or revert the operations of the step on the node buffer
+void CtStateMachine::_apply_ops(CtTreeIter tree_iter, const CtNodeStep& step, bool forward)
+{
+    bool user_active_restore = _pCtMainWin->user_active();
+    _pCtMainWin->user_active() = false;
+    _applying_step = true;
+
+    Glib::RefPtr<Gsv::Buffer> rTextBuffer = tree_iter.get_node_text_buffer();
+    auto iter_at = [&rTextBuffer](int offset){ return rTextBuffer->get_iter_at_offset(offset); };
+    rTextBuffer->begin_not_undoable_action();
+    apply_ops(rTextBuffer, step.ops, forward);
+    std::list<CtAnchoredWidget*> widgets;
+    for (const auto& widgetChange : step.widgetChanges)
+    {
+        const std::shared_ptr<CtAnchoredWidgetState>& rWidgetState = forward ? widgetChange.second : widgetChange.first;
+        Gtk::TextIter anchor_iter = iter_at(rWidgetState->charOffset);
+        if (not anchor_iter.get_child_anchor())
+        {
+            std::cerr << "!! missing widget at offset " << rWidgetState->charOffset << std::endl;
+            continue;
+        }
+        Gtk::TextIter anchor_end = anchor_iter;
+        anchor_end.forward_char();
+        rTextBuffer->erase(anchor_iter, anchor_end);
+        CtAnchoredWidget* pWidget = rWidgetState->to_widget(_pCtMainWin);
+        pWidget->insertInTextBuffer(rTextBuffer);
+        widgets.push_back(pWidget);
+    }
+    if (not widgets.empty())
+        _pCtMainWin->curr_tree_store().addAnchoredWidgets(tree_iter, widgets, &_pCtMainWin->get_text_view());
+    rTextBuffer->end_not_undoable_action();
+
+    CtNodeStates& node_states = _node_states[tree_iter.get_node_id()];
+    if (not step.widgetChanges.empty())
+    {
+        node_states.widgetStates.clear();
+        for (auto widget: tree_iter.get_embedded_pixbufs_tables_codeboxes())
+            node_states.widgetStates.push_back(widget->get_state());
+    }
+    _applying_step = false;
+    _pCtMainWin->user_active() = user_active_restore;
+}
+
+// Replay (forward) or revert the operations on the buffer text and rich text tags
+void CtStateMachine::apply_ops(Glib::RefPtr<Gtk::TextBuffer> rTextBuffer, const std::vector<CtBufferOp>& ops, bool forward)
+{
+    auto iter_at = [&rTextBuffer](int offset){ return rTextBuffer->get_iter_at_offset(offset); };
+    auto apply_tag_runs = [&](const std::vector<CtTagRun>& tagRuns) {
+        for (const CtTagRun& tagRun : tagRuns)
+            rTextBuffer->apply_tag_by_name(tagRun.tagName, iter_at(tagRun.startOffset), iter_at(tagRun.endOffset));
+    };
+    if (forward)
+    {
+        for (const CtBufferOp& op : ops)
+        {
+            switch (op.type)
+            {
+                case CtBufferOp::Type::Insert: rTextBuffer->insert(iter_at(op.startOffset), op.text); break;
+                case CtBufferOp::Type::Erase: rTextBuffer->erase(iter_at(op.startOffset), iter_at(op.endOffset)); break;
+                case CtBufferOp::Type::TagApply: rTextBuffer->apply_tag_by_name(op.tagName, iter_at(op.startOffset), iter_at(op.endOffset)); break;
+                case CtBufferOp::Type::TagRemove: rTextBuffer->remove_tag_by_name(op.tagName, iter_at(op.startOffset), iter_at(op.endOffset)); break;
+            }
+        }
+    }
+    else
+    {
+        for (auto itOp = ops.rbegin(); itOp != ops.rend(); ++itOp)
+        {
+            const CtBufferOp& op = *itOp;
+            switch (op.type)
+            {
+                case CtBufferOp::Type::Insert:
+                    rTextBuffer->erase(iter_at(op.startOffset), iter_at(op.endOffset));
+                    break;
+                case CtBufferOp::Type::Erase:
+                    rTextBuffer->insert(iter_at(op.startOffset), op.text);
+                    apply_tag_runs(op.tagRuns);
+                    break;
+                case CtBufferOp::Type::TagApply:
+                    rTextBuffer->remove_tag_by_name(op.tagName, iter_at(op.startOffset), iter_at(op.endOffset));
+                    apply_tag_runs(op.tagRuns);
+                    break;
+                case CtBufferOp::Type::TagRemove:
+                    apply_tag_runs(op.tagRuns);
+                    break;
+            }
+        }
+    }
+}
+
+// Load the full state at or before the target step, then replay the operations up to it
+bool CtStateMachine::_load_step(CtTreeIter tree_iter, CtNodeStates& node_states, int target_index)
+{
+    int snapshot_index = target_index;
+    while (snapshot_index >= 0 and not node_states.steps[snapshot_index].snapshot)
+        --snapshot_index;
+    if (snapshot_index < 0)
+    {
+        std::cerr << "!! no state to load for node " << tree_iter.get_node_id() << std::endl;
+        return false;
+    }
+    _applying_step = true;
+    _pCtMainWin->load_buffer_from_state(node_states.steps[snapshot_index].snapshot, tree_iter);
+    _applying_step = false;
+    node_states.widgetStates = node_states.steps[snapshot_index].snapshot->widgetStates;
+    for (int i = snapshot_index + 1; i <= target_index; ++i)
+        _apply_ops(tree_iter, node_states.steps[i], true/*forward*/);
+    return true;
+}
+
+void CtStateMachine::_after_step_loaded(CtTreeIter tree_iter, int cursor_pos)
+{
+    Glib::RefPtr<Gsv::Buffer> rTextBuffer = tree_iter.get_node_text_buffer();
+    CtNodeStates& node_states = _node_states[tree_iter.get_node_id()];
+    node_states.pendingOps.clear();
+    node_states.pendingAnchors = false;
+    node_states.widgetsVaried = false;
+
+    bool user_active_restore = _pCtMainWin->user_active();
+    _pCtMainWin->user_active() = false;
+    rTextBuffer->set_modified(false);
+    rTextBuffer->place_cursor(rTextBuffer->get_iter_at_offset(cursor_pos));
+    _pCtMainWin->get_text_view().scroll_to(rTextBuffer->get_insert(), CtTextView::TEXT_SCROLL_MARGIN);
+    _pCtMainWin->user_active() = user_active_restore;
+    _pCtMainWin->update_window_save_needed(CtSaveNeededUpdType::nbuf, false/*new_machine_state*/, &tree_iter);
+}
+
+void CtStateMachine::_update_node_memory(CtNodeStates& node_states)
+{
+    size_t size{0};
+    for (const CtNodeStep& step : node_states.steps)
+        size += get_step_memory_size(step);
+    _nodesMemorySize -= node_states.memorySize;
+    node_states.memorySize = size;
+    _nodesMemorySize += size;
+}
+
+// Drop the oldest steps of the node up to the next one with a full state, the first step must have one to load
+// the others from; the current step, if needed, gets its full state from the buffer it is in sync with
+bool CtStateMachine::erase_oldest_steps(CtNodeStates& node_states, std::function<std::shared_ptr<CtNodeState>()> get_snapshot)
+{
+    if (node_states.index <= 0)
+        return false;
+    int new_first = 1;
+    while (new_first < node_states.index and not node_states.steps[new_first].snapshot)
+        ++new_first;
+    CtNodeStep& new_first_step = node_states.steps[new_first];
+    if (not new_first_step.snapshot)
+    {
+        new_first_step.snapshot = get_snapshot();
+        new_first_step.snapshot->cursor_pos = new_first_step.cursorPos;
+    }
+    node_states.steps.erase(node_states.steps.begin(), node_states.steps.begin() + new_first);
+    node_states.index -= new_first;
+    return true;
+}
+
+// Keep the undo states within the memory limit, dropping first the states of the least recently used nodes
+// (created again when they are selected) and last the oldest steps of the given node
+void CtStateMachine::_trim_memory(CtTreeIter tree_iter)
+{
+    const size_t limit = (size_t)_pCtMainWin->get_ct_config()->limitUndoMemoryMb * 1024 * 1024;
+    const gint64 node_id = tree_iter.get_node_id();
+    CtStateBlobPool::purge();
+    while (get_memory_usage() > limit)
+    {
+        auto itLru = _node_states.end();
+        for (auto it = _node_states.begin(); it != _node_states.end(); ++it)
+        {
+            if (it->first != node_id and (itLru == _node_states.end() or it->second.lastUsed < itLru->second.lastUsed))
+                itLru = it;
+        }
+        if (itLru != _node_states.end())
+        {
+            _forget_node_memory(itLru->second);
+            _node_states.erase(itLru);
+        }
+        else
+        {
+            CtNodeStates& node_states = _node_states[node_id];
+            if (not erase_oldest_steps(node_states, [&](){ return get_node_snapshot(tree_iter); }))
+                break; // the current state is kept anyway
+            _update_node_memory(node_states);
+        }
+        CtStateBlobPool::purge();
+    }
 }
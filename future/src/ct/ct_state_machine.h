@@ -28,17 +28,33 @@
 #include "ct_table.h"
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <glibmm/regex.h>
 #include <memory>
+#include <functional>
 
 class CtMainWin;
 
+// Blobs of the embedded files held by the widget states, counted once however many states share them
+class CtStateBlobPool
+{
+public:
+    // the pooled blob with the same contents, if any
+    static std::shared_ptr<CtEmbFileBlob> get_blob(std::shared_ptr<CtEmbFileBlob> blob);
+    static void                           purge(); // drop the blobs no state is holding any more
+    static size_t                         get_memory_size(); // those read from the document are not in memory
+
+private:
+    static std::unordered_multimap<std::string, std::shared_ptr<CtEmbFileBlob>> _blobs; // by checksum
+};
+
 class CtAnchoredWidgetState
 {
 public:
     CtAnchoredWidgetState(int charOffset, const std::string& justification) : charOffset(charOffset), justification(justification) {}
     virtual bool equal(std::shared_ptr<CtAnchoredWidgetState> state) = 0;
     virtual CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin) = 0;
+    virtual size_t get_memory_size() const = 0; // excluding the blobs in CtStateBlobPool
 
 public:
     int charOffset;
@@ -51,10 +67,12 @@ public:
     CtAnchoredWidgetState_ImagePng(CtImagePng* image);
     virtual bool equal(std::shared_ptr<CtAnchoredWidgetState> state);
     virtual CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin);
+    virtual size_t get_memory_size() const;
 
 public:
     Glib::ustring link;
-    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+    std::shared_future<std::string> rawBlob; // encoded png, shared with the image
+    guint64 rawBlobId;
 };
 
 class CtAnchoredWidgetState_Anchor : public CtAnchoredWidgetState
@@ -63,6 +81,7 @@ public:
     CtAnchoredWidgetState_Anchor(CtImageAnchor* anchor);
     virtual bool equal(std::shared_ptr<CtAnchoredWidgetState> state);
     virtual CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin);
+    virtual size_t get_memory_size() const;
 
 public:
     Glib::ustring name;
@@ -74,10 +93,11 @@ public:
     CtAnchoredWidgetState_EmbFile(CtImageEmbFile* embFile);
     virtual bool equal(std::shared_ptr<CtAnchoredWidgetState> state);
     virtual CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin);
+    virtual size_t get_memory_size() const;
 
 public:
     Glib::ustring fileName;
-    std::string   rawBlob;      // raw data, not a string
+    std::shared_ptr<CtEmbFileBlob> rawBlob; // shared with the widget, held in CtStateBlobPool
     double        timeSeconds;
 };
 
@@ -87,6 +107,7 @@ public:
     CtAnchoredWidgetState_Codebox(CtCodebox* codebox);
     virtual bool equal(std::shared_ptr<CtAnchoredWidgetState> state);
     virtual CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin);
+    virtual size_t get_memory_size() const;
 
 public:
     Glib::ustring content, syntax;
@@ -100,6 +121,7 @@ public:
     CtAnchoredWidgetState_Table(CtTable* table);
     virtual bool equal(std::shared_ptr<CtAnchoredWidgetState> state);
     virtual CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin);
+    virtual size_t get_memory_size() const;
 
 public:
     int colMin;
@@ -108,39 +130,84 @@ public:
 };
 
 
+// Full state of a node, the buffer xml is kept lzma compressed once the state is not among the latest ones
 struct CtNodeState
 {
-    CtNodeState() : buffer_xml("buffer") { }
-    ~CtNodeState() { }
+    std::string get_buffer_xml() const;
+    void        compress();
+    size_t      get_memory_size() const;
 
     std::list<std::shared_ptr<CtAnchoredWidgetState>> widgetStates;
-    CtXmlWrite     buffer_xml;
-    Glib::ustring  buffer_xml_string;
+    std::string    bufferXml;
+    bool           compressed{false};
     int            cursor_pos;
 };
 
+// Rich text tag over a range of characters
+struct CtTagRun
+{
+    int           startOffset;
+    int           endOffset;
+    Glib::ustring tagName;
+};
+
+// A change of the node text buffer, captured from the buffer signals
+struct CtBufferOp
+{
+    enum class Type { Insert, Erase, TagApply, TagRemove };
+
+    Type                  type;
+    int                   startOffset;
+    int                   endOffset;
+    Glib::ustring         text;     // inserted or erased text
+    Glib::ustring         tagName;  // applied or removed tag
+    std::vector<CtTagRun> tagRuns;  // rich text tags of the erased text, or where the tag was before the change
+};
+
+// An undoable step, replayed by its operations if possible, else loaded from the full state
+struct CtNodeStep
+{
+    bool                         byOps{false};
+    std::vector<CtBufferOp>      ops;
+    std::vector<std::pair<std::shared_ptr<CtAnchoredWidgetState>,
+                          std::shared_ptr<CtAnchoredWidgetState>>> widgetChanges; // widget before and after the step
+    std::shared_ptr<CtNodeState> snapshot;     // full state after the step, if any
+    int                          cursorPos{0};
+    int                          charCount{0}; // to detect changes that escaped the operations
+};
+
 struct CtNodeStates
 {
-    std::vector<std::shared_ptr<CtNodeState>> states;
-    int index;
-    int indicator;
+    std::vector<CtNodeStep> steps;  // the first one is the starting state
+    int index{0};
+    int indicator{0};
+
+    std::vector<CtBufferOp> pendingOps;       // since the latest step
+    bool pendingAnchors{false};               // widgets inserted or removed since the latest step
+    bool widgetsVaried{false};                // text varied inside the widgets since the latest step
+    std::list<std::shared_ptr<CtAnchoredWidgetState>> widgetStates; // widgets at the latest step
+    int opsStepsSinceSnapshot{0};
 
-    std::shared_ptr<CtNodeState> get_state() { return states[index]; }
+    guint64 lastUsed{0};     // to trim the least recently used nodes first
+    size_t  memorySize{0};   // of the steps, excluding the blobs in CtStateBlobPool
 };
 
 class CtStateMachine
 {
 public:
     CtStateMachine(CtMainWin* pCtMainWin);
+    ~CtStateMachine();
 
     void reset();
     gint64 requested_visited_previous();
     gint64 requested_visited_next();
     void node_selected_changed(gint64 node_id);
     void text_variation(gint64 node_id, const Glib::ustring& varied_text);
-    std::shared_ptr<CtNodeState> requested_state_previous(gint64 node_id);
-    std::shared_ptr<CtNodeState> requested_state_current(gint64 node_id);
-    std::shared_ptr<CtNodeState> requested_state_subsequent(gint64 node_id);
+    void widget_text_variation(gint64 node_id, const Glib::ustring& varied_text);
+    std::list<sigc::connection> track_node_buffer(gint64 node_id, Glib::RefPtr<Gtk::TextBuffer> rTextBuffer);
+    bool requested_step_back(CtTreeIter tree_iter);
+    bool requested_step_ahead(CtTreeIter tree_iter);
+    std::shared_ptr<CtNodeState> get_node_snapshot(CtTreeIter tree_iter);
     void delete_states(gint64 node_id);
     bool curr_index_is_last_index(gint64 node_id);
     void not_undoable_timeslot_set(bool not_undoable_val);
@@ -151,15 +218,50 @@ public:
 
     void set_go_bk_fw_click(bool val) { _go_bk_fw_click = val; }
 
+    // memory of the undo states of all the windows
+    static size_t get_memory_usage() { return _nodesMemorySize + CtStateBlobPool::get_memory_size(); }
+
+    static bool is_rich_text_tag(const Glib::ustring& tagName);
+
+    // the operations of a node buffer, recorded and replayed apart from the node states
+    static void record_insert(std::vector<CtBufferOp>& ops, const Gtk::TextIter& pos, const Glib::ustring& text);
+    static bool record_erase(std::vector<CtBufferOp>& ops, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end);
+    static void record_tag(std::vector<CtBufferOp>& ops, const Glib::RefPtr<Gtk::TextTag>& rTextTag,
+                           const Gtk::TextIter& range_start, const Gtk::TextIter& range_end, bool apply);
+    static void apply_ops(Glib::RefPtr<Gtk::TextBuffer> rTextBuffer, const std::vector<CtBufferOp>& ops, bool forward);
+    static bool erase_oldest_steps(CtNodeStates& node_states, std::function<std::shared_ptr<CtNodeState>()> get_snapshot);
+
+    static const int CHECKPOINT_STEPS{10}; // operations steps between two full states
+    static const int UNCOMPRESSED_STEPS{3}; // latest steps whose full state is not compressed
+
 private:
+    CtNodeStates* _get_tracked_states(gint64 node_id);
+    void _on_buffer_insert(gint64 node_id, const Gtk::TextIter& pos, const Glib::ustring& text);
+    void _on_buffer_erase(gint64 node_id, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end);
+    void _on_buffer_tag(gint64 node_id, const Glib::RefPtr<Gtk::TextTag>& rTextTag,
+                        const Gtk::TextIter& range_start, const Gtk::TextIter& range_end, bool apply);
+    void _before_widgets_change(gint64 node_id, bool anchors);
+    void _push_step(CtTreeIter tree_iter, CtNodeStates& node_states, CtNodeStep&& step);
+    void _push_ops_step(CtTreeIter tree_iter, CtNodeStates& node_states);
+    void _apply_ops(CtTreeIter tree_iter, const CtNodeStep& step, bool forward);
+    bool _load_step(CtTreeIter tree_iter, CtNodeStates& node_states, int target_index);
+    void _after_step_loaded(CtTreeIter tree_iter, int cursor_pos);
+    void _touch_node(CtNodeStates& node_states) { node_states.lastUsed = ++_usage_tick; }
+    void _update_node_memory(CtNodeStates& node_states);
+    void _forget_node_memory(const CtNodeStates& node_states) { _nodesMemorySize -= node_states.memorySize; }
+    void _trim_memory(CtTreeIter tree_iter);
+
     CtMainWin*                  _pCtMainWin;
     Glib::RefPtr<Glib::Regex>   _word_regex;
     bool                        _go_bk_fw_click;
     bool                        _not_undoable_timeslot;
+    bool                        _applying_step{false};
+    guint64                     _usage_tick{0};
 
     std::vector<gint64>         _visited_nodes_list;
     int                         _visited_nodes_idx;
 
     std::map<gint64, CtNodeStates> _node_states;
-};
 
+    static size_t               _nodesMemorySize;
+};
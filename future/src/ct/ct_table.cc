@@ -23,20 +23,7 @@
 #include "ct_doc_rw.h"
 #include "ct_main_win.h"
 #include "ct_actions.h"
-
-CtTableCell::CtTableCell(CtMainWin* pCtMainWin,
-                         const Glib::ustring& textContent,
-                         const Glib::ustring& syntaxHighlighting)
- : CtTextCell(pCtMainWin, textContent, syntaxHighlighting)
-{
-    add(_ctTextview);
-}
-
-CtTableCell::~CtTableCell()
-{
-}
-
-
+#include <algorithm>
 
 CtTable::CtTable(CtMainWin* pCtMainWin,
                  CtTableMatrix tableMatrix,
@@ -49,61 +36,450 @@ CtTable::CtTable(CtMainWin* pCtMainWin,
    _colMin(colMin),
    _colMax(colMax)
 {
-    if (!headFront)
+    if (!headFront and not tableMatrix.empty())
     {
-        CtTableRow headerRow = tableMatrix.back();
-        tableMatrix.pop_back();
-        tableMatrix.insert(tableMatrix.begin(), headerRow);
+        std::rotate(tableMatrix.begin(), tableMatrix.end()-1, tableMatrix.end());
     }
+    _drawingArea.add_events(Gdk::BUTTON_PRESS_MASK);
+    _drawingArea.signal_draw().connect(sigc::mem_fun(*this, &CtTable::_on_draw_cells));
+    _drawingArea.signal_button_press_event().connect(sigc::mem_fun(*this, &CtTable::_on_button_press_event_cells));
+    _drawingArea.signal_style_updated().connect([this](){
+        _update_layout();
+    });
+    _drawingArea.get_style_context()->add_class("ct-table-grid");
+    _fixed.put(_drawingArea, 0, 0);
     _setup_new_matrix(tableMatrix);
 
-    _grid.set_column_spacing(1);
-    _grid.set_row_spacing(1);
     _frame.get_style_context()->add_class("ct-table");
     //_frame.set_border_width(0);
-    _frame.add(_grid);
+    _frame.add(_fixed);
     show_all();
 }
 
 CtTable::~CtTable()
 {
-    // no need for deleting cells, _grid will clean up cells
+    _measureIdleConnection.disconnect();
+    _sizeRequestIdleConnection.disconnect();
+    _editorIdleConnection.disconnect();
+    _editorChanged = false; // no state update while being destroyed
+    _close_editor();
+}
+
+void CtTable::_setup_new_matrix(CtTableMatrix& tableMatrix)
+{
+    _close_editor();
+    // from rows to columns, the cells text is moved
+    const size_t numColumns = tableMatrix.empty() ? 0 : tableMatrix[0].size();
+    _tableColumns.assign(numColumns, CtTableColumn{});
+    for (CtTableColumn& tableColumn : _tableColumns)
+    {
+        tableColumn.reserve(tableMatrix.size());
+    }
+    for (CtTableRow& tableRow : tableMatrix)
+    {
+        tableRow.resize(numColumns);
+        for (size_t col = 0; col < numColumns; ++col)
+        {
+            _tableColumns[col].push_back(std::move(tableRow[col]));
+        }
+    }
+    _update_layout();
+}
+
+void CtTable::_update_layout()
+{
+    // rows heights are estimated from the text, then measured when in view or when idle
+    _update_font_metrics();
+    _update_cols_widths();
+    _rowsHeights.resize(get_num_rows());
+    _rowsMeasured.assign(get_num_rows(), false);
+    for (int row = 0; row < get_num_rows(); ++row)
+    {
+        _rowsHeights[row] = _get_estimated_row_height(row);
+    }
+    _update_rows_y();
+    _update_size_request();
+    _drawingArea.queue_draw();
+
+    _nextRowToMeasure = 0;
+    if (not _measureIdleConnection)
+    {
+        _measureIdleConnection = Glib::signal_idle().connect(sigc::mem_fun(*this, &CtTable::_on_measure_idle), Glib::PRIORITY_LOW);
+    }
+}
+
+Glib::RefPtr<Pango::Layout> CtTable::_get_cell_layout(const int row, const int col)
+{
+    Glib::RefPtr<Pango::Layout> rLayout = _drawingArea.create_pango_layout(_tableColumns[col][row]);
+    if (0 == row)
+    {
+        // header, as the editor of the header cells and not wrapped
+        rLayout->set_font_description(_headerFont);
+    }
+    else
+    {
+        rLayout->set_width((_colsWidths[col] - 2*CELL_PAD_X) * Pango::SCALE);
+        rLayout->set_wrap(Pango::WRAP_WORD_CHAR);
+    }
+    return rLayout;
+}
+
+void CtTable::_update_font_metrics()
+{
+    Glib::RefPtr<Pango::Layout> rLayout = _drawingArea.create_pango_layout("abcdefghijklmnopqrstuvwxyz");
+    int width{0}, height{0};
+    rLayout->get_pixel_size(width, height);
+    _charWidth = std::max(1, width/26);
+    _lineHeight = std::max(1, height);
+
+    Glib::RefPtr<Gtk::StyleContext> rStyleContext = _drawingArea.get_style_context();
+    rStyleContext->context_save();
+    rStyleContext->add_class("ct-table-header-cell");
+    _headerFont = rStyleContext->get_font(rStyleContext->get_state());
+    rStyleContext->context_restore();
+}
+
+void CtTable::_update_cols_widths()
+{
+    // at least col max wide, wider if the header does not fit
+    _colsWidths.assign(get_num_rows() > 0 ? get_num_columns() : 0, _colMax);
+    for (int col = 0; col < (int)_colsWidths.size(); ++col)
+    {
+        int width{0}, height{0};
+        _get_cell_layout(0, col)->get_pixel_size(width, height);
+        _colsWidths[col] = std::max(_colMax, width + 2*CELL_PAD_X);
+    }
+}
+
+int CtTable::_get_estimated_row_height(const int row)
+{
+    int maxLines{1};
+    for (int col = 0; col < get_num_columns(); ++col)
+    {
+        const std::string& text = _tableColumns[col][row].raw();
+        const size_t charsPerLine = std::max(1, (_colsWidths[col] - 2*CELL_PAD_X) / _charWidth);
+        int lines{0};
+        size_t lineStart{0};
+        while (true)
+        {
+            const size_t lineEnd = text.find('\n', lineStart);
+            const size_t lineBytes = (std::string::npos == lineEnd ? text.size() : lineEnd) - lineStart;
+            lines += (0 == row or 0 == lineBytes) ? 1 : static_cast<int>((lineBytes + charsPerLine - 1) / charsPerLine);
+            if (std::string::npos == lineEnd) break;
+            lineStart = lineEnd + 1;
+        }
+        maxLines = std::max(maxLines, lines);
+    }
+    return maxLines * _lineHeight + 2*CELL_PAD_Y;
 }
 
-void CtTable::_setup_new_matrix(const CtTableMatrix& tableMatrix)
+bool CtTable::_measure_row(const int row)
 {
-    for (auto widget: _grid.get_children())
-        _grid.remove(*widget);
+    int maxHeight{_lineHeight};
+    for (int col = 0; col < get_num_columns(); ++col)
+    {
+        int width{0}, height{0};
+        _get_cell_layout(row, col)->get_pixel_size(width, height);
+        maxHeight = std::max(maxHeight, height);
+    }
+    _rowsMeasured[row] = true;
+    const int rowHeight = maxHeight + 2*CELL_PAD_Y;
+    if (row == _editorRow and _pEditor)
+    {
+        // the editor may be taller
+        if (_rowsHeights[row] > rowHeight) return false;
+    }
+    if (rowHeight == _rowsHeights[row]) return false;
+    _rowsHeights[row] = rowHeight;
+    return true;
+}
+
+void CtTable::_update_rows_y()
+{
+    // 1 pixel of grid line around each cell
+    _rowsY.resize(_rowsHeights.size() + 1);
+    int y{1};
+    for (size_t row = 0; row < _rowsHeights.size(); ++row)
+    {
+        _rowsY[row] = y;
+        y += _rowsHeights[row] + 1;
+    }
+    _rowsY.back() = y;
+}
+
+void CtTable::_update_size_request()
+{
+    _drawingArea.set_size_request(_get_col_x((int)_colsWidths.size()), _rowsY.back());
+    if (_pEditor)
+    {
+        _fixed.move(_pEditor->get_text_view(), _get_col_x(_editorCol), _rowsY[_editorRow]);
+        _pEditor->get_text_view().set_size_request(_colsWidths[_editorCol], _rowsHeights[_editorRow]);
+    }
+}
+
+void CtTable::_queue_size_request()
+{
+    // not while drawing
+    if (not _sizeRequestIdleConnection)
+    {
+        _sizeRequestIdleConnection = Glib::signal_idle().connect([this](){
+            _update_size_request();
+            return false; /* one shot */
+        });
+    }
+}
+
+bool CtTable::_on_measure_idle()
+{
+    bool changed{false};
+    int measured{0};
+    while (_nextRowToMeasure < get_num_rows() and measured < ROWS_MEASURED_PER_IDLE)
+    {
+        if (not _rowsMeasured[_nextRowToMeasure])
+        {
+            changed |= _measure_row(_nextRowToMeasure);
+            ++measured;
+        }
+        ++_nextRowToMeasure;
+    }
+    if (changed)
+    {
+        _update_rows_y();
+        _update_size_request();
+        _drawingArea.queue_draw();
+    }
+    return _nextRowToMeasure < get_num_rows(); // false disconnects when all the rows are measured
+}
+
+int CtTable::_get_row_at_y(const int y)
+{
+    auto it = std::upper_bound(_rowsY.begin(), _rowsY.end()-1, y);
+    return std::max(0, static_cast<int>(it - _rowsY.begin()) - 1);
+}
+
+int CtTable::_get_col_at_x(const int x)
+{
+    int col{0};
+    while (col < (int)_colsWidths.size()-1 and _get_col_x(col+1) <= x)
+    {
+        ++col;
+    }
+    return col;
+}
+
+int CtTable::_get_col_x(const int col)
+{
+    int x{1};
+    for (int i = 0; i < col; ++i)
+    {
+        x += _colsWidths[i] + 1;
+    }
+    return x;
+}
+
+bool CtTable::_on_draw_cells(const Cairo::RefPtr<Cairo::Context>& cairoContext)
+{
+    if (0 == get_num_rows()) return true;
+    double clipX1, clipY1, clipX2, clipY2;
+    cairoContext->get_clip_extents(clipX1, clipY1, clipX2, clipY2);
+    const int firstRow = _get_row_at_y(static_cast<int>(clipY1));
+
+    // only the rows in view are laid out
+    bool changed{false};
+    for (int row = firstRow; row < get_num_rows() and _rowsY[row] < clipY2; ++row)
+    {
+        if (not _rowsMeasured[row])
+        {
+            changed |= _measure_row(row);
+        }
+    }
+    if (changed)
+    {
+        _update_rows_y();
+        _queue_size_request();
+    }
 
-    _tableMatrix = tableMatrix;
-    for (int row = 0; row < (int)_tableMatrix.size(); ++row)
+    // grid lines as in the css of the table, cells as the style scheme of the cells editor, else as the views of the theme
+    Glib::RefPtr<Gtk::StyleContext> rStyleContext = _drawingArea.get_style_context();
+    rStyleContext->render_background(cairoContext, 0, 0, _drawingArea.get_allocated_width(), _drawingArea.get_allocated_height());
+    rStyleContext->context_save();
+    rStyleContext->add_class(GTK_STYLE_CLASS_VIEW);
+    Gdk::RGBA cellFg = rStyleContext->get_color(rStyleContext->get_state());
+    Gdk::RGBA cellBg;
+    bool cellBgFromScheme{false};
+    // the scheme of the cells text buffers, see CtMainWin::get_new_text_buffer
+    if (Glib::RefPtr<Gsv::StyleScheme> rStyleScheme = _pCtMainWin->get_style_scheme_manager()->get_scheme(CtConst::STYLE_SCHEME_LIGHT))
+    {
+        if (Glib::RefPtr<Gsv::Style> rTextStyle = rStyleScheme->get_style("text"))
+        {
+            if (rTextStyle->property_foreground_set()) cellFg.set(rTextStyle->property_foreground());
+            if (rTextStyle->property_background_set()) cellBgFromScheme = cellBg.set(rTextStyle->property_background());
+        }
+    }
+    for (int row = firstRow; row < get_num_rows() and _rowsY[row] < clipY2; ++row)
     {
-        for (int col = 0; col < (int)_tableMatrix[row].size(); ++col)
+        int x{1};
+        for (int col = 0; col < get_num_columns(); ++col)
         {
-            CtTableCell* pTableCell = _tableMatrix[row][col];
-            bool is_header = row == 0;
-            // todo: don't know how to use colMax and colMin, so use just colMax
-            pTableCell->get_text_view().set_size_request(_colMax, -1);
-            pTableCell->get_text_view().set_highlight_current_line(false);
-            if (is_header)
+            if (cellBgFromScheme)
             {
-                pTableCell->get_text_view().get_style_context()->add_class("ct-table-header-cell");
-                pTableCell->get_text_view().set_wrap_mode(Gtk::WrapMode::WRAP_NONE);
-                pTableCell->get_text_view().signal_populate_popup().connect(
-                            sigc::bind(sigc::mem_fun(*this, &CtTable::_on_populate_popup_header_cell), row, col));
+                Gdk::Cairo::set_source_rgba(cairoContext, cellBg);
+                cairoContext->rectangle(x, _rowsY[row], _colsWidths[col], _rowsHeights[row]);
+                cairoContext->fill();
             }
             else
             {
-                pTableCell->get_text_view().signal_populate_popup().connect(
-                        sigc::bind(sigc::mem_fun(*this, &CtTable::_on_populate_popup_cell), row, col));
+                rStyleContext->render_background(cairoContext, x, _rowsY[row], _colsWidths[col], _rowsHeights[row]);
+            }
+            if (x < clipX2 and x + _colsWidths[col] > clipX1 and not (row == _editorRow and col == _editorCol and _pEditor))
+            {
+                Gdk::Cairo::set_source_rgba(cairoContext, cellFg);
+                cairoContext->move_to(x + CELL_PAD_X, _rowsY[row] + CELL_PAD_Y);
+                _get_cell_layout(row, col)->show_in_cairo_context(cairoContext);
             }
-            pTableCell->get_text_view().signal_key_press_event().connect(
-                        sigc::bind(sigc::mem_fun(*this, &CtTable::_on_key_press_event_cell), row, col), false);
+            x += _colsWidths[col] + 1;
+        }
+    }
+    rStyleContext->context_restore();
+    return true;
+}
+
+bool CtTable::_on_button_press_event_cells(GdkEventButton* event)
+{
+    if (0 == get_num_rows()) return false;
+    const int row = _get_row_at_y(static_cast<int>(event->y));
+    const int col = _get_col_at_x(static_cast<int>(event->x));
+    if (1 == event->button)
+    {
+        _open_editor(row, col);
+        return true;
+    }
+    if (3 == event->button)
+    {
+        if (not _pCtMainWin->user_active()) return false;
+        _pCtMainWin->get_ct_actions()->curr_table_anchor = this;
+        _currentRow = row;
+        _currentColumn = col;
+        _pCtMainWin->get_ct_menu().get_popup_menu(0 == row ? CtMenu::POPUP_MENU_TYPE::TableHeaderCell : CtMenu::POPUP_MENU_TYPE::TableCell)->popup(event->button, event->time);
+        return true;
+    }
+    return false;
+}
+
+void CtTable::_open_editor(const int row, const int col)
+{
+    _close_editor();
+    _editorRow = row;
+    _editorCol = col;
+    _editorChanged = false;
+    _currentRow = row;
+    _currentColumn = col;
+    _pCtMainWin->get_ct_actions()->curr_table_anchor = this;
+
+    _pEditor.reset(new CtTextCell(_pCtMainWin, _tableColumns[col][row], CtConst::TABLE_CELL_TEXT_ID));
+    CtTextView& textView = _pEditor->get_text_view();
+    textView.set_highlight_current_line(false);
+    if (0 == row)
+    {
+        textView.get_style_context()->add_class("ct-table-header-cell");
+        textView.set_wrap_mode(Gtk::WrapMode::WRAP_NONE);
+        textView.signal_populate_popup().connect(sigc::bind(sigc::mem_fun(*this, &CtTable::_on_populate_popup_header_cell), row, col));
+    }
+    else
+    {
+        textView.set_wrap_mode(Gtk::WrapMode::WRAP_WORD_CHAR);
+        textView.signal_populate_popup().connect(sigc::bind(sigc::mem_fun(*this, &CtTable::_on_populate_popup_cell), row, col));
+    }
+    textView.signal_key_press_event().connect(sigc::bind(sigc::mem_fun(*this, &CtTable::_on_key_press_event_cell), row, col), false);
+    _pEditor->get_buffer()->signal_changed().connect(sigc::mem_fun(*this, &CtTable::_on_editor_changed));
+    const guint64 generation = _editorGeneration;
+    textView.signal_focus_out_event().connect([this, generation](GdkEventFocus*){
+        // not from within the handlers of the editor
+        if (generation == _editorGeneration and not _editorIdleConnection)
+        {
+            _editorIdleConnection = Glib::signal_idle().connect([this, generation](){
+                if (generation == _editorGeneration and _pEditor and not _pEditor->get_text_view().is_focus())
+                {
+                    _close_editor();
+                }
+                return false; /* one shot */
+            });
+        }
+        return false;
+    });
+    textView.signal_size_allocate().connect([this, generation](Gtk::Allocation& allocation){
+        // the editor grows with the text
+        if (generation == _editorGeneration and allocation.get_height() > _rowsHeights[_editorRow])
+        {
+            _rowsHeights[_editorRow] = allocation.get_height();
+            _update_rows_y();
+            _queue_size_request();
+            _drawingArea.queue_draw();
+        }
+    });
 
-            _grid.attach(*pTableCell, col, row, 1 /*1 cell horiz*/, 1 /*1 cell vert*/);
+    _fixed.put(textView, _get_col_x(col), _rowsY[row]);
+    textView.set_size_request(_colsWidths[col], _rowsHeights[row]);
+    textView.show();
+    textView.grab_focus();
+    _drawingArea.queue_draw();
+}
+
+void CtTable::_close_editor()
+{
+    if (not _pEditor) return;
+    ++_editorGeneration;
+    _editorIdleConnection.disconnect();
+    const int row = _editorRow;
+    std::unique_ptr<CtTextCell> pEditor = std::move(_pEditor);
+    _editorRow = -1;
+    _editorCol = -1;
+    _fixed.remove(pEditor->get_text_view());
+    pEditor.reset();
+
+    if (_editorChanged)
+    {
+        _editorChanged = false;
+        if (CtTreeIter treeIter = _pCtMainWin->curr_tree_store().get_node_from_node_id(_editorNodeId))
+        {
+            _pCtMainWin->get_state_machine().update_state(treeIter);
+        }
+    }
+    if (row < get_num_rows())
+    {
+        // back to the height of the text
+        _rowsMeasured[row] = false;
+        if (_measure_row(row))
+        {
+            _update_rows_y();
+            _queue_size_request();
         }
     }
-    _grid.show_all();
+    _drawingArea.queue_draw();
+}
+
+void CtTable::_defer_open_editor(const int row, const int col)
+{
+    // not from within the handlers of the current editor
+    _editorIdleConnection.disconnect();
+    ++_editorGeneration;
+    _editorIdleConnection = Glib::signal_idle().connect([this, row, col](){
+        _open_editor(row, col);
+        return false; /* one shot */
+    });
+}
+
+void CtTable::_on_editor_changed()
+{
+    if (not _pEditor) return;
+    _tableColumns[_editorCol][_editorRow] = _pEditor->get_text_content();
+    if (not _editorChanged)
+    {
+        _editorChanged = true;
+        _editorNodeId = _pCtMainWin->curr_tree_iter().get_node_id();
+    }
+    CtTreeIter treeIter = _pCtMainWin->curr_tree_store().get_node_from_node_id(_editorNodeId);
+    _pCtMainWin->update_window_save_needed(CtSaveNeededUpdType::nbuf, false/*new_machine_state*/, &treeIter);
 }
 
 void CtTable::to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment)
@@ -119,15 +495,42 @@ void CtTable::to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment)
 void CtTable::_populate_xml_rows_cells(xmlpp::Element* p_table_node)
 {
     p_table_node->set_attribute("head_front", std::to_string(true));
-    for (const CtTableRow& tableRow : _tableMatrix)
+    for (int row = 0; row < get_num_rows(); ++row)
     {
         xmlpp::Element* p_row_node = p_table_node->add_child("row");
-        for (const CtTableCell* pTableCell : tableRow)
+        for (const CtTableColumn& tableColumn : _tableColumns)
         {
             xmlpp::Element* p_cell_node = p_row_node->add_child("cell");
-            p_cell_node->add_child_text(pTableCell->get_text_content());
+            p_cell_node->add_child_text(tableColumn[row]);
+        }
+    }
+}
+
+CtTableMatrix CtTable::get_table_matrix() const
+{
+    CtTableMatrix tableMatrix(get_num_rows());
+    for (int row = 0; row < get_num_rows(); ++row)
+    {
+        tableMatrix[row].reserve(_tableColumns.size());
+        for (const CtTableColumn& tableColumn : _tableColumns)
+        {
+            tableMatrix[row].push_back(tableColumn[row]);
         }
     }
+    return tableMatrix;
+}
+
+void CtTable::to_csv(std::ostream& outStream) const
+{
+    for (int row = 0; row < get_num_rows(); ++row)
+    {
+        for (int col = 0; col < get_num_columns(); ++col)
+        {
+            if (col > 0) outStream << ',';
+            CtCSV::write_field(outStream, _tableColumns[col][row]);
+        }
+        outStream << "\r\n";
+    }
 }
 
 bool CtTable::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment)
@@ -167,124 +570,139 @@ std::shared_ptr<CtAnchoredWidgetState> CtTable::get_state()
 
 void CtTable::set_modified_false()
 {
-    for (CtTableRow& tableRow : _tableMatrix)
+    if (_pEditor)
     {
-        for (CtTableCell* pTableCell : tableRow)
-        {
-            pTableCell->set_text_buffer_modified_false();
-        }
+        _pEditor->set_text_buffer_modified_false();
     }
 }
 
 void CtTable::column_add(int after_column)
 {
-    auto matrix = _copy_matrix(after_column, -1, -1, -1, -1, -1);
-    _setup_new_matrix(matrix);
+    _close_editor();
+    _tableColumns.insert(_tableColumns.begin() + after_column + 1, CtTableColumn(get_num_rows()));
+    _update_layout();
 }
 
 void CtTable::column_delete(int column)
 {
-    if (_tableMatrix[0].size() == 1) return;
-    auto matrix = _copy_matrix(-1, column, -1, -1, -1, -1);
-    _setup_new_matrix(matrix);
+    if (get_num_columns() == 1) return;
+    _close_editor();
+    _tableColumns.erase(_tableColumns.begin() + column);
+    _update_layout();
 }
 
 void CtTable::column_move_left(int column)
 {
     if (column == 0) return;
-    auto matrix = _copy_matrix(-1, -1, -1, -1, column, -1);
-    _setup_new_matrix(matrix);
+    _close_editor();
+    std::swap(_tableColumns[column-1], _tableColumns[column]);
+    _update_layout();
 }
 
 void CtTable::column_move_right(int column)
 {
-    if (column == (int)_tableMatrix[0].size()-1) return;
-    // moving to right is same as moving to left for other column
-    auto matrix = _copy_matrix(-1, -1, -1, -1, column + 1, -1);
-    _setup_new_matrix(matrix);
+    if (column == get_num_columns()-1) return;
+    _close_editor();
+    std::swap(_tableColumns[column], _tableColumns[column+1]);
+    _update_layout();
 }
 
 void CtTable::row_add(int after_row, std::vector<Glib::ustring>* row /*= nullptr*/)
 {
-    auto matrix = _copy_matrix(-1, -1, after_row, -1, -1, -1);
-    if (row && row->size() == matrix[0].size())
-        for (int col = 0; col < matrix[0].size(); ++col)
-            matrix[after_row + 1][col]->get_text_view().get_buffer()->set_text(row->at(col));
-    _setup_new_matrix(matrix);
+    _close_editor();
+    const bool withCells = row && (int)row->size() == get_num_columns();
+    for (int col = 0; col < get_num_columns(); ++col)
+    {
+        _tableColumns[col].insert(_tableColumns[col].begin() + after_row + 1, withCells ? row->at(col) : Glib::ustring{});
+    }
+    _update_layout();
 }
 
 void CtTable::row_delete(int row)
 {
-    if (_tableMatrix.size() == 1) return;
-    auto matrix = _copy_matrix(-1, -1, -1, row, -1, -1);
-    _setup_new_matrix(matrix);
+    if (get_num_rows() == 1) return;
+    _close_editor();
+    for (CtTableColumn& tableColumn : _tableColumns)
+    {
+        tableColumn.erase(tableColumn.begin() + row);
+    }
+    _update_layout();
 }
 
 void CtTable::row_move_up(int row)
 {
     if (row == 0) return;
-    auto matrix = _copy_matrix(-1, -1, -1, -1, -1, row);
-    _setup_new_matrix(matrix);
+    _close_editor();
+    for (CtTableColumn& tableColumn : _tableColumns)
+    {
+        std::swap(tableColumn[row-1], tableColumn[row]);
+    }
+    _update_layout();
 }
 
 void CtTable::row_move_down(int row)
 {
-    if (row == (int)_tableMatrix.size()-1) return;
-    // moving up is same as moving down for other row
-    auto matrix = _copy_matrix(-1, -1, -1, -1, -1, row + 1);
-    _setup_new_matrix(matrix);
+    if (row == get_num_rows()-1) return;
+    _close_editor();
+    for (CtTableColumn& tableColumn : _tableColumns)
+    {
+        std::swap(tableColumn[row], tableColumn[row+1]);
+    }
+    _update_layout();
 }
 
 bool CtTable::row_sort_asc()
 {
-    auto matrix = _copy_matrix(-1, -1, -1, -1, -1, -1);
-    std::sort(matrix.begin()+1, matrix.end(), [](CtTableRow& l, CtTableRow& r) { return CtStrUtil::natural_compare(l[0]->get_text_content(), r[0]->get_text_content()) < 0; });
-    auto prev_state = get_state();
-    _setup_new_matrix(matrix);
-    return !prev_state->equal(get_state());
+    return _sort_rows(true/*ascending*/);
 }
 
 bool CtTable::row_sort_desc()
 {
-    auto matrix = _copy_matrix(-1, -1, -1, -1, -1, -1);
-    std::sort(matrix.begin()+1, matrix.end(), [](CtTableRow& l, CtTableRow& r) { return CtStrUtil::natural_compare(l[0]->get_text_content(), r[0]->get_text_content()) > 0; });
-    auto prev_state = get_state();
-    _setup_new_matrix(matrix);
-    return !prev_state->equal(get_state());
+    return _sort_rows(false/*ascending*/);
 }
 
-void CtTable::set_col_min_max(int col_min, int col_max)
+bool CtTable::_sort_rows(const bool ascending)
 {
-    _colMin = col_min;
-    _colMax = col_max;
-    auto matrix = _copy_matrix(-1, -1, -1, -1, -1, -1);
-    _setup_new_matrix(matrix);
-}
+    // the rows after the header are sorted by the first column, as a permutation of the rows indexes
+    // compared by keys computed once per row; false if the order is unchanged
+    if (get_num_rows() < 3) return false;
+    const CtTableColumn& sortColumn = _tableColumns[0];
+    std::vector<std::string> keys(sortColumn.size());
+    for (size_t row = 1; row < sortColumn.size(); ++row)
+    {
+        keys[row] = CtStrUtil::natural_sort_key(sortColumn[row]);
+    }
+    std::vector<size_t> rowsOrder(sortColumn.size());
+    for (size_t row = 0; row < rowsOrder.size(); ++row)
+    {
+        rowsOrder[row] = row;
+    }
+    std::stable_sort(rowsOrder.begin()+1, rowsOrder.end(), [&keys, ascending](const size_t l, const size_t r) {
+        return ascending ? keys[l] < keys[r] : keys[r] < keys[l];
+    });
+    if (std::is_sorted(rowsOrder.begin(), rowsOrder.end())) return false;
 
-CtTableMatrix CtTable::_copy_matrix(int col_add, int col_del, int row_add, int row_del, int col_move_left, int row_move_up)
-{
-    // don't check input indexes, it's already checked
-    CtTableMatrix matrix;
-    for (int row = 0; row < (int)_tableMatrix.size(); ++row)
+    _close_editor();
+    for (CtTableColumn& tableColumn : _tableColumns)
     {
-        if (row == row_del) continue;
-        matrix.push_back(CtTableRow());
-        for (int col = 0; col < (int)_tableMatrix[row].size(); ++col) {
-            if (col == col_del) continue;
-            matrix.back().push_back(new CtTableCell(_pCtMainWin, _tableMatrix[row][col]->get_text_content(), CtConst::TABLE_CELL_TEXT_ID));
-            if (col == col_add) {
-                matrix.back().push_back(new CtTableCell(_pCtMainWin, "", CtConst::TABLE_CELL_TEXT_ID));
-            }
-            if (col == col_move_left) std::swap(matrix[row][col-1], matrix[row][col]);
-        }
-        if (row == row_add) {
-            matrix.push_back(CtTableRow());
-            while (matrix.back().size() != _tableMatrix[0].size())
-                matrix.back().push_back(new CtTableCell(_pCtMainWin, "", CtConst::TABLE_CELL_TEXT_ID));
+        CtTableColumn sortedColumn;
+        sortedColumn.reserve(tableColumn.size());
+        for (const size_t row : rowsOrder)
+        {
+            sortedColumn.push_back(std::move(tableColumn[row]));
         }
-        if (row == row_move_up) std::swap(matrix[row-1], matrix[row]);
+        tableColumn.swap(sortedColumn);
     }
-    return matrix;
+    _update_layout();
+    return true;
+}
+
+void CtTable::set_col_min_max(int col_min, int col_max)
+{
+    _colMin = col_min;
+    _colMax = col_max;
+    _close_editor();
+    _update_layout();
 }
 
 void CtTable::_on_populate_popup_header_cell(Gtk::Menu* menu, int row, int col)
@@ -327,16 +745,16 @@ bool CtTable::_on_key_press_event_cell(GdkEventKey* event, int row, int col)
     }
     else {
         if (event->keyval == GDK_KEY_Return || event->keyval == GDK_KEY_Tab || event->keyval == GDK_KEY_Up || event->keyval == GDK_KEY_Down) {
-            int index = row * _tableMatrix[0].size() + col;
+            int index = row * get_num_columns() + col;
             if (event->keyval == GDK_KEY_Up) index -= 1;
             else index +=1;
-            row = index/_tableMatrix[0].size();
-            col = index%_tableMatrix[0].size();
+            row = index/get_num_columns();
+            col = index%get_num_columns();
             if (index < 0) return true;
-            if (row == _tableMatrix.size()) return true;
+            if (row == get_num_rows()) return true;
              _currentRow = row;
              _currentColumn = col;
-             _tableMatrix[row][col]->get_text_view().grab_focus();
+             _defer_open_editor(row, col);
              return true;
         }
     }
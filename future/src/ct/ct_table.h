@@ -24,18 +24,14 @@
 #include "ct_codebox.h"
 #include "ct_widgets.h"
 
-class CtTextCell;
-class CtTableCell : public CtTextCell, public Gtk::EventBox
-{
-public:
-    CtTableCell(CtMainWin* pCtMainWin,
-                const Glib::ustring& textContent,
-                const Glib::ustring& syntaxHighlighting);
-    virtual ~CtTableCell();
-};
+#include <memory>
 
-typedef std::vector<CtTableCell*> CtTableRow;
+// rows of cells text, to build a table or get a copy of its cells
+typedef std::vector<Glib::ustring> CtTableRow;
 typedef std::vector<CtTableRow> CtTableMatrix;
+// the table stores the cells by column
+typedef std::vector<Glib::ustring> CtTableColumn;
+typedef std::vector<CtTableColumn> CtTableColumns;
 
 class CtTable : public CtAnchoredWidget
 {
@@ -56,13 +52,17 @@ public:
     CtAnchWidgType get_type() override { return CtAnchWidgType::Table; }
     std::shared_ptr<CtAnchoredWidgetState> get_state() override;
 
-    const CtTableMatrix& get_table_matrix() { return _tableMatrix; }
+    int  get_num_rows() const { return _tableColumns.empty() ? 0 : (int)_tableColumns[0].size(); }
+    int  get_num_columns() const { return (int)_tableColumns.size(); }
+    const Glib::ustring& get_cell_text(const int row, const int col) const { return _tableColumns[col][row]; }
+    CtTableMatrix get_table_matrix() const;
+    void to_csv(std::ostream& outStream) const;
     int get_col_max() { return _colMax; }
     int get_col_min() { return _colMin; }
 
 public:
-    int  current_row() { return _currentRow < _tableMatrix.size() ? _currentRow : 0; }
-    int  current_column() { return _currentColumn < _tableMatrix[0].size() ? _currentColumn : 0; }
+    int  current_row() { return _currentRow < get_num_rows() ? _currentRow : 0; }
+    int  current_column() { return _currentColumn < get_num_columns() ? _currentColumn : 0; }
 
     void column_add(int after_column);
     void column_delete(int column);
@@ -78,8 +78,27 @@ public:
     void set_col_min_max(int col_min, int col_max);
 
 private:
-    void _setup_new_matrix(const CtTableMatrix& tableMatrix);
-    CtTableMatrix _copy_matrix(int col_add, int col_del, int row_add, int row_del, int col_move_left, int row_move_up);
+    void _setup_new_matrix(CtTableMatrix& tableMatrix);
+    void _update_layout();
+    bool _sort_rows(const bool ascending);
+
+    Glib::RefPtr<Pango::Layout> _get_cell_layout(const int row, const int col);
+    void _update_font_metrics();
+    void _update_cols_widths();
+    int  _get_estimated_row_height(const int row);
+    bool _measure_row(const int row); // true if the height changed
+    void _update_rows_y();
+    void _update_size_request();
+    void _queue_size_request();
+    bool _on_measure_idle();
+    int  _get_row_at_y(const int y);
+    int  _get_col_at_x(const int x);
+    int  _get_col_x(const int col);
+
+    void _open_editor(const int row, const int col);
+    void _close_editor();
+    void _defer_open_editor(const int row, const int col);
+    void _on_editor_changed();
 
 protected:
     void _populate_xml_rows_cells(xmlpp::Element* p_table_node);
@@ -88,12 +107,40 @@ private:
     void _on_populate_popup_header_cell(Gtk::Menu* menu, int row, int col);
     void _on_populate_popup_cell(Gtk::Menu* menu, int row, int col);
     bool _on_key_press_event_cell(GdkEventKey* event, int row, int co);
+    bool _on_draw_cells(const Cairo::RefPtr<Cairo::Context>& cairoContext);
+    bool _on_button_press_event_cells(GdkEventButton* event);
+
+public:
+    static const int CELL_PAD_X{7};
+    static const int CELL_PAD_Y{2};
+    static const int ROWS_MEASURED_PER_IDLE{100};
 
 protected:
-    CtTableMatrix _tableMatrix;
-    Gtk::Grid     _grid;
+    CtTableColumns _tableColumns; // header is row 0
     int           _colMin;
     int           _colMax;
     int           _currentRow = 0;
     int           _currentColumn = 0;
+
+    // the cells are drawn from the columns, only the rows in view are laid out, the others are measured when idle
+    Gtk::Fixed        _fixed;
+    Gtk::DrawingArea  _drawingArea;
+    std::vector<int>  _colsWidths;
+    std::vector<int>  _rowsHeights;  // estimated until the row is measured
+    std::vector<int>  _rowsY;
+    std::vector<bool> _rowsMeasured;
+    int               _nextRowToMeasure{0};
+    int               _lineHeight{1};
+    int               _charWidth{1};
+    Pango::FontDescription _headerFont;
+    sigc::connection  _measureIdleConnection;
+    sigc::connection  _sizeRequestIdleConnection;
+
+    std::unique_ptr<CtTextCell> _pEditor;
+    int               _editorRow{-1};
+    int               _editorCol{-1};
+    guint64           _editorGeneration{0};
+    gint64            _editorNodeId{-1}; // node of the table while the editor changes a cell
+    bool              _editorChanged{false};
+    sigc::connection  _editorIdleConnection;
 };
@@ -24,6 +24,8 @@
 #include "ct_doc_rw.h"
 #include "ct_misc_utils.h"
 #include "ct_main_win.h"
+#include "ct_codebox.h"
+#include "ct_image.h"
 
 CtTreeModelColumns::~CtTreeModelColumns()
 {
@@ -266,6 +268,10 @@ CtTreeStore::CtTreeStore(CtMainWin* pCtMainWin)
  : _pCtMainWin(pCtMainWin)
 {
     _rTreeStore = Gtk::TreeStore::create(_columns);
+    // the paths of the node ids are collected again at the next lookup
+    _rTreeStore->signal_row_inserted().connect([this](const Gtk::TreePath&, const Gtk::TreeIter&){ _nodesPathsStale = true; });
+    _rTreeStore->signal_row_deleted().connect([this](const Gtk::TreePath&){ _nodesPathsStale = true; });
+    _rTreeStore->signal_rows_reordered().connect([this](const Gtk::TreePath&, const Gtk::TreeIter&, int*){ _nodesPathsStale = true; });
 }
 
 CtTreeStore::~CtTreeStore()
@@ -302,6 +308,136 @@ bool CtTreeStore::pending_data_write(const bool run_vacuum)
     return false;
 }
 
+void CtTreeStore::search_index_invalidate_node(const gint64 node_id)
+{
+    _searchIndex.remove_node(node_id);
+    _searchIndexDirtyNodes.insert(node_id);
+}
+
+void CtTreeStore::search_index_remove_nodes(const std::vector<gint64>& node_ids)
+{
+    for (const gint64 node_id : node_ids)
+    {
+        _searchIndex.remove_node(node_id);
+        _searchIndexDirtyNodes.erase(node_id);
+        _nameIndex.remove_node(node_id);
+    }
+}
+
+void CtTreeStore::name_index_update_node(const Gtk::TreeIter& treeIter)
+{
+    const Gtk::TreeIter fatherIter = treeIter->parent();
+    _nameIndex.set_node(treeIter->get_value(_columns.colNodeUniqueId),
+                        fatherIter ? fatherIter->get_value(_columns.colNodeUniqueId) : 0,
+                        treeIter->get_value(_columns.colNodeName),
+                        treeIter->get_value(_columns.colNodeTags));
+}
+
+// Index the nodes not yet indexed and not modified since the latest save,
+// loaded nodes from their buffers and the others straight from the db
+bool CtTreeStore::search_index_update_missing()
+{
+    bool anyUpdate{false};
+    std::set<gint64> nodeIdsFromDb;
+    _rTreeStore->foreach_iter([this, &anyUpdate, &nodeIdsFromDb](const Gtk::TreeIter& iter)
+    {
+        const gint64 node_id = iter->get_value(_columns.colNodeUniqueId);
+        if (_searchIndex.is_node_indexed(node_id) or 0 != _searchIndexDirtyNodes.count(node_id))
+        {
+            return false; /* continue */
+        }
+        if (iter->get_value(_columns.rColTextBuffer) or nullptr == _pCtSQLite)
+        {
+            _search_index_update_node(to_ct_tree_iter(iter));
+            anyUpdate = true;
+        }
+        else
+        {
+            nodeIdsFromDb.insert(node_id);
+        }
+        return false; /* continue */
+    });
+    if (not nodeIdsFromDb.empty())
+    {
+        for (const gint64 node_id : nodeIdsFromDb)
+        {
+            _searchIndex.set_node_text(node_id, "");
+        }
+        if (not _pCtSQLite->read_nodes_search_text(nodeIdsFromDb, [this](const gint64 node_id, const std::string& text){
+                 _searchIndex.append_node_text(node_id, text);
+             }))
+        {
+            // partially read nodes must not be filtered
+            for (const gint64 node_id : nodeIdsFromDb)
+            {
+                _searchIndex.remove_node(node_id);
+            }
+            return anyUpdate;
+        }
+        anyUpdate = true;
+    }
+    return anyUpdate;
+}
+
+void CtTreeStore::search_index_load(const std::string& doc_filepath)
+{
+    _searchIndexDirtyNodes.clear();
+    _searchIndex.read_cache(doc_filepath);
+}
+
+// The saved nodes are indexed again and the index stored next to the document
+void CtTreeStore::search_index_after_save(const std::string& doc_filepath, const bool persist)
+{
+    if (not _searchIndexDirtyNodes.empty())
+    {
+        _rTreeStore->foreach_iter([this](const Gtk::TreeIter& iter)
+        {
+            const gint64 node_id = iter->get_value(_columns.colNodeUniqueId);
+            if (0 != _searchIndexDirtyNodes.count(node_id) and iter->get_value(_columns.rColTextBuffer))
+            {
+                _search_index_update_node(to_ct_tree_iter(iter));
+            }
+            return false; /* continue */
+        });
+        _searchIndexDirtyNodes.clear();
+    }
+    if (persist and not _searchIndex.empty())
+    {
+        _searchIndex.write_cache(doc_filepath);
+    }
+}
+
+void CtTreeStore::_search_index_update_node(CtTreeIter treeIter)
+{
+    const gint64 node_id = treeIter.get_node_id();
+    _searchIndex.set_node_text(node_id, treeIter.get_node_text_buffer()->get_text());
+    for (CtAnchoredWidget* pAnchoredWidget : treeIter.get_all_embedded_widgets())
+    {
+        if (CtImageEmbFile* pImageEmbFile = dynamic_cast<CtImageEmbFile*>(pAnchoredWidget))
+        {
+            _searchIndex.append_node_text(node_id, pImageEmbFile->get_file_name());
+        }
+        else if (CtImageAnchor* pImageAnchor = dynamic_cast<CtImageAnchor*>(pAnchoredWidget))
+        {
+            _searchIndex.append_node_text(node_id, pImageAnchor->get_anchor_name());
+        }
+        else if (CtTable* pTable = dynamic_cast<CtTable*>(pAnchoredWidget))
+        {
+            for (int row = 0; row < pTable->get_num_rows(); ++row)
+            {
+                for (int col = 0; col < pTable->get_num_columns(); ++col)
+                {
+                    _searchIndex.append_node_text(node_id, pTable->get_cell_text(row, col));
+                }
+            }
+        }
+        else if (CtCodebox* pCodebox = dynamic_cast<CtCodebox*>(pAnchoredWidget))
+        {
+            _searchIndex.append_node_text(node_id, pCodebox->get_text_content());
+        }
+    }
+}
+
 void CtTreeStore::_iter_delete_anchored_widgets(const Gtk::TreeModel::Children& children)
 {
     for (Gtk::TreeIter treeIter = children.begin(); treeIter != children.end(); ++treeIter)
@@ -523,6 +659,8 @@ void CtTreeStore::get_node_data(const Gtk::TreeIter& treeIter, CtNodeData& nodeD
 void CtTreeStore::update_node_data(const Gtk::TreeIter& treeIter, const CtNodeData& nodeData)
 {
     Gtk::TreeRow row = *treeIter;
+    if (row.get_value(_columns.colNodeUniqueId) != nodeData.nodeId)
+        _nodesPathsStale = true;
     row[_columns.rColPixbuf] = _get_node_icon(_rTreeStore->iter_depth(treeIter), nodeData.syntax, nodeData.customIconId);
     row[_columns.colNodeName] = nodeData.name;
     row[_columns.rColTextBuffer] = nodeData.rTextBuffer;
@@ -543,6 +681,7 @@ void CtTreeStore::update_node_data(const Gtk::TreeIter& treeIter, const CtNodeDa
     update_node_aux_icon(treeIter);
     add_used_tags(nodeData.tags);
     _nodes_names_dict[nodeData.nodeId] = nodeData.name;
+    name_index_update_node(treeIter);
 }
 
 void CtTreeStore::update_node_icon(const Gtk::TreeIter& treeIter)
@@ -702,6 +841,10 @@ void CtTreeStore::apply_textbuffer_to_textview(const CtTreeIter& treeIter, CtTex
     _curr_node_sigc_conn.push_back(
         rTextBuffer->signal_erase().connect(sigc::mem_fun(*this, &CtTreeStore::_on_textbuffer_erase))
     );
+    for (sigc::connection& sigc_conn : _pCtMainWin->get_state_machine().track_node_buffer(node.get_node_id(), rTextBuffer))
+    {
+        _curr_node_sigc_conn.push_back(sigc_conn);
+    }
 }
 
 void CtTreeStore::addAnchoredWidgets(Gtk::TreeIter treeIter, std::list<CtAnchoredWidget*> anchoredWidgetList, Gtk::TextView* pTextView)
@@ -805,13 +948,21 @@ std::string CtTreeStore::get_node_name_from_node_id(const gint64 node_id)
 
 CtTreeIter CtTreeStore::get_node_from_node_id(const gint64 node_id)
 {
-    Gtk::TreeIter find_iter;
-    _rTreeStore->foreach_iter([&node_id, &find_iter, this](const Gtk::TreeIter& iter) {
-        if (iter->get_value(_columns.colNodeUniqueId) != node_id) return false; /* continue */
-        find_iter = iter;
-        return true;
-    });
-    return to_ct_tree_iter(find_iter);
+    if (_nodesPathsStale)
+    {
+        _nodesPaths.clear();
+        _rTreeStore->foreach([this](const Gtk::TreePath& path, const Gtk::TreeIter& iter) {
+            _nodesPaths[iter->get_value(_columns.colNodeUniqueId)] = path;
+            return false; /* continue */
+        });
+        _nodesPathsStale = false;
+    }
+    auto it = _nodesPaths.find(node_id);
+    if (it == _nodesPaths.end())
+    {
+        return to_ct_tree_iter(Gtk::TreeIter{});
+    }
+    return to_ct_tree_iter(_rTreeStore->get_iter(it->second));
 }
 
 CtTreeIter CtTreeStore::get_node_from_node_name(const Glib::ustring& node_name)
@@ -24,6 +24,7 @@
 #include <gtkmm.h>
 #include <gtksourceviewmm.h>
 #include <set>
+#include "ct_search_index.h"
 
 class CtMainWin;
 class CtAnchoredWidget;
@@ -184,9 +185,19 @@ public:
     void pending_rm_db_nodes(const std::vector<gint64>& node_ids);
     bool pending_data_write(const bool run_vacuum=false);
 
+    const CtTrigramIndex& get_search_index() { return _searchIndex; }
+    CtNodeNameIndex&      get_name_index() { return _nameIndex; }
+    void name_index_update_node(const Gtk::TreeIter& treeIter);
+    void search_index_invalidate_node(const gint64 node_id);
+    void search_index_remove_nodes(const std::vector<gint64>& node_ids);
+    bool search_index_update_missing();
+    void search_index_load(const std::string& doc_filepath);
+    void search_index_after_save(const std::string& doc_filepath, const bool persist);
+
 protected:
     Glib::RefPtr<Gdk::Pixbuf> _get_node_icon(int nodeDepth, const std::string &syntax, guint32 customIconId);
     void                      _iter_delete_anchored_widgets(const Gtk::TreeModel::Children& children);
+    void                      _search_index_update_node(CtTreeIter treeIter);
 
     void _on_textbuffer_modified_changed(Glib::RefPtr<Gtk::TextBuffer> rTextBuffer); // pygtk: on_modified_changed
     void _on_textbuffer_insert(const Gtk::TextBuffer::iterator& pos, const Glib::ustring& text, int bytes); // pygtk: on_text_insertion
@@ -197,7 +208,12 @@ protected:
     std::list<gint64>               _bookmarks;
     std::set<Glib::ustring>         _usedTags;
     std::map<gint64, Glib::ustring> _nodes_names_dict; // for link tooltips
+    std::unordered_map<gint64, Gtk::TreePath> _nodesPaths; // for the node id lookup
+    bool                            _nodesPathsStale{true}; // nodes added, moved, removed or given a new id
     std::list<sigc::connection>     _curr_node_sigc_conn;
+    CtTrigramIndex                  _searchIndex;
+    std::set<gint64>                _searchIndexDirtyNodes; // modified since the latest save, never filtered
+    CtNodeNameIndex                 _nameIndex;
     CtSQLite*                       _pCtSQLite{nullptr};
     CtMainWin*                      _pCtMainWin;
 };
@@ -201,7 +201,7 @@ void CtXmlRead::get_text_buffer_slot(Glib::RefPtr<Gsv::Buffer>& rTextBuffer,
                         timeStr = "0";
                     }
                     double timeDouble = std::stod(timeStr);
-                    pAnchoredWidget = new CtImageEmbFile(_pCtMainWin, fileName, rawBlob, timeDouble, charOffset, justification);
+                    pAnchoredWidget = new CtImageEmbFile(_pCtMainWin, fileName, std::make_shared<CtEmbFileBlob>(rawBlob), timeDouble, charOffset, justification);
                 }
                 else
                 {
@@ -216,7 +216,7 @@ void CtXmlRead::get_text_buffer_slot(Glib::RefPtr<Gsv::Buffer>& rTextBuffer,
             const int colMax = std::stoi(pNodeElement->get_attribute_value("col_max"));
             CtTableMatrix tableMatrix;
             const bool isHeadFront = populate_table_matrix_get_is_head_front(tableMatrix, pNodeElement);
-            pAnchoredWidget = new CtTable(_pCtMainWin, tableMatrix, colMin, colMax, isHeadFront, charOffset, justification);
+            pAnchoredWidget = new CtTable(_pCtMainWin, std::move(tableMatrix), colMin, colMax, isHeadFront, charOffset, justification);
         }
         else if (CtXmlNodeType::CodeBox == xmlNodeType)
         {
@@ -262,7 +262,7 @@ bool CtXmlRead::populate_table_matrix_get_is_head_front(CtTableMatrix& tableMatr
                 {
                     xmlpp::TextNode* pTextNode = static_cast<xmlpp::Element*>(pNodeCell)->get_child_text();
                     const Glib::ustring textContent = pTextNode ? pTextNode->get_content() : "";
-                    tableMatrix.back().push_back(new CtTableCell(_pCtMainWin, textContent, CtConst::TABLE_CELL_TEXT_ID));
+                    tableMatrix.back().push_back(textContent);
                 }
             }
         }
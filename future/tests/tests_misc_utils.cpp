@@ -21,6 +21,8 @@
 
 #include "ct_misc_utils.h"
 #include "ct_const.h"
+#include "ct_imports.h"
+#include <sstream>
 #include "CppUTest/CommandLineTestRunner.h"
 
 
@@ -172,6 +174,20 @@ TEST(MiscUtilsGroup, natural_compare)
     CHECK(CtStrUtil::natural_compare("Alpha 2 B","Alpha 2") > 0);
 }
 
+TEST(MiscUtilsGroup, natural_sort_key)
+{
+    const std::vector<std::pair<Glib::ustring, Glib::ustring>> pairs{
+        {"",""}, {"","a"}, {"","9"}, {"1","2"}, {"3","2"}, {"a1","a2"}, {"a1a2","a1a0"}, {"134","122"},
+        {"9","10"}, {"007","7"}, {"12a1","12a2"}, {"a","aa"}, {"a","1"}, {"Alpha 2","Alpha 2A"}, {"Alpha 2 B","Alpha 2"}};
+    for (const auto& pair : pairs)
+    {
+        const int cmpStrings = CtStrUtil::natural_compare(pair.first, pair.second);
+        const int cmpKeys = CtStrUtil::natural_sort_key(pair.first).compare(CtStrUtil::natural_sort_key(pair.second));
+        CHECK((cmpStrings < 0) == (cmpKeys < 0));
+        CHECK((cmpStrings == 0) == (cmpKeys == 0));
+    }
+}
+
 TEST(MiscUtilsGroup, str__endswith)
 {
     CHECK(str::endswith("", ""));
@@ -230,6 +246,30 @@ TEST(MiscUtilsGroup, str__repeat)
     STRCMP_EQUAL("******", str::repeat("**", 3).c_str());
 }
 
+TEST(MiscUtilsGroup, str__json_escape)
+{
+    STRCMP_EQUAL("plain \u00e8", str::json_escape("plain \u00e8").c_str());
+    STRCMP_EQUAL("say \\\"hi\\\" \\\\ \\n\\t", str::json_escape("say \"hi\" \\ \n\t").c_str());
+    STRCMP_EQUAL("\\u003c/script> \\u0001", str::json_escape("</script> \x01").c_str());
+}
+
+TEST(MiscUtilsGroup, csv_read_write)
+{
+    std::istringstream inStream("a,b\r\n\"x,\"\"y\"\"\",\n\n1,\"two\nlines\"");
+    std::vector<std::vector<Glib::ustring>> rows;
+    CtCSV::read_rows(inStream, [&rows](std::vector<Glib::ustring>& row){ rows.push_back(row); });
+    CHECK_EQUAL(3, rows.size());
+    CHECK(std::vector<Glib::ustring>({"a", "b"}) == rows[0]);
+    CHECK(std::vector<Glib::ustring>({"x,\"y\"", ""}) == rows[1]);
+    CHECK(std::vector<Glib::ustring>({"1", "two\nlines"}) == rows[2]);
+
+    std::ostringstream outStream;
+    CtCSV::write_field(outStream, "plain");
+    outStream << ',';
+    CtCSV::write_field(outStream, "x,\"y\"");
+    STRCMP_EQUAL("plain,\"x,\"\"y\"\"\"", outStream.str().c_str());
+}
+
 TEST(MiscUtilsGroup, vec_remove)
 {
     std::vector<int> empty_v;
@@ -242,6 +282,36 @@ TEST(MiscUtilsGroup, vec_remove)
     CHECK(v_3.size() == 2);
 }
 
+TEST(MiscUtilsGroup, get_web_links_offsets_from_plain_text)
+{
+    // offsets in chars with multibyte chars before and between the links
+    std::vector<std::pair<int, int>> expected{{5, 25}, {28, 37}, {40, 50}};
+    CHECK(expected == CtImports::get_web_links_offsets_from_plain_text("éé h http://example.com/à 日 www.a.b/c\nx ftp://host hhhhhhh"));
+    CHECK(CtImports::get_web_links_offsets_from_plain_text("http://").empty());
+    CHECK(CtImports::get_web_links_offsets_from_plain_text("").empty());
+
+    // multi-megabyte text, linear time
+    Glib::ustring line{"日本語 text https://cherrytree.org/x ftp\n"};
+    Glib::ustring big_text;
+    const int num_lines{100000};
+    for (int i = 0; i < num_lines; ++i)
+        big_text += line;
+    std::vector<std::pair<int, int>> web_links = CtImports::get_web_links_offsets_from_plain_text(big_text);
+    CHECK(num_lines == (int)web_links.size());
+    const int line_chars = (int)line.size();
+    CHECK(std::make_pair(9, 33) == web_links.front());
+    CHECK(std::make_pair((num_lines-1)*line_chars + 9, (num_lines-1)*line_chars + 33) == web_links.back());
+}
+
+TEST(MiscUtilsGroup, get_web_links_offsets_from_plain_text_edges)
+{
+    // links at the start and at the end of the text, a starter right after other letters
+    std::vector<std::pair<int, int>> expected{{0, 7}, {8, 19}, {26, 33}, {34, 45}};
+    CHECK(expected == CtImports::get_web_links_offsets_from_plain_text("www.a.b\nhttps://x.y ww wwwhttp:// https://end"));
+    // a starter within the last chars is too short to be a link
+    CHECK(CtImports::get_web_links_offsets_from_plain_text("ab www.x").empty());
+}
+
 int main(int ac, char** av)
 {
     // libp7za has memory leaks
@@ -0,0 +1,56 @@
+/*
+ * tests_print.cpp
+ *
+ * Copyright 2019-2020 Giuseppe Penone <giuspen@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_print.h"
+#include <glib/gstdio.h>
+#include "CppUTest/CommandLineTestRunner.h"
+
+
+TEST_GROUP(PrintGroup)
+{
+};
+
+TEST(PrintGroup, print_text_to_pdf)
+{
+    // the print context comes from gtk, which needs a display
+    if (not gtk_init_check(nullptr, nullptr))
+    {
+        UT_PRINT("no display, print to pdf not tested");
+        return;
+    }
+    Gtk::Main::init_gtkmm_internals();
+
+    // about 100 A4 pages of text
+    const int num_lines{7000};
+    Glib::ustring pango_text;
+    for (int i = 0; i < num_lines; ++i)
+        pango_text += "line " + std::to_string(i) + " of the synthetic document to paginate and print to pdf\n";
+    const std::string pdf_filepath = Glib::build_filename(Glib::get_tmp_dir(), "ct_tests_print.pdf");
+    (void)g_remove(pdf_filepath.c_str());
+
+    CtPrint ctPrint;
+    ctPrint.print_text(nullptr/*pCtMainWin*/, pdf_filepath, {pango_text}, "Sans 9", "Monospace 9", {}/*widgets*/, 800);
+
+    GStatBuf statBuf;
+    CHECK(0 == g_stat(pdf_filepath.c_str(), &statBuf));
+    CHECK(statBuf.st_size > 0);
+    (void)g_remove(pdf_filepath.c_str());
+}
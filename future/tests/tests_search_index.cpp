@@ -0,0 +1,90 @@
+/*
+ * tests_search_index.cpp
+ *
+ * Copyright 2019-2020 Giuseppe Penone <giuspen@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_search_index.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+
+TEST_GROUP(SearchIndexGroup)
+{
+};
+
+TEST(SearchIndexGroup, get_required_literals)
+{
+    const std::vector<std::string> fooBar{"foo", "bar"};
+    CHECK(fooBar == CtTrigramIndex::get_required_literals("foo.*bar"));
+    const std::vector<std::string> colour{"colo", "r"};
+    CHECK(colour == CtTrigramIndex::get_required_literals("colou?r"));
+    const std::vector<std::string> escaped{"hello.world"};
+    CHECK(escaped == CtTrigramIndex::get_required_literals("\\d+hello\\.world"));
+    const std::vector<std::string> groupClass{"ab", "efg"};
+    CHECK(groupClass == CtTrigramIndex::get_required_literals("ab(cd)?[x-z]efg"));
+    CHECK(CtTrigramIndex::get_required_literals("foo|bar").empty());
+    CHECK(CtTrigramIndex::get_required_literals("(?i)foo").empty());
+    CHECK(CtTrigramIndex::get_required_literals("\\x41bcd").empty());
+}
+
+TEST(SearchIndexGroup, get_candidates)
+{
+    CtTrigramIndex ctTrigramIndex;
+    ctTrigramIndex.set_node_text(1, "Hello World");
+    ctTrigramIndex.set_node_text(2, "another text");
+    ctTrigramIndex.append_node_text(2, "hello there");
+
+    const std::vector<CtTrigramIndex::Trigram> hello = CtTrigramIndex::get_required_trigrams("HELLO", false/*isRegExp*/, false/*matchCase*/);
+    CHECK_EQUAL(2, ctTrigramIndex.get_candidates(hello).size());
+    const std::vector<CtTrigramIndex::Trigram> world = CtTrigramIndex::get_required_trigrams("wo.ld", true/*isRegExp*/, true/*matchCase*/);
+    CHECK_EQUAL(0, world.size()); // no literal of three bytes
+    const std::vector<CtTrigramIndex::Trigram> there = CtTrigramIndex::get_required_trigrams("there", false/*isRegExp*/, true/*matchCase*/);
+    CHECK_EQUAL(1, ctTrigramIndex.get_candidates(there).size());
+
+    ctTrigramIndex.remove_node(2);
+    CHECK(not ctTrigramIndex.is_node_indexed(2));
+    CHECK_EQUAL(1, ctTrigramIndex.get_candidates(hello).size());
+    CHECK_EQUAL(0, ctTrigramIndex.get_candidates(there).size());
+}
+
+TEST(SearchIndexGroup, node_name_index_query)
+{
+    CtNodeNameIndex ctNodeNameIndex;
+    ctNodeNameIndex.set_node(1, 0, "Projects", "");
+    ctNodeNameIndex.set_node(2, 1, "cherrytree", "gtk notes");
+    ctNodeNameIndex.set_node(3, 1, "Tree Walker", "");
+    ctNodeNameIndex.set_node(4, 0, "Cherry", "");
+
+    std::vector<CtNodeNameIndex::Match> matches = ctNodeNameIndex.query("cher", 10);
+    CHECK_EQUAL(2, matches.size());
+    CHECK_EQUAL(4, matches[0].nodeId); // shorter prefix match first
+    // narrowed from the latest matches
+    matches = ctNodeNameIndex.query("cherryt", 10);
+    CHECK_EQUAL(1, matches.size());
+    CHECK_EQUAL(2, matches[0].nodeId);
+
+    CHECK_EQUAL(1, ctNodeNameIndex.query("notes", 10).size());
+    CHECK_EQUAL(2, ctNodeNameIndex.query("projects/", 10).size());
+    CHECK(CtNodeNameIndex::get_match_score("tree walker", "twk") > 0);
+    CHECK_EQUAL(0, CtNodeNameIndex::get_match_score("tree walker", "wt"));
+
+    ctNodeNameIndex.set_node(2, 4, "cherrytree", "");
+    CHECK(Glib::ustring{"Cherry / cherrytree"} == ctNodeNameIndex.get_node_path(2));
+    ctNodeNameIndex.remove_node(2);
+    CHECK_EQUAL(0, ctNodeNameIndex.query("cherryt", 10).size());
+}
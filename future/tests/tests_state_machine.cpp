@@ -0,0 +1,238 @@
+/*
+ * tests_state_machine.cpp
+ *
+ * Copyright 2019-2020 Giuseppe Penone <giuspen@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_state_machine.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+
+// text with the rich text tags of each character
+static std::string dump_buffer(Glib::RefPtr<Gtk::TextBuffer> rTextBuffer)
+{
+    std::string dump;
+    for (Gtk::TextIter iter = rTextBuffer->begin(); not iter.is_end(); iter.forward_char())
+    {
+        dump += Glib::ustring(1, iter.get_char()).raw();
+        for (const Glib::RefPtr<Gtk::TextTag>& rTextTag : iter.get_tags())
+            dump += "[" + rTextTag->property_name().get_value().raw() + "]";
+    }
+    return dump;
+}
+
+TEST_GROUP(StateMachineGroup)
+{
+    Glib::RefPtr<Gtk::TextBuffer> rTextBuffer;
+    std::vector<CtBufferOp> ops;
+    bool recording{true};
+
+    void setup()
+    {
+        Gtk::Main::init_gtkmm_internals();
+        rTextBuffer = Gtk::TextBuffer::create();
+        rTextBuffer->create_tag("weight_heavy");
+        rTextBuffer->create_tag("foreground_#ff0000");
+        rTextBuffer->set_text("hello world");
+        rTextBuffer->apply_tag_by_name("weight_heavy", rTextBuffer->get_iter_at_offset(6), rTextBuffer->end());
+
+        // recorded as by the state machine, before the default handlers
+        rTextBuffer->signal_insert().connect([this](const Gtk::TextIter& pos, const Glib::ustring& text, int /*bytes*/)
+        {
+            if (recording) CtStateMachine::record_insert(ops, pos, text);
+        }, false/*after*/);
+        rTextBuffer->signal_erase().connect([this](const Gtk::TextIter& range_start, const Gtk::TextIter& range_end)
+        {
+            if (recording) CtStateMachine::record_erase(ops, range_start, range_end);
+        }, false/*after*/);
+        rTextBuffer->signal_apply_tag().connect([this](const Glib::RefPtr<Gtk::TextTag>& rTextTag, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end)
+        {
+            if (recording) CtStateMachine::record_tag(ops, rTextTag, range_start, range_end, true/*apply*/);
+        }, false/*after*/);
+        rTextBuffer->signal_remove_tag().connect([this](const Glib::RefPtr<Gtk::TextTag>& rTextTag, const Gtk::TextIter& range_start, const Gtk::TextIter& range_end)
+        {
+            if (recording) CtStateMachine::record_tag(ops, rTextTag, range_start, range_end, false/*apply*/);
+        }, false/*after*/);
+    }
+
+    void teardown()
+    {
+        rTextBuffer.reset();
+        ops.clear();
+    }
+
+    void apply(const std::vector<CtBufferOp>& stepOps, bool forward)
+    {
+        recording = false;
+        CtStateMachine::apply_ops(rTextBuffer, stepOps, forward);
+        recording = true;
+    }
+};
+
+TEST(StateMachineGroup, apply_undo_redo_ops)
+{
+    const std::string dump_before = dump_buffer(rTextBuffer);
+
+    rTextBuffer->insert(rTextBuffer->get_iter_at_offset(5), " big");
+    rTextBuffer->apply_tag_by_name("foreground_#ff0000", rTextBuffer->begin(), rTextBuffer->get_iter_at_offset(5));
+    rTextBuffer->erase(rTextBuffer->begin(), rTextBuffer->get_iter_at_offset(6));
+    rTextBuffer->remove_tag_by_name("weight_heavy", rTextBuffer->begin(), rTextBuffer->end());
+    STRCMP_EQUAL("big world", rTextBuffer->get_text().c_str());
+    CHECK_EQUAL(4, ops.size());
+    const std::string dump_after = dump_buffer(rTextBuffer);
+
+    apply(ops, false/*forward*/);
+    STRCMP_EQUAL(dump_before.c_str(), dump_buffer(rTextBuffer).c_str());
+
+    apply(ops, true/*forward*/);
+    STRCMP_EQUAL(dump_after.c_str(), dump_buffer(rTextBuffer).c_str());
+
+    apply(ops, false/*forward*/);
+    STRCMP_EQUAL(dump_before.c_str(), dump_buffer(rTextBuffer).c_str());
+}
+
+TEST(StateMachineGroup, erased_text_gets_back_its_tags)
+{
+    const std::string dump_before = dump_buffer(rTextBuffer);
+
+    rTextBuffer->erase(rTextBuffer->get_iter_at_offset(3), rTextBuffer->get_iter_at_offset(9));
+    STRCMP_EQUAL("helld", rTextBuffer->get_text().c_str());
+    CHECK_EQUAL(1, ops.size());
+    CHECK(CtBufferOp::Type::Erase == ops[0].type);
+    CHECK_EQUAL(1, ops[0].tagRuns.size());
+    CHECK_EQUAL(6, ops[0].tagRuns[0].startOffset);
+    CHECK_EQUAL(9, ops[0].tagRuns[0].endOffset);
+
+    apply(ops, false/*forward*/);
+    STRCMP_EQUAL(dump_before.c_str(), dump_buffer(rTextBuffer).c_str());
+}
+
+TEST(StateMachineGroup, ops_that_cancel_out)
+{
+    // typing then backspacing all of it
+    for (const char* chars : {"a", "b", "c"})
+        rTextBuffer->insert(rTextBuffer->end(), chars);
+    CHECK_EQUAL(1, ops.size());
+    STRCMP_EQUAL("abc", ops[0].text.c_str());
+    for (int i = 0; i < 3; ++i)
+        rTextBuffer->erase(rTextBuffer->get_iter_at_offset(rTextBuffer->get_char_count() - 1), rTextBuffer->end());
+    CHECK_EQUAL(0, ops.size());
+
+    // a tag applied where it was not, then removed again
+    rTextBuffer->apply_tag_by_name("foreground_#ff0000", rTextBuffer->begin(), rTextBuffer->get_iter_at_offset(5));
+    rTextBuffer->remove_tag_by_name("foreground_#ff0000", rTextBuffer->begin(), rTextBuffer->get_iter_at_offset(5));
+    CHECK_EQUAL(0, ops.size());
+
+    // the tail of an insertion erased, the rest of it is kept
+    const std::string dump_before = dump_buffer(rTextBuffer);
+    rTextBuffer->insert(rTextBuffer->get_iter_at_offset(5), ", wide");
+    rTextBuffer->erase(rTextBuffer->get_iter_at_offset(7), rTextBuffer->get_iter_at_offset(11));
+    STRCMP_EQUAL("hello,  world", rTextBuffer->get_text().c_str());
+    CHECK_EQUAL(1, ops.size());
+    STRCMP_EQUAL(", ", ops[0].text.c_str());
+    const std::string dump_after = dump_buffer(rTextBuffer);
+
+    apply(ops, false/*forward*/);
+    STRCMP_EQUAL(dump_before.c_str(), dump_buffer(rTextBuffer).c_str());
+    apply(ops, true/*forward*/);
+    STRCMP_EQUAL(dump_after.c_str(), dump_buffer(rTextBuffer).c_str());
+}
+
+TEST(StateMachineGroup, trim_past_oldest_full_state)
+{
+    // the first step with a full state, then steps by operations only
+    CtNodeStates node_states;
+    node_states.steps.push_back(CtNodeStep{});
+    node_states.steps[0].snapshot = std::make_shared<CtNodeState>();
+    node_states.steps[0].snapshot->bufferXml = rTextBuffer->get_text();
+    const std::vector<std::pair<int, Glib::ustring>> insertions{{0, "one "}, {0, "two "}, {0, "three "}, {0, "four "}};
+    for (const auto& insertion : insertions)
+    {
+        rTextBuffer->insert(rTextBuffer->get_iter_at_offset(insertion.first), insertion.second);
+        CtNodeStep step;
+        step.byOps = true;
+        step.ops.swap(ops);
+        step.cursorPos = insertion.second.size();
+        node_states.steps.push_back(std::move(step));
+    }
+    const std::string dump_last = dump_buffer(rTextBuffer);
+
+    // two steps back, then the oldest ones trimmed
+    apply(node_states.steps[4].ops, false/*forward*/);
+    apply(node_states.steps[3].ops, false/*forward*/);
+    node_states.index = 2;
+    int snapshots_taken{0};
+    auto get_snapshot = [&]()
+    {
+        ++snapshots_taken;
+        auto snapshot = std::make_shared<CtNodeState>();
+        snapshot->bufferXml = rTextBuffer->get_text();
+        return snapshot;
+    };
+    CHECK(CtStateMachine::erase_oldest_steps(node_states, get_snapshot));
+    CHECK_EQUAL(1, snapshots_taken);
+    CHECK_EQUAL(3, node_states.steps.size());
+    CHECK_EQUAL(0, node_states.index);
+    CHECK(node_states.steps[0].snapshot);
+    STRCMP_EQUAL("two one hello world", node_states.steps[0].snapshot->bufferXml.c_str());
+    CHECK_EQUAL(4, node_states.steps[0].snapshot->cursor_pos);
+
+    // the current step is the oldest one now, the later ones are still replayed by their operations
+    CHECK_FALSE(CtStateMachine::erase_oldest_steps(node_states, get_snapshot));
+    apply(node_states.steps[1].ops, true/*forward*/);
+    apply(node_states.steps[2].ops, true/*forward*/);
+    STRCMP_EQUAL(dump_last.c_str(), dump_buffer(rTextBuffer).c_str());
+    CHECK_EQUAL(1, snapshots_taken);
+}
+
+TEST(StateMachineGroup, trim_up_to_next_full_state)
+{
+    CtNodeStates node_states;
+    for (int i = 0; i < 5; ++i)
+        node_states.steps.push_back(CtNodeStep{});
+    node_states.steps[0].snapshot = std::make_shared<CtNodeState>();
+    node_states.steps[2].snapshot = std::make_shared<CtNodeState>();
+    node_states.index = 4;
+    int snapshots_taken{0};
+    auto get_snapshot = [&](){ ++snapshots_taken; return std::make_shared<CtNodeState>(); };
+
+    CHECK(CtStateMachine::erase_oldest_steps(node_states, get_snapshot));
+    CHECK_EQUAL(0, snapshots_taken);
+    CHECK_EQUAL(3, node_states.steps.size());
+    CHECK_EQUAL(2, node_states.index);
+}
+
+TEST(StateMachineGroup, equal_blobs_pooled_once)
+{
+    // the blobs of two states, equal but read or created apart
+    auto rBlobState1 = CtStateBlobPool::get_blob(std::make_shared<CtEmbFileBlob>(std::string(1000, 'x')));
+    auto rBlobState2 = CtStateBlobPool::get_blob(std::make_shared<CtEmbFileBlob>(std::string(1000, 'x')));
+    auto rBlobOther = CtStateBlobPool::get_blob(std::make_shared<CtEmbFileBlob>(std::string(1000, 'y')));
+    CHECK(rBlobState1 == rBlobState2);
+    CHECK(rBlobState1 != rBlobOther);
+    CHECK(rBlobState1 == CtStateBlobPool::get_blob(rBlobState1));
+    CHECK_EQUAL(2000, CtStateBlobPool::get_memory_size());
+
+    rBlobOther.reset();
+    CtStateBlobPool::purge();
+    CHECK_EQUAL(1000, CtStateBlobPool::get_memory_size());
+    rBlobState1.reset();
+    rBlobState2.reset();
+    CtStateBlobPool::purge();
+    CHECK_EQUAL(0, CtStateBlobPool::get_memory_size());
+}
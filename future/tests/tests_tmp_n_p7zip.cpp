@@ -120,3 +120,24 @@ TEST(TmpP7zipGroup, P7zaExtravtWrongPasswd)
     CHECK_EQUAL(0, CtP7zaIface::p7za_extract(ctzInputPath.c_str(), ctTmp.getHiddenDirPath(ctzInputPath), testPassword, true/*dbg_print_cmd*/));
     CHECK_TRUE(Glib::file_test(ctdTmpPath, Glib::FILE_TEST_EXISTS));
 }
+
+TEST(TmpP7zipGroup, LzmaInMemory)
+{
+    std::string input;
+    for (int i = 0; i < 1000; ++i)
+    {
+        input += "<rich_text weight=\"heavy\">NodeContent " + std::to_string(i % 7) + "</rich_text>\n";
+    }
+    std::string compressed;
+    CHECK(CtP7zaIface::lzma_compress(input, compressed));
+    CHECK(compressed.size() < input.size()/10);
+    std::string decompressed;
+    CHECK(CtP7zaIface::lzma_decompress(compressed, decompressed));
+    CHECK(input == decompressed);
+
+    // empty input and truncated data
+    CHECK(CtP7zaIface::lzma_compress("", compressed));
+    CHECK(CtP7zaIface::lzma_decompress(compressed, decompressed));
+    CHECK(decompressed.empty());
+    CHECK_FALSE(CtP7zaIface::lzma_decompress("abc", decompressed));
+}
@@ -33,7 +33,51 @@ function collapseAllSubtrees(element){
 	}
 }
 
+function appendTreeNodes(parent, nodes, inPage){
+	for(var i=0; i<nodes.length; i++){
+		var node = nodes[i];
+		var li = document.createElement('li');
+		var a = document.createElement('a');
+		a.textContent = node.n;
+		if(inPage){
+			a.href = '#';
+			a.setAttribute('data-page', node.h);
+			a.onclick = function(){ changeFrame(this.getAttribute('data-page')); return false; };
+		}else{
+			a.href = node.h;
+		}
+		parent.appendChild(li);
+		if(node.c){
+			var button = document.createElement('button');
+			button.textContent = '-';
+			button.onclick = function(){ toggleSubTree(this); };
+			li.appendChild(button);
+			li.appendChild(document.createTextNode(' '));
+			li.appendChild(a);
+			var subtree = document.createElement('ul');
+			subtree.className = 'subtree';
+			appendTreeNodes(subtree, node.c, inPage);
+			parent.appendChild(subtree);
+		}else{
+			li.className = 'leaf';
+			li.appendChild(a);
+		}
+	}
+}
+
+function buildTreeIndex(){
+	var outermost = document.getElementById("tree_index");
+	if(outermost === null || typeof treeIndex === 'undefined'){
+		return;
+	}
+	var inPage = document.getElementById("page_frame") !== null;
+	var fragment = document.createDocumentFragment();
+	appendTreeNodes(fragment, treeIndex, inPage);
+	outermost.appendChild(fragment);
+}
+
 window.onload = function(){ 
+	buildTreeIndex();
 	var show_page = window.location.hash.substr(1);
 	if (show_page !== '') {
 		changeFrame(show_page);